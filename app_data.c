@@ -15,6 +15,8 @@
 #include "contexts/params.h"
 #include <threads.h>
 static thread_local bool is_audio_thread = false;
+//remove the control change mappings to the parameters of the context, defined with the midi learn functions
+static int app_midi_learn_forget_cx(APP_INFO* app_data, unsigned char cx_type, int cx_id);
 
 //the client name that will be shown in the audio client and added next to the port names
 const char* client_name = "smp_grvbox";
@@ -36,6 +38,13 @@ typedef struct _app_info{
     void* main_in_R;
     void* main_out_L;
     void* main_out_R;
+    //midi input for the midi learn control changes
+    void* main_midi_in;
+    //the midi learn table, which parameter each control change on each channel sets, check app_cc_target_pack for the layout
+    //written on [main-thread] when removing mappings and on [audio-thread] when learning, each slot is one atomic so it is never half written
+    _Atomic(uint64_t) cc_map[MIDI_CHANNELS][MIDI_CC_NUM];
+    //the parameter that waits for a control change to be mapped to, 0 if no parameter is learning
+    _Atomic(uint64_t) cc_learn;
     //control struct for sys messages between [audio-thread] and [main-thread] (stop all processes and send messages for this context)
     CXCONTROL* control_data;
     unsigned int is_processing; //is the main jack function processing, should be touched only on [audio-thread]
@@ -103,7 +112,11 @@ APP_INFO* app_init(app_status_t *app_status){
     app_data->clap_plug_data = NULL;
     app_data->synth_data = NULL;
     app_data->is_processing = 0;
-    
+    app_data->main_midi_in = NULL;
+    for(int ch = 0; ch < MIDI_CHANNELS; ch++){
+	for(int cc = 0; cc < MIDI_CC_NUM; cc++)atomic_init(&app_data->cc_map[ch][cc], 0);
+    }
+    atomic_init(&app_data->cc_learn, 0);
     /*init jack client for the whole program*/
     /*--------------------------------------------------*/   
     app_data->trk_jack = jack_initialize(app_data, client_name, 0, 0, 0, NULL, trk_audio_process_rt, 0);
@@ -120,6 +133,7 @@ APP_INFO* app_init(app_status_t *app_status){
     app_data->main_in_R = app_jack_create_port_on_client(app_data->trk_jack, 0, 1, "master_in_R");
     app_data->main_out_L = app_jack_create_port_on_client(app_data->trk_jack, 0, 2, "master_out_L");
     app_data->main_out_R = app_jack_create_port_on_client(app_data->trk_jack, 0, 2, "master_out_R");
+    app_data->main_midi_in = app_jack_create_port_on_client(app_data->trk_jack, TYPE_MIDI, 1, "master_midi_in");
     //now activate the jack client, it will launch the rt thread (trk_audio_process_rt function)
     //but app_data->is_processing == 0, so the contexts will not be processed, only app_data sys messages (to start the processes for example)
     if(app_jack_activate(app_data->trk_jack) != 0){
@@ -298,7 +312,10 @@ int app_plug_load_preset(APP_INFO* app_data, const char* preset_uri, unsigned in
 }
 
 int app_plug_init_plugin(APP_INFO* app_data, const char* plugin_uri, unsigned char cx_type, const int id){
+    if(!app_data)return -1;
     if(!plugin_uri)return -1;
+    //a plugin loaded on an existing id replaces the plugin there, its control change mappings do not belong to the new plugin
+    if(id >= 0)app_midi_learn_forget_cx(app_data, cx_type, id);
     if(cx_type == Context_type_Plugins)
 	return plug_load_and_activate(app_data->plug_data, plugin_uri, id);
     if(cx_type == Context_type_Clap_Plugins)
@@ -309,11 +326,18 @@ int app_plug_init_plugin(APP_INFO* app_data, const char* plugin_uri, unsigned ch
 int app_smp_sample_init(APP_INFO* app_data, const char* samp_path, int in_id){
     if(!samp_path)return -1;
     if(!app_data)return -1;
+    //a sample loaded on an existing id replaces the sample there with new parameters
+    if(in_id >= 0)app_midi_learn_forget_cx(app_data, Context_type_Sampler, in_id);
     int return_id = -1;
     return_id = smp_add(app_data->smp_data, samp_path, in_id);
     return return_id;
 }
 
+int app_synth_osc_init(APP_INFO* app_data, int in_id){
+    if(!app_data)return -1;
+    return synth_add_osc(app_data->synth_data, in_id);
+}
+
 static PRM_CONTAIN* app_get_context_param_container(APP_INFO* app_data, unsigned char cx_type, int cx_id){
     if(!app_data)return NULL;
     if(cx_type == Context_type_Trk){
@@ -334,6 +358,27 @@ static PRM_CONTAIN* app_get_context_param_container(APP_INFO* app_data, unsigned
     return NULL;
 }
 
+//same as app_get_context_param_container but for [audio-thread], returns NULL for contexts that are not processing
+//the [main-thread] frees or replaces a container only after its context stopped processing, so the returned one is valid for this cycle
+static PRM_CONTAIN* app_get_context_param_container_rt(APP_INFO* app_data, unsigned char cx_type, int cx_id){
+    if(cx_type == Context_type_Trk){
+	return app_jack_param_return_param_container(app_data->trk_jack);
+    }
+    if(cx_type == Context_type_Sampler){
+	return smp_param_return_param_container(app_data->smp_data, cx_id);
+    }
+    if(cx_type == Context_type_Synth){
+	return synth_param_return_param_container_rt(app_data->synth_data, cx_id);
+    }
+    if(cx_type == Context_type_Plugins){
+	return plug_param_return_param_container_rt(app_data->plug_data, cx_id);
+    }
+    if(cx_type == Context_type_Clap_Plugins){
+	return clap_plug_param_return_param_container_rt(app_data->clap_plug_data, cx_id);
+    }
+    return NULL;
+}
+
 int app_param_set_value(APP_INFO* app_data, unsigned char cx_type, int cx_id, int param_id, PARAM_T param_value, unsigned char param_op){
     if(!app_data)return -1;
     PRM_CONTAIN* param_cont = app_get_context_param_container(app_data, cx_type, cx_id);
@@ -376,6 +421,13 @@ unsigned int app_param_get_value_as_string(APP_INFO* app_data, unsigned char cx_
     return param_get_value_as_string(param_cont, param_id, ret_string, string_len);
 }
 
+const char* app_param_get_value_string(APP_INFO* app_data, unsigned char cx_type, int cx_id, int param_id){
+    if(!app_data)return NULL;
+    PRM_CONTAIN* param_cont = app_get_context_param_container(app_data, cx_type, cx_id);
+    if(!param_cont)return NULL;
+    return param_get_value_string(param_cont, param_id);
+}
+
 int app_param_return_all_as_string(APP_INFO* app_data, unsigned char cx_type, int cx_id, char*** param_names, char*** param_vals, unsigned int* param_num){
     if(!app_data)return -1;
     *param_num = 0;
@@ -465,6 +517,14 @@ char* app_return_cx_name(APP_INFO* app_data, unsigned char cx_type, int cx_id, u
 	ret_name = clap_plug_return_plugin_name(app_data->clap_plug_data, cx_id);
 	app_make_name_from_file_cx_id(app_data, &ret_name, cx_id, add_id);
     }
+    //return the name of the synth oscillator
+    if(cx_type == Context_type_Synth){
+	const char* osc_name = synth_return_osc_name(app_data->synth_data, cx_id);
+	if(osc_name){
+	    ret_name = (char*)malloc(sizeof(char) * (strlen(osc_name) + 1));
+	    if(ret_name)strcpy(ret_name, osc_name);
+	}
+    }
     return ret_name;
 }
 
@@ -523,6 +583,100 @@ static int app_read_rt_messages(APP_INFO* app_data){
     return 0;
 }
 
+//pack the parameter a control change is mapped to into one midi learn table slot
+//bit 63 is set for used slots, bits 48-55 are the cx_type, 32-47 the cx_id and 0-31 the param_id
+static uint64_t app_cc_target_pack(unsigned char cx_type, int cx_id, int param_id){
+    uint64_t target = (uint64_t)1 << 63;
+    target |= (uint64_t)cx_type << 48;
+    target |= (uint64_t)(uint16_t)cx_id << 32;
+    target |= (uint64_t)(uint32_t)param_id;
+    return target;
+}
+
+//set the parameters mapped with midi learn from the control changes on main_midi_in, use only on [audio-thread]
+static void app_midi_cc_process_rt(APP_INFO* app_data, NFRAMES_T nframes){
+    if(!app_data->main_midi_in)return;
+    const JACK_MIDI_CONT* midi_cont = app_jack_midi_bus_return_rt(app_data->trk_jack, app_data->main_midi_in);
+    if(!midi_cont)return;
+    for(unsigned int ev = 0; ev < midi_cont->num_events; ev++){
+	const JACK_MIDI_EVENT* event = &(midi_cont->events[ev]);
+	if((event->status & 0xf0) != 0xb0)continue;
+	unsigned int channel = event->status & 0x0f;
+	unsigned int cc = event->data[0] & 0x7f;
+	//a parameter is waiting for a control change, this one is mapped to it
+	//the mapping is written before the learn is taken, so a forget on [main-thread] that clears the learn first
+	//either makes the take fail here or scans the table after the mapping is already in it
+	uint64_t learn = atomic_load(&app_data->cc_learn);
+	if(learn != 0){
+	    uint64_t old_target = atomic_exchange(&app_data->cc_map[channel][cc], learn);
+	    uint64_t expected = learn;
+	    if(!atomic_compare_exchange_strong(&app_data->cc_learn, &expected, 0)){
+		//the learn was forgotten, canceled or changed in the meantime, put back what was there if the forget did not clear it already
+		uint64_t cur_target = learn;
+		atomic_compare_exchange_strong(&app_data->cc_map[channel][cc], &cur_target, old_target);
+	    }
+	}
+	uint64_t target = atomic_load(&app_data->cc_map[channel][cc]);
+	if(target == 0)continue;
+	unsigned char cx_type = (unsigned char)((target >> 48) & 0xff);
+	int cx_id = (int)(int16_t)((target >> 32) & 0xffff);
+	int param_id = (int)(uint32_t)(target & 0xffffffff);
+	PRM_CONTAIN* param_cont = app_get_context_param_container_rt(app_data, cx_type, cx_id);
+	if(!param_cont)continue;
+	param_set_value_normalized(param_cont, param_id, (PARAM_T)(event->data[1] & 0x7f) / 127.0, 1);
+    }
+}
+
+int app_midi_learn_start(APP_INFO* app_data, unsigned char cx_type, int cx_id, int param_id){
+    if(!app_data)return -1;
+    if(param_id < 0)return -1;
+    if(!app_get_context_param_container(app_data, cx_type, cx_id))return -1;
+    atomic_store(&app_data->cc_learn, app_cc_target_pack(cx_type, cx_id, param_id));
+    return 0;
+}
+
+void app_midi_learn_cancel(APP_INFO* app_data){
+    if(!app_data)return;
+    atomic_store(&app_data->cc_learn, 0);
+}
+
+int app_midi_learn_is_waiting(APP_INFO* app_data, unsigned char cx_type, int cx_id, int param_id){
+    if(!app_data)return 0;
+    if(param_id < 0)return 0;
+    return (atomic_load(&app_data->cc_learn) == app_cc_target_pack(cx_type, cx_id, param_id));
+}
+
+//remove the control change mappings whose target masked with target_mask is target, also stops waiting for a control change if the learn target matches
+//returns how many mappings were removed
+static int app_midi_learn_forget_masked(APP_INFO* app_data, uint64_t target, uint64_t target_mask){
+    if(!app_data)return -1;
+    uint64_t learn = atomic_load(&app_data->cc_learn);
+    if(learn != 0 && (learn & target_mask) == target)atomic_compare_exchange_strong(&app_data->cc_learn, &learn, 0);
+    int removed = 0;
+    for(int ch = 0; ch < MIDI_CHANNELS; ch++){
+	for(int cc = 0; cc < MIDI_CC_NUM; cc++){
+	    uint64_t expected = atomic_load(&app_data->cc_map[ch][cc]);
+	    if(expected == 0 || (expected & target_mask) != target)continue;
+	    //the [audio-thread] could learn a new mapping to this slot at the same time, that one is kept
+	    if(atomic_compare_exchange_strong(&app_data->cc_map[ch][cc], &expected, 0))removed += 1;
+	}
+    }
+    return removed;
+}
+
+int app_midi_learn_forget(APP_INFO* app_data, unsigned char cx_type, int cx_id, int param_id){
+    if(!app_data)return -1;
+    if(param_id < 0)return -1;
+    return app_midi_learn_forget_masked(app_data, app_cc_target_pack(cx_type, cx_id, param_id), ~(uint64_t)0);
+}
+
+//remove all the control change mappings to the parameters of the context, so they do not control whatever is loaded to the same cx_id later
+static int app_midi_learn_forget_cx(APP_INFO* app_data, unsigned char cx_type, int cx_id){
+    //the param_id is in the lower 32 bits of the target, the mask leaves it out
+    uint64_t cx_mask = ~(uint64_t)0xffffffff;
+    return app_midi_learn_forget_masked(app_data, app_cc_target_pack(cx_type, cx_id, 0) & cx_mask, cx_mask);
+}
+
 int trk_audio_process_rt(NFRAMES_T nframes, void *arg){   
     //get the app data
     APP_INFO *app_data = (APP_INFO*)arg;
@@ -535,6 +689,12 @@ int trk_audio_process_rt(NFRAMES_T nframes, void *arg){
     int read_err = app_read_rt_messages(app_data);
     if(read_err == 1)return 0;
     if(read_err == -1)return -1;
+    //decode all the midi inputs once, the contexts read the decoded events from the midi bus
+    app_jack_midi_bus_process_rt(app_data->trk_jack, nframes);
+    //take the transport position once, all the contexts read the same snapshot
+    app_jack_transport_process_rt(app_data->trk_jack, nframes);
+    //the midi learn control changes are set before the contexts process, so they are heard in this cycle
+    app_midi_cc_process_rt(app_data, nframes);
     
     //process the SAMPLER DATA
     smp_sample_process_rt(app_data->smp_data, nframes);    
@@ -582,15 +742,26 @@ int app_update_ui_params(APP_INFO* app_data){
 }
 
 int app_subcontext_remove(APP_INFO* app_data, unsigned char cx_type, int id){
+    return app_subcontexts_remove(app_data, cx_type, &id, 1);
+}
+
+int app_subcontexts_remove(APP_INFO* app_data, unsigned char cx_type, const int* ids, unsigned int num_ids){
     if(!app_data)return -1;
+    if(!ids)return -1;
+    for(unsigned int i = 0; i < num_ids; i++){
+	app_midi_learn_forget_cx(app_data, cx_type, ids[i]);
+    }
     if(cx_type == Context_type_Clap_Plugins){
-	clap_plug_plug_stop_and_clean(app_data->clap_plug_data, id);
+	clap_plug_plugs_stop_and_clean(app_data->clap_plug_data, ids, num_ids);
     }
     if(cx_type == Context_type_Plugins){
-	plug_stop_and_remove_plug(app_data->plug_data, id);
+	plug_stop_and_remove_plugs(app_data->plug_data, ids, num_ids);
     }
     if(cx_type == Context_type_Sampler){
-	smp_stop_and_remove_sample(app_data->smp_data, id);
+	smp_stop_and_remove_samples(app_data->smp_data, ids, num_ids);
+    }
+    if(cx_type == Context_type_Synth){
+	synth_stop_and_remove_oscs(app_data->synth_data, ids, num_ids);
     }
     return 0;
 }
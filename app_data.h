@@ -56,6 +56,9 @@ int app_plug_load_preset(APP_INFO* app_data, const char* preset_uri, unsigned in
 int app_plug_init_plugin(APP_INFO* app_data, const char* plugin_uri, unsigned char cx_type, const int id);
 //initialize a sample on sampler context
 int app_smp_sample_init(APP_INFO* app_data, const char* samp_path, int in_id);
+//initialize an oscillator on the synth context, if in_id == -1 the first empty oscillator slot is used
+//if succesfull returns the id of the oscillator
+int app_synth_osc_init(APP_INFO* app_data, int in_id);
 //call appropriate cx_type context function to set parameter value
 int app_param_set_value(APP_INFO* app_data, unsigned char cx_type, int cx_id, int param_id, PARAM_T param_value, unsigned char param_op);
 //return the parameter increment amount (by how much the value increases or decreases)
@@ -66,8 +69,21 @@ PARAM_T app_param_get_value(APP_INFO* app_data, unsigned char cx_type, int cx_id
 int app_param_get_ui_name(APP_INFO* app_data, unsigned char cx_type, int cx_id, int param_id, char* name, uint32_t name_len);
 //get the parameter id given the context type, cx id and parameter id. Returns -1 if no such parameter is found
 int app_param_id_from_name(APP_INFO* app_data, unsigned char cx_type, int cx_id, const char* param_name);
+//midi learn, the next control change that comes to the master_midi_in port will set this parameter, use on [main-thread]
+//the control change value 0..127 is scaled to the parameter range on the [audio-thread]
+int app_midi_learn_start(APP_INFO* app_data, unsigned char cx_type, int cx_id, int param_id);
+//stop waiting for a control change for the parameter given to app_midi_learn_start
+void app_midi_learn_cancel(APP_INFO* app_data);
+//return 1 if this parameter is waiting for a control change after app_midi_learn_start, 0 otherwise
+int app_midi_learn_is_waiting(APP_INFO* app_data, unsigned char cx_type, int cx_id, int param_id);
+//remove all the control change mappings to this parameter, returns how many were removed
+//if the parameter is waiting for a control change it stops waiting too
+//the mappings of a context are removed on their own when the context is removed or replaced
+int app_midi_learn_forget(APP_INFO* app_data, unsigned char cx_type, int cx_id, int param_id);
 //get the parameter value formated as ret_string to display to the ui
 unsigned int app_param_get_value_as_string(APP_INFO* app_data, unsigned char cx_type, int cx_id, int param_id, char* ret_string, uint32_t string_len);
+//return the cached parameter value string to display to the ui, it is formatted again only when the value changes, NULL on error
+const char* app_param_get_value_string(APP_INFO* app_data, unsigned char cx_type, int cx_id, int param_id);
 //returns all the parameters values and names to the param_names, param_vals. User has to free these arrays
 //if the current name is NULL something went wrong.
 int app_param_return_all_as_string(APP_INFO* app_data, unsigned char cx_type, int cx_id, char*** param_names, char*** param_vals, unsigned int* param_num);
@@ -93,7 +109,10 @@ int trk_audio_process_rt(jack_nframes_t nframes, void *arg);
 int app_update_ui_params(APP_INFO* app_data);
 //realtime callback for the plugin host data, as always only _rt functions inside
 int plug_audio_process_rt(NFRAMES_T nframes, void *arg);
-//remove subcontext, plugin, clap plugin or sample
+//remove subcontext, plugin, clap plugin, sample or synth oscillator
+//does not block the [main-thread], the subcontext is freed in app_update_ui_params after the [audio-thread] stopped it
 int app_subcontext_remove(APP_INFO* app_data, unsigned char cx_type, int id);
+//remove num_ids subcontexts of the same cx_type, the [audio-thread] stops them all in the same cycle and they are freed in app_update_ui_params
+int app_subcontexts_remove(APP_INFO* app_data, unsigned char cx_type, const int* ids, unsigned int num_ids);
 //pause the [audio-thread] processing with a mutex and clean memory of the app_data
 int app_stop_and_clean(APP_INFO *app_data);
@@ -415,6 +415,12 @@ static CX *cx_init_cx_type(APP_INTRF *app_intrf, const char* parent_string, cons
             }
 	}	
 	if(type == (Main_cx_e | Synth_cx_st)){
+	    //button to add a new oscillator
+            if(!cx_init_cx_type(app_intrf, ret_node->name, "add_osc", (Button_cx_e | AddList_cx_st),
+				(const char*[1]){"07"}, (const char*[1]){"uchar_val"}, 1)){
+		cx_remove_this_and_children(ret_node);
+		return NULL;
+            }
 	    //load the oscillators with their names
 	    int osc_num = 0;
 	    const char** osc_names = app_context_return_names(app_intrf->app_data, Context_type_Synth, &osc_num);
@@ -446,15 +452,29 @@ static CX *cx_init_cx_type(APP_INTRF *app_intrf, const char* parent_string, cons
 	if(attrib_size>0){
 	    cx_osc->id = str_find_value_to_int(type_attrib_names, type_attribs, "id", attrib_size);
 	}
-	if(cx_osc->id < 0){
+	//create the oscillator on the synth, if the oscillator already exists its id will be returned
+	int osc_id = app_synth_osc_init(app_intrf->app_data, cx_osc->id);
+	if(osc_id < 0){
 	    free(cx_osc);
 	    return NULL;
 	}
-	//add the osc to the cx array
-        if(cx_add_child(parent, ret_node, name, type)<0){
+	cx_osc->id = osc_id;
+	int child_add_err = -1;
+	//get the name of the oscillator from the synth
+	char* osc_name = app_return_cx_name(app_intrf->app_data, Context_type_Synth, osc_id, 0);
+	if(osc_name){
+	    child_add_err = cx_add_child(parent, ret_node, osc_name, type);
+	    free(osc_name);
+	}
+        if(child_add_err<0){
+	    app_subcontext_remove(app_intrf->app_data, Context_type_Synth, osc_id);
             free(cx_osc);
             return NULL;
         }
+	if(!cx_init_cx_type(app_intrf, ret_node->name, "remove", (Button_cx_e | Remove_cx_st), NULL, NULL,0)){
+	    cx_remove_this_and_children(ret_node);
+	    return NULL;
+	}
 	//initialize the parameters for this Oscillator, also check the parameters user configuration file
 	if(helper_cx_create_cx_for_default_params(app_intrf, ret_node, "Synth_param_conf.json", Context_type_Synth, cx_osc->id)<0){
 	    cx_remove_this_and_children(ret_node);
@@ -1305,6 +1325,11 @@ static void cx_enter_item_callback(APP_INTRF* app_intrf, CX* self){
 	    cx_init_cx_type(app_intrf, self->parent->parent->name, "Plug", plug_type,
 			    (const char*[2]){f_path, "1"}, (const char*[2]){"plug_path", "init"}, 2);
 	}
+	if(cx_addList->uchar_val == addOsc_purp){
+	    //create the cx_osc, the oscillator on the synth will be created in cx_init_cx_type
+	    cx_init_cx_type(app_intrf, self->parent->parent->name, "Osc", Osc_cx_e,
+			    (const char*[1]){"-1"}, (const char*[1]){"id"}, 1);
+	}
 	//if its a button to load a song or a preset
 	if(cx_addList->uchar_val == Load_purp){
 	    if((self->parent->parent->type & 0xff00) == Main_cx_e){
@@ -1475,6 +1500,11 @@ static void cx_enter_AddList_callback(APP_INTRF *app_intrf, CX* self){
     //if this list is already filled do not fill it again (when filled it will have more children, when empty -
     //only the cancel button. This is useful for AddList_cx_st that lets choose files
     if(self->child->sib)goto finish;
+    //the list to add a new oscillator to the synth has only one item
+    if(cx_addList->uchar_val == addOsc_purp){
+	cx_init_cx_type(app_intrf, self->name, "new_osc", (Button_cx_e | Item_cx_st),
+			(const char*[1]){"new_osc"}, (const char*[1]){"str_val"}, 1);
+    }
     //create a sample from file if the parent type is Sample_cx_e
     if(cx_addList->uchar_val == Sample_purp){
 	if(app_intrf->shared_dir!=NULL)
@@ -1777,6 +1807,34 @@ unsigned int nav_get_cx_value_as_string(APP_INTRF* app_intrf, CX* sel_cx, char*
     return app_param_get_value_as_string(app_intrf->app_data, param_cx->cx_type, param_cx->cx_id, param_cx->val_id, ret_string, name_len);
 }
 
+int nav_midi_learn_cx(APP_INTRF* app_intrf, CX* select_cx){
+    if(!app_intrf)return -1;
+    if(select_cx==NULL)return -1;
+    if(select_cx->type != Val_cx_e)return -1;
+    CX_VAL* param_cx = (CX_VAL*) select_cx;
+    //the parameter is already waiting for a control change, stop waiting
+    if(app_midi_learn_is_waiting(app_intrf->app_data, param_cx->cx_type, param_cx->cx_id, param_cx->val_id)){
+	app_midi_learn_cancel(app_intrf->app_data);
+	return 0;
+    }
+    return app_midi_learn_start(app_intrf->app_data, param_cx->cx_type, param_cx->cx_id, param_cx->val_id);
+}
+
+int nav_midi_forget_cx(APP_INTRF* app_intrf, CX* select_cx){
+    if(!app_intrf)return -1;
+    if(select_cx==NULL)return -1;
+    if(select_cx->type != Val_cx_e)return -1;
+    CX_VAL* param_cx = (CX_VAL*) select_cx;
+    return app_midi_learn_forget(app_intrf->app_data, param_cx->cx_type, param_cx->cx_id, param_cx->val_id);
+}
+
+const char* nav_get_cx_value_string(APP_INTRF* app_intrf, CX* sel_cx){
+    if(sel_cx==NULL)return NULL;
+    if(sel_cx->type != Val_cx_e)return NULL;
+    CX_VAL* param_cx = (CX_VAL*) sel_cx;
+    return app_param_get_value_string(app_intrf->app_data, param_cx->cx_type, param_cx->cx_id, param_cx->val_id);
+}
+
 int nav_set_cx_value(APP_INTRF* app_intrf, CX* select_cx, int set_to){
     if(!select_cx){
         return -1;
@@ -2010,6 +2068,11 @@ static int helper_cx_remove_cx_and_data(APP_INTRF* app_intrf, CX* rem_cx){
 	    context_type = Context_type_Clap_Plugins;
 	}
     }
+    if((rem_cx->type & 0xff00) == Osc_cx_e){
+	CX_OSC* cx_osc = (CX_OSC*)rem_cx;
+	cx_id = cx_osc->id;
+	context_type = Context_type_Synth;
+    }
     app_subcontext_remove(app_intrf->app_data, context_type, cx_id);
     cx_remove_this_and_children(rem_cx);
     
@@ -94,7 +94,9 @@ enum IntrfPurposeType{
     //list of available midi output ports
     MIDIPorts_purp = 0x05,    
     //list of available presets for a Plugin_cx_e
-    Load_plugin_preset_purp = 0x06
+    Load_plugin_preset_purp = 0x06,
+    //list with an item to add a new oscillator to the synth
+    addOsc_purp = 0x07
 };
 
 typedef enum IntrfStatus intrf_status_t;
@@ -262,6 +264,13 @@ CX* nav_ret_curr_cx(APP_INTRF* app_intrf);
 CX* nav_ret_select_cx(APP_INTRF* app_intrf);
 //get the value on cx Val_cx_e as a string, ret_string has to be name_len size, if the value string is longer the value will be cut
 unsigned int nav_get_cx_value_as_string(APP_INTRF* app_intrf, CX* sel_cx, char* ret_string, uint32_t name_len);
+//midi learn the parameter of the cx Val_cx_e, the next midi control change on the master midi input will control this parameter
+//if the parameter is already waiting for a control change, it stops waiting instead
+int nav_midi_learn_cx(APP_INTRF* app_intrf, CX* select_cx);
+//remove the midi control changes mapped to the parameter of the cx Val_cx_e, returns how many were removed
+int nav_midi_forget_cx(APP_INTRF* app_intrf, CX* select_cx);
+//get the value on cx Val_cx_e as a string kept by the parameter, it changes only when the value changes so the ui does not have to format it on every refresh
+const char* nav_get_cx_value_string(APP_INTRF* app_intrf, CX* sel_cx);
 //set the value of the selected cx - this will be a Button_cx_e that will increment or lower the apropriate
 //value of its parent cx (set_to<0 decrease the value, set_to>0 - increase the value).
 //though set_to is int, the actual value on the parameter will be float, the context will convert this value
@@ -0,0 +1,193 @@
+/*
+Benchmark for the RING_BUFFER in util_funcs/ring_buffer.c against the zix ring that jalv uses (util_funcs/jalv/zix/ring.c).
+A writer thread sends numbered messages the size of a parameter message to a reader thread through each ring,
+one item at a time and in batches, and the time is reported in ns per item. The reader checks the numbers so a broken ring fails the case.
+Build with make ring_bench and run from the build directory.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include "../util_funcs/ring_buffer.h"
+#include "../util_funcs/jalv/zix/ring.h"
+
+//how many items go through the ring in each case
+#define BENCH_ITEMS 20000000
+//how many items the ring holds
+#define BENCH_RING_ITEMS 1024
+//the biggest batch size
+#define BENCH_MAX_BATCH 64
+
+//the ring kinds that are measured
+enum benchRingType{
+    Bench_Ring_Single = 0,
+    Bench_Ring_Batch = 1,
+    Bench_Zix_Ring = 2
+};
+
+//the benchmark message, the same size as a parameter message
+typedef struct _bench_msg{
+    uint64_t seq;
+    uint64_t payload;
+}BENCH_MSG;
+
+//one benchmark case, shared by the writer and the reader threads
+typedef struct _bench_case{
+    unsigned int ring_type;
+    unsigned int batch;
+    RING_BUFFER* ring;
+    ZixRing* zix;
+    //how many items the reader got out of order, should be 0
+    uint64_t errors;
+}BENCH_CASE;
+
+static double bench_time_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000000000.0 + (double)ts.tv_nsec;
+}
+
+//write up to count messages starting from seq, returns how many were written
+static unsigned int bench_write(BENCH_CASE* bench, uint64_t seq, unsigned int count){
+    BENCH_MSG msgs[BENCH_MAX_BATCH];
+    for(unsigned int i = 0; i < count; i++){
+	msgs[i].seq = seq + i;
+	msgs[i].payload = (seq + i) * 3;
+    }
+    if(bench->ring_type == Bench_Ring_Single){
+	unsigned int written = 0;
+	for(; written < count; written++){
+	    if(ring_buffer_write(bench->ring, &msgs[written], sizeof(BENCH_MSG)) != 1)break;
+	}
+	return written;
+    }
+    if(bench->ring_type == Bench_Ring_Batch){
+	int written = ring_buffer_write_batch(bench->ring, msgs, sizeof(BENCH_MSG), count);
+	if(written < 0)return 0;
+	return (unsigned int)written;
+    }
+    //the zix ring counts in bytes, so only whole messages are written
+    uint32_t space = zix_ring_write_space(bench->zix) / sizeof(BENCH_MSG);
+    if(space < count)count = space;
+    if(count == 0)return 0;
+    if(bench->batch == 1){
+	unsigned int written = 0;
+	for(; written < count; written++){
+	    if(zix_ring_write(bench->zix, &msgs[written], sizeof(BENCH_MSG)) != sizeof(BENCH_MSG))break;
+	}
+	return written;
+    }
+    return zix_ring_write(bench->zix, msgs, count * sizeof(BENCH_MSG)) / sizeof(BENCH_MSG);
+}
+//read up to count messages to msgs, returns how many were read
+static unsigned int bench_read(BENCH_CASE* bench, BENCH_MSG* msgs, unsigned int count){
+    if(bench->ring_type == Bench_Ring_Single){
+	unsigned int read = 0;
+	for(; read < count; read++){
+	    if(ring_buffer_read(bench->ring, &msgs[read], sizeof(BENCH_MSG)) != 1)break;
+	}
+	return read;
+    }
+    if(bench->ring_type == Bench_Ring_Batch){
+	int read = ring_buffer_read_batch(bench->ring, msgs, sizeof(BENCH_MSG), count);
+	if(read < 0)return 0;
+	return (unsigned int)read;
+    }
+    uint32_t space = zix_ring_read_space(bench->zix) / sizeof(BENCH_MSG);
+    if(space < count)count = space;
+    if(count == 0)return 0;
+    if(bench->batch == 1){
+	unsigned int read = 0;
+	for(; read < count; read++){
+	    if(zix_ring_read(bench->zix, &msgs[read], sizeof(BENCH_MSG)) != sizeof(BENCH_MSG))break;
+	}
+	return read;
+    }
+    return zix_ring_read(bench->zix, msgs, count * sizeof(BENCH_MSG)) / sizeof(BENCH_MSG);
+}
+
+static void* bench_writer_thread(void* arg){
+    BENCH_CASE* bench = (BENCH_CASE*)arg;
+    uint64_t seq = 0;
+    while(seq < BENCH_ITEMS){
+	unsigned int count = bench->batch;
+	if(BENCH_ITEMS - seq < count)count = (unsigned int)(BENCH_ITEMS - seq);
+	unsigned int written = bench_write(bench, seq, count);
+	//let the reader run if there is only one core
+	if(written == 0)sched_yield();
+	seq += written;
+    }
+    return NULL;
+}
+
+static void* bench_reader_thread(void* arg){
+    BENCH_CASE* bench = (BENCH_CASE*)arg;
+    BENCH_MSG msgs[BENCH_MAX_BATCH];
+    uint64_t seq = 0;
+    while(seq < BENCH_ITEMS){
+	unsigned int read = bench_read(bench, msgs, bench->batch);
+	for(unsigned int i = 0; i < read; i++){
+	    if(msgs[i].seq != seq + i || msgs[i].payload != (seq + i) * 3)bench->errors += 1;
+	}
+	if(read == 0)sched_yield();
+	seq += read;
+    }
+    return NULL;
+}
+
+//run one benchmark case, returns the ns per item or -1 on error
+static double bench_run_case(unsigned int ring_type, unsigned int batch){
+    BENCH_CASE bench;
+    memset(&bench, '\0', sizeof(BENCH_CASE));
+    bench.ring_type = ring_type;
+    bench.batch = batch;
+    if(ring_type == Bench_Zix_Ring){
+	bench.zix = zix_ring_new(NULL, BENCH_RING_ITEMS * sizeof(BENCH_MSG));
+	if(!bench.zix)return -1;
+    }
+    else{
+	bench.ring = ring_buffer_init(sizeof(BENCH_MSG), BENCH_RING_ITEMS);
+	if(!bench.ring)return -1;
+    }
+    pthread_t writer;
+    pthread_t reader;
+    double start = bench_time_ns();
+    if(pthread_create(&reader, NULL, bench_reader_thread, &bench) != 0){
+	if(bench.ring)ring_buffer_clean(bench.ring);
+	if(bench.zix)zix_ring_free(bench.zix);
+	return -1;
+    }
+    if(pthread_create(&writer, NULL, bench_writer_thread, &bench) != 0){
+	//the reader would wait forever, so stop here
+	fprintf(stderr, "could not start the writer thread\n");
+	exit(1);
+    }
+    pthread_join(writer, NULL);
+    pthread_join(reader, NULL);
+    double end = bench_time_ns();
+    if(bench.ring)ring_buffer_clean(bench.ring);
+    if(bench.zix)zix_ring_free(bench.zix);
+    if(bench.errors > 0)return -1;
+    return (end - start) / (double)BENCH_ITEMS;
+}
+
+int main(int argc, char** argv){
+    unsigned int batches[] = {1, 8, 32, BENCH_MAX_BATCH};
+    const char* ring_names[] = {"ring", "ring_batch", "zix"};
+    printf("%-12s %-8s %s\n", "ring", "batch", "ns/item");
+    for(unsigned int r = 0; r < 3; r++){
+	for(unsigned int b = 0; b < sizeof(batches)/sizeof(batches[0]); b++){
+	    double ns = bench_run_case(r, batches[b]);
+	    if(ns < 0){
+		printf("%-12s %-8u failed\n", ring_names[r], batches[b]);
+		continue;
+	    }
+	    printf("%-12s %-8u %.2f\n", ring_names[r], batches[b], ns);
+	    fflush(stdout);
+	}
+    }
+    return 0;
+}
@@ -0,0 +1,273 @@
+/*
+Headless benchmark for the synth context.
+The synth is initialized with synth_init, but instead of jack this file implements the app_jack functions that the synth uses
+(the fake audio backend). synth_process_rt is then driven with scripted midi (pads, chords and arpeggios) at several buffer sizes
+and voice counts and the time is reported in ns per frame per voice.
+Build with make synth_bench and run from the build directory.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../contexts/synth.h"
+#include "../contexts/params.h"
+#include "../jack_funcs/jack_funcs.h"
+#include "../types.h"
+
+//the samplerate the benchmark runs at
+#define BENCH_SAMPLERATE 48000
+//how many seconds of audio each benchmark case renders
+#define BENCH_SECONDS 4
+//how many seconds of audio to render before the time is measured
+#define BENCH_WARMUP_SECONDS 1
+//the maximum number of ports on the fake backend
+#define BENCH_MAX_PORTS 128
+//the maximum number of scripted midi events in one cycle
+#define BENCH_MAX_EVENTS 64
+//the oscillator that gets the scripted midi
+#define BENCH_OSC_NAME "Osc_1"
+
+//a midi event in the fake backend midi port
+typedef struct _bench_midi_ev{
+    NFRAMES_T frame;
+    MIDI_DATA_T type;
+    MIDI_DATA_T note;
+    MIDI_DATA_T vel;
+}BENCH_MIDI_EV;
+
+//port of the fake backend, audio ports have a buffer, midi ports have the events
+typedef struct _bench_port{
+    char* name;
+    unsigned int port_type;
+    unsigned int port_flow;
+    SAMPLE_T* buffer;
+    BENCH_MIDI_EV events[BENCH_MAX_EVENTS];
+    unsigned int num_events;
+    //the events decoded for the midi bus
+    JACK_MIDI_EVENT decoded[BENCH_MAX_EVENTS];
+    JACK_MIDI_CONT midi_cont;
+}BENCH_PORT;
+
+//the fake audio backend, given to synth_init instead of the jack client
+typedef struct _bench_backend{
+    BENCH_PORT* ports[BENCH_MAX_PORTS];
+    unsigned int buffer_size;
+    //the frame of the cycle that is processed now, the clock of the fake backend
+    uint32_t cycle_frame;
+}BENCH_BACKEND;
+
+//the scripted midi patterns
+enum BenchScriptType{
+    //all the voices start at the first frame and are held
+    Bench_script_pads = 0,
+    //a new chord of all the voices every half a second
+    Bench_script_chords = 1,
+    //a new note every 1/32 of a second, each note is held until voices newer notes played
+    Bench_script_arp = 2
+};
+
+/*the fake audio backend functions*/
+/*-------------------------------------------------------------------*/
+void* app_jack_create_port_on_client(void* client_in, unsigned int port_type, unsigned int io_type, const char* port_name){
+    BENCH_BACKEND* backend = (BENCH_BACKEND*)client_in;
+    if(!backend)return NULL;
+    for(int i = 0; i < BENCH_MAX_PORTS; i++){
+	if(backend->ports[i])continue;
+	BENCH_PORT* port = calloc(1, sizeof(BENCH_PORT));
+	if(!port)return NULL;
+	port->port_type = port_type;
+	port->port_flow = io_type;
+	port->name = malloc(sizeof(char) * (strlen(port_name) + 1));
+	if(port->name)strcpy(port->name, port_name);
+	port->buffer = calloc(backend->buffer_size, sizeof(SAMPLE_T));
+	backend->ports[i] = port;
+	return port;
+    }
+    return NULL;
+}
+
+void app_jack_unregister_port(void* client, void* port){
+    BENCH_BACKEND* backend = (BENCH_BACKEND*)client;
+    if(!backend || !port)return;
+    for(int i = 0; i < BENCH_MAX_PORTS; i++){
+	if(backend->ports[i] != port)continue;
+	if(backend->ports[i]->name)free(backend->ports[i]->name);
+	if(backend->ports[i]->buffer)free(backend->ports[i]->buffer);
+	free(backend->ports[i]);
+	backend->ports[i] = NULL;
+    }
+}
+
+void* app_jack_get_buffer_rt(void* port, jack_nframes_t nframes){
+    BENCH_PORT* bench_port = (BENCH_PORT*)port;
+    if(!bench_port)return NULL;
+    if(bench_port->port_type == TYPE_MIDI)return bench_port;
+    return bench_port->buffer;
+}
+
+void app_jack_return_notes_vels_rt(void* midi_in, JACK_MIDI_CONT* midi_cont){
+    BENCH_PORT* port = (BENCH_PORT*)midi_in;
+    if(!port || !midi_cont)return;
+    for(unsigned int i = 0; i < port->num_events; i++){
+	if(midi_cont->num_events >= midi_cont->array_size)break;
+	BENCH_MIDI_EV* ev = &(port->events[i]);
+	JACK_MIDI_EVENT* event = &(midi_cont->events[midi_cont->num_events]);
+	event->frame = ev->frame;
+	event->size = 3;
+	event->status = ev->type;
+	event->data[0] = ev->note;
+	event->data[1] = ev->vel;
+	event->buffer = NULL;
+	midi_cont->num_events += 1;
+    }
+}
+
+//the transport is stopped, so the metronome only costs its stopped voices
+const JACK_TRANSPORT_SNAP* app_jack_return_transport_snap_rt(void* audio_client){
+    static const JACK_TRANSPORT_SNAP stopped_transport = {0};
+    return &stopped_transport;
+}
+
+//the benchmark is single threaded, so the current frame is the cycle frame
+uint32_t app_jack_frame_time(void* audio_client){
+    BENCH_BACKEND* backend = (BENCH_BACKEND*)audio_client;
+    if(!backend)return 0;
+    return backend->cycle_frame;
+}
+
+uint32_t app_jack_last_frame_time_rt(void* audio_client){
+    BENCH_BACKEND* backend = (BENCH_BACKEND*)audio_client;
+    if(!backend)return 0;
+    return backend->cycle_frame;
+}
+
+void app_jack_midi_cont_reset(JACK_MIDI_CONT* midi_cont){
+    if(!midi_cont)return;
+    midi_cont->num_events = 0;
+}
+
+//each midi port has one reader in the benchmark, so the port is decoded when the synth asks for it
+const JACK_MIDI_CONT* app_jack_midi_bus_return_rt(void* audio_client, void* port){
+    BENCH_PORT* bench_port = (BENCH_PORT*)port;
+    if(!bench_port || bench_port->port_type != TYPE_MIDI)return NULL;
+    bench_port->midi_cont.events = bench_port->decoded;
+    bench_port->midi_cont.array_size = BENCH_MAX_EVENTS;
+    app_jack_midi_cont_reset(&bench_port->midi_cont);
+    app_jack_return_notes_vels_rt(bench_port, &bench_port->midi_cont);
+    return &bench_port->midi_cont;
+}
+/*-------------------------------------------------------------------*/
+
+//find the midi in port of the oscillator that gets the scripted midi
+static BENCH_PORT* bench_find_midi_port(BENCH_BACKEND* backend){
+    for(int i = 0; i < BENCH_MAX_PORTS; i++){
+	BENCH_PORT* port = backend->ports[i];
+	if(!port)continue;
+	if(port->port_type != TYPE_MIDI)continue;
+	if(!port->name)continue;
+	if(strstr(port->name, BENCH_OSC_NAME "|midi_in"))return port;
+    }
+    return NULL;
+}
+
+static void bench_add_event(BENCH_PORT* port, NFRAMES_T frame, MIDI_DATA_T type, MIDI_DATA_T note, MIDI_DATA_T vel){
+    if(port->num_events >= BENCH_MAX_EVENTS)return;
+    BENCH_MIDI_EV* ev = &(port->events[port->num_events]);
+    ev->frame = frame;
+    ev->type = type;
+    ev->note = note;
+    ev->vel = vel;
+    port->num_events += 1;
+}
+
+//write the scripted midi events that fall in this cycle to the port
+//the synth reads only one event per frame, so the notes of a chord are put on consecutive frames
+static void bench_script_cycle(BENCH_PORT* port, unsigned int script, unsigned int voices, unsigned long cycle_start, unsigned int nframes){
+    port->num_events = 0;
+    unsigned long step_frames = BENCH_SAMPLERATE / 2;
+    if(script == Bench_script_arp)step_frames = BENCH_SAMPLERATE / 32;
+    for(unsigned int j = 0; j < nframes; j++){
+	unsigned long frame = cycle_start + j;
+	if(script == Bench_script_pads){
+	    if(frame < voices)bench_add_event(port, j, 0x90, 48 + frame * 3, 100);
+	    continue;
+	}
+	unsigned long step = frame / step_frames;
+	unsigned long step_frame = frame % step_frames;
+	if(script == Bench_script_chords){
+	    //first stop the old chord and then start the new chord
+	    if(step > 0 && step_frame < voices)bench_add_event(port, j, 0x80, 48 + (step_frame * 3) + ((step - 1) % 2) * 5, 0);
+	    if(step_frame >= voices && step_frame < voices * 2)bench_add_event(port, j, 0x90, 48 + ((step_frame - voices) * 3) + (step % 2) * 5, 100);
+	}
+	if(script == Bench_script_arp){
+	    if(step >= voices && step_frame == 0)bench_add_event(port, j, 0x80, 48 + ((step - voices) % 24), 0);
+	    if(step_frame == 1)bench_add_event(port, j, 0x90, 48 + (step % 24), 100);
+	}
+    }
+}
+
+static double bench_time_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000000000.0 + (double)ts.tv_nsec;
+}
+
+//run one benchmark case, returns the ns per frame per voice or -1 on error
+static double bench_run_case(unsigned int buffer_size, unsigned int script, unsigned int voices, unsigned int unison){
+    BENCH_BACKEND backend;
+    memset(&backend, '\0', sizeof(BENCH_BACKEND));
+    backend.buffer_size = buffer_size;
+    SYNTH_DATA* synth_data = synth_init(buffer_size, BENCH_SAMPLERATE, "Synth", 1, &backend);
+    if(!synth_data)return -1;
+    BENCH_PORT* midi_port = bench_find_midi_port(&backend);
+    if(!midi_port){
+	synth_clean_memory(synth_data);
+	return -1;
+    }
+    //the benchmark is single threaded, so the [audio-thread] parameters can be set directly
+    PRM_CONTAIN* params = synth_param_return_param_container(synth_data, 1);
+    int uni_id = param_find_name(params, "Unison", 1);
+    if(uni_id >= 0)param_set_value(params, uni_id, unison, NULL, Operation_SetValue, 1);
+
+    unsigned long warmup_cycles = (BENCH_SAMPLERATE * BENCH_WARMUP_SECONDS) / buffer_size;
+    unsigned long cycles = (BENCH_SAMPLERATE * BENCH_SECONDS) / buffer_size;
+    unsigned long frame = 0;
+    double total_ns = 0;
+    for(unsigned long cycle = 0; cycle < warmup_cycles + cycles; cycle++){
+	bench_script_cycle(midi_port, script, voices, frame, buffer_size);
+	backend.cycle_frame = (uint32_t)frame;
+	double start = bench_time_ns();
+	synth_process_rt(synth_data, buffer_size);
+	double end = bench_time_ns();
+	if(cycle >= warmup_cycles)total_ns += end - start;
+	frame += buffer_size;
+    }
+    synth_clean_memory(synth_data);
+    for(int i = 0; i < BENCH_MAX_PORTS; i++){
+	if(backend.ports[i])app_jack_unregister_port(&backend, backend.ports[i]);
+    }
+    return total_ns / ((double)(cycles * buffer_size) * (double)voices);
+}
+
+int main(int argc, char** argv){
+    unsigned int buffer_sizes[] = {64, 256, 1024};
+    unsigned int voice_counts[] = {1, 4, 8};
+    unsigned int unisons[] = {1, 7};
+    const char* script_names[] = {"pads", "chords", "arp"};
+    printf("%-8s %-8s %-7s %-8s %s\n", "script", "buffer", "voices", "unison", "ns/frame/voice");
+    for(unsigned int s = 0; s < 3; s++){
+	for(unsigned int b = 0; b < sizeof(buffer_sizes)/sizeof(buffer_sizes[0]); b++){
+	    for(unsigned int v = 0; v < sizeof(voice_counts)/sizeof(voice_counts[0]); v++){
+		for(unsigned int u = 0; u < sizeof(unisons)/sizeof(unisons[0]); u++){
+		    double ns = bench_run_case(buffer_sizes[b], s, voice_counts[v], unisons[u]);
+		    if(ns < 0){
+			printf("%-8s %-8u %-7u %-8u failed\n", script_names[s], buffer_sizes[b], voice_counts[v], unisons[u]);
+			continue;
+		    }
+		    printf("%-8s %-8u %-7u %-8u %.2f\n", script_names[s], buffer_sizes[b], voice_counts[v], unisons[u], ns);
+		}
+	    }
+	}
+    }
+    return 0;
+}
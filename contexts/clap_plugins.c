@@ -56,11 +56,12 @@ typedef struct _clap_plug_note_port{
     clap_id* ids;
     uint32_t* supported_dialects;
     uint32_t* preferred_dialects;
-    JACK_MIDI_CONT* midi_cont;
 }CLAP_PLUG_NOTE_PORT;
 //the single clap plugin struct
 typedef struct _clap_plug_plug{
     int id; //plugin id on the clap_plug_info plugin array
+    unsigned int remove_pending; //1 while the removal of this plugin is submitted to the [audio-thread], touch only on [main-thread]
+    unsigned int generation; //grows each time the slot is cleaned, so the done function of a removal can tell if the slot holds another plugin now, touch only on [main-thread]
     char plugin_id[MAX_UNIQUE_ID_STRING]; //unique plugin id that is from the clap_plugin_descriptor. Used rarely (now to match if preset container from preset-factory is can be used with the plugin)
     clap_plugin_entry_t* plug_entry; //the clap library file for this plugin
     const clap_plugin_t* plug_inst; //the plugin instance
@@ -99,6 +100,8 @@ typedef struct _clap_plug_info{
     clap_host_t clap_host_info;
     //control_data struct that handles the sys messages between [audio-thread] and [main-thread] (stop plugin, start plugin, etc.)
     CXCONTROL* control_data;
+    //the parameter messages of all the plugins go through these rings
+    PRM_RINGS* param_rings;
     //from here hold various host extension implementation structs
     clap_host_thread_check_t ext_thread_check; //struct that holds functions to check if the thread is main or audio
     clap_host_log_t ext_log; //struct that holds function for logging messages (severity is not sent)
@@ -340,11 +343,6 @@ static int clap_plug_note_ports_destroy(CLAP_PLUG_INFO* plug_data, CLAP_PLUG_NOT
     note_port->ports_count = 0;
     if(note_port->sys_ports)free(note_port->sys_ports);
     note_port->sys_ports = NULL;
-    if(note_port->midi_cont){
-	app_jack_clean_midi_cont(note_port->midi_cont);
-	free(note_port->midi_cont);
-	note_port->midi_cont = NULL;
-    }
     return 0;
 }
 //create note_ports
@@ -366,7 +364,6 @@ static int clap_plug_note_ports_create(CLAP_PLUG_INFO* plug_data, int id, bool i
     CLAP_PLUG_NOTE_PORT* note_port = &(plug->output_note_ports);
     if(input_ports)note_port = &(plug->input_note_ports);
 
-    note_port->midi_cont = app_jack_init_midi_cont(MAX_MIDI_CONT_ITEMS);
     note_port->sys_ports = calloc(clap_ports_count, sizeof(void*));
     note_port->ports_count = clap_ports_count;
     note_port->ids = calloc(clap_ports_count, sizeof(clap_id));
@@ -502,7 +499,7 @@ static int clap_plug_params_create(CLAP_PLUG_INFO* plug_data, int id){
     container_user_data.user_data = (void*)plug;
     container_user_data.val_to_string = clap_plug_params_value_to_text;
     plug->plug_params = params_init_param_container(param_count, param_names, param_vals, param_mins, param_maxs, param_incs, val_types,
-						    user_data_array, &container_user_data);
+						    user_data_array, &container_user_data, plug_data->param_rings);
 
     for(uint32_t i = 0; i < param_count; i++){
 	if(param_names[i])free(param_names[i]);
@@ -524,6 +521,14 @@ PRM_CONTAIN* clap_plug_param_return_param_container(CLAP_PLUG_INFO* plug_data, i
 
     return plug->plug_params;
 }
+PRM_CONTAIN* clap_plug_param_return_param_container_rt(CLAP_PLUG_INFO* plug_data, int plug_id){
+    if(!plug_data)return NULL;
+    if(plug_id >= MAX_INSTANCES || plug_id < 0)return NULL;
+    CLAP_PLUG_PLUG* plug = &(plug_data->plugins[plug_id]);
+    //the params are created and destroyed only when the plugin is stopped, a sleeping plugin still uses them
+    if(plug->plug_inst_processing == 0)return NULL;
+    return plug->plug_params;
+}
 static void clap_plug_ext_params_rescan(const clap_host_t* host, clap_param_rescan_flags flags){
     if(is_audio_thread)return;
     CLAP_PLUG_PLUG* plug = (CLAP_PLUG_PLUG*)host->host_data;
@@ -532,21 +537,25 @@ static void clap_plug_ext_params_rescan(const clap_host_t* host, clap_param_resc
     CLAP_PLUG_INFO* plug_data = plug->plug_data;
     if(!plug_data)return;
     if((flags & CLAP_PARAM_RESCAN_VALUES) == CLAP_PARAM_RESCAN_VALUES){
-	//go through the params and simply set the values
+	//go through the params and set the values, the values are sent all at once so a preset with many parameters does not overflow the rings
 	const clap_plugin_params_t* clap_params = plug->plug_inst->get_extension(plug->plug_inst, CLAP_EXT_PARAMS);
 	if(!clap_params)return;
+	PRM_SNAPSHOT* snapshot = param_snapshot_init(plug->plug_params);
+	if(!snapshot)return;
 	uint32_t param_count = (uint32_t)param_return_num_params(plug->plug_params, 0);
 	for(uint32_t param_num = 0; param_num < param_count; param_num++){
 	    clap_param_info_t param_info;
 	    if(!clap_params->get_info(plug->plug_inst, param_num, &param_info))continue;
 	    double cur_value = 0;
 	    if(!clap_params->get_value(plug->plug_inst, param_info.id, &cur_value))continue;
-	    param_set_value(plug->plug_params, param_num, (PARAM_T)cur_value, NULL, Operation_SetValue, 0);
+	    param_snapshot_set_value(snapshot, param_num, (PARAM_T)cur_value);
 	}
+	param_snapshot_publish(plug->plug_params, snapshot);
     }
     if((flags & CLAP_PARAM_RESCAN_TEXT) == CLAP_PARAM_RESCAN_TEXT){
 	context_sub_send_msg(plug_data->control_data, (void*)plug_data, is_audio_thread, "Plugin %s requested CLAP_PARAM_RESCAN_TEXT\n", plug->plug_path);
-	//TODO not sure what clap api expects here, if the text needs to be rendered again it will do so automaticaly on the next ui cycle
+	//the values are the same but value_to_text would give a different text now, so the cached value strings have to be made again
+	param_value_strings_invalidate(plug->plug_params);
     }
     if((flags & CLAP_PARAM_RESCAN_INFO) == CLAP_PARAM_RESCAN_INFO){
 	//go through the params and change the ui_names
@@ -701,6 +710,9 @@ static int clap_plug_plug_clean(CLAP_PLUG_INFO* plug_data, int plug_id){
     if(plug_id < 0)return -1;
     if(plug_id >= MAX_INSTANCES)return -1;
     CLAP_PLUG_PLUG* plug = &(plug_data->plugins[plug_id]);
+    //the slot is cleaned now, a removal that is still submitted should not clean it again
+    plug->remove_pending = 0;
+    plug->generation += 1;
       
     if(plug->plug_inst){
 	if(plug->plug_inst_activated == 1){
@@ -758,6 +770,32 @@ int clap_plug_plug_stop_and_clean(CLAP_PLUG_INFO* plug_data, int plug_id){
     return clap_plug_plug_clean(plug_data, plug_id);
 }
 
+//called on [main-thread] when the [audio-thread] stopped the plugin, if the slot was not cleaned in the meantime clean the plugin
+static void clap_plug_plug_clean_done(void* done_data, void* user_data, unsigned int generation, int result){
+    CLAP_PLUG_INFO* plug_data = (CLAP_PLUG_INFO*)done_data;
+    CLAP_PLUG_PLUG* slot = (CLAP_PLUG_PLUG*)user_data;
+    if(!plug_data || !slot)return;
+    //the slot was cleaned after the removal was submitted, it could hold a new plugin with its own removal on the way
+    if(slot->generation != generation)return;
+    clap_plug_plug_clean(plug_data, slot->id);
+}
+
+//mark the removal of the plugin as pending for context_sub_stop_and_remove, skip the plugins that are being removed already
+static int clap_plug_plug_clean_claim(void* user_data, unsigned int* generation){
+    CLAP_PLUG_PLUG* slot = (CLAP_PLUG_PLUG*)user_data;
+    if(slot->remove_pending == 1)return -1;
+    slot->remove_pending = 1;
+    *generation = slot->generation;
+    return 0;
+}
+
+int clap_plug_plugs_stop_and_clean(CLAP_PLUG_INFO* plug_data, const int* ids, unsigned int num_ids){
+    if(!plug_data || !ids)return -1;
+    //the plugins are stopped in the same [audio-thread] cycle and removed when the done functions are called
+    return context_sub_stop_and_remove(plug_data->control_data, (void*)plug_data->plugins, sizeof(CLAP_PLUG_PLUG), MAX_INSTANCES, ids, num_ids,
+				       clap_plug_plug_clean_claim, clap_plug_plug_clean_done, (void*)plug_data);
+}
+
 //return if this is audio_thread or not
 static bool clap_plug_return_is_audio_thread(){
     return is_audio_thread;
@@ -819,9 +857,7 @@ static int clap_plug_activate_start_processing(void* user_data){
     if(!plug)return -1;
     CLAP_PLUG_INFO* plug_data = plug->plug_data;
     if(!plug_data)return -1;
-    //since there was a request to start processing the plugin, it should be stopped, but just in case, send a request to stop it
-    context_sub_wait_for_stop(plug_data->control_data, (void*)plug);
-    
+    //a plugin that is not activated is not processing, every path that deactivates the plugin stops it first
     if(plug->plug_inst_activated == 0){
 	if(!plug->plug_inst)return -1;
 	if(!plug->plug_inst->activate(plug->plug_inst, plug_data->sample_rate, plug_data->min_buffer_size, plug_data->max_buffer_size)){
@@ -829,9 +865,9 @@ static int clap_plug_activate_start_processing(void* user_data){
 	}
     }
     plug->plug_inst_activated = 1;
-    //send message to the audio thread that the plugin can be started to process
-    //and wait for it to start
-    context_sub_wait_for_start(plug_data->control_data, (void*)plug);
+    //since there was a request to start processing the plugin, it should be stopped, but just in case (it could be sleeping) stop it first
+    //the stop and the start are applied in the same [audio-thread] cycle, without waiting for it
+    context_sub_start(plug_data->control_data, (void*)plug, 1);
 
     return 0;
 }
@@ -932,25 +968,16 @@ int clap_read_ui_to_rt_messages(CLAP_PLUG_INFO* plug_data){
     //process the sys messages (stop, start plugin and similar)
     context_sub_process_rt(plug_data->control_data);
     
-    //read the param messages for plugins on the [audio-thread]
-    for(unsigned int i = 0; i < MAX_INSTANCES; i++){
-	CLAP_PLUG_PLUG* cur_plug = &(plug_data->plugins[i]);
-	if(cur_plug->plug_inst_processing == 0)continue;
-	if(!cur_plug->plug_inst)continue;
-	param_msgs_process(cur_plug->plug_params, 1);
-    }
+    //read the param messages for all the plugins on the [audio-thread]
+    param_msgs_process(plug_data->param_rings, 1);
     return 0;
 }
 int clap_read_rt_to_ui_messages(CLAP_PLUG_INFO* plug_data){
     if(!plug_data)return -1;
     //process the sys messages on [main-thread] (send msg, activate and process a plugin, restart plugin etc.)
     context_sub_process_ui(plug_data->control_data);
-    //read the param messages for plugins on the [main-thread]
-    for(unsigned int i = 0; i < MAX_INSTANCES; i++){
-	CLAP_PLUG_PLUG* cur_plug = &(plug_data->plugins[i]);
-	if(!cur_plug->plug_inst)continue;
-	param_msgs_process(cur_plug->plug_params, 0);
-    }    
+    //read the param messages for all the plugins on the [main-thread]
+    param_msgs_process(plug_data->param_rings, 0);
     return 0;
 }
 
@@ -1248,6 +1275,13 @@ CLAP_PLUG_INFO* clap_plug_init(uint32_t min_buffer_size, uint32_t max_buffer_siz
 	*plug_error = clap_plug_failed_malloc;
 	return NULL;
     }
+    plug_data->param_rings = params_init_param_rings(app_jack_frame_time, audio_backend);
+    if(!plug_data->param_rings){
+	context_sub_clean(plug_data->control_data);
+	free(plug_data);
+	*plug_error = clap_plug_failed_malloc;
+	return NULL;
+    }
     plug_data->min_buffer_size = min_buffer_size;
     plug_data->max_buffer_size = max_buffer_size;
     plug_data->sample_rate = samplerate;
@@ -1295,6 +1329,8 @@ CLAP_PLUG_INFO* clap_plug_init(uint32_t min_buffer_size, uint32_t max_buffer_siz
         CLAP_PLUG_PLUG* plug = &(plug_data->plugins[i]);
 	plug->clap_host_info = clap_info_host;
 	plug->id = i;
+	plug->remove_pending = 0;
+	plug->generation = 0;
 	plug->plug_data = plug_data;
 	plug->plug_entry = NULL;
 	plug->plug_inst = NULL;
@@ -1443,8 +1479,9 @@ int clap_plug_load_and_activate(CLAP_PLUG_INFO* plug_data, const char* plugin_na
     }
     //if the id is still not within range an error happened, cant create the plugin
     if(id < 0 || id >= MAX_INSTANCES)return -1;
-    //if id is in the possible range, clean the slot just in case its occupied 
-    clap_plug_plug_stop_and_clean(plug_data, id);
+    //if id is in the possible range, clean the slot if its occupied, an empty slot is not processing so there is nothing to wait for
+    CLAP_PLUG_PLUG* old_plug = &(plug_data->plugins[id]);
+    if(old_plug->plug_inst || old_plug->plug_entry || old_plug->remove_pending == 1)clap_plug_plug_stop_and_clean(plug_data, id);
     
     if(clap_plug_create_plug_from_name(plug_data, plugin_name, id) < 0){
 	context_sub_send_msg(plug_data->control_data, (void*)plug_data, clap_plug_return_is_audio_thread(), "could not laod plugin from name %s\n", plugin_name);
@@ -1622,6 +1659,7 @@ static int clap_prepare_output_ports(CLAP_PLUG_INFO* plug_data, CLAP_PLUG_PORT*
 		sys_buffer[frame] = clap_buffer[frame];
 		if(clap_buffer[frame] != 0 && not_quiet == 0)not_quiet = 1;
 	    }
+	    context_sub_count_subnormals_rt(plug_data->control_data, sys_buffer, nframes);
 	}
     }
     return not_quiet;
@@ -1644,6 +1682,11 @@ static int clap_output_events_read(CLAP_PLUG_INFO* plug_data, unsigned int nfram
     return not_quiet;
 }
 //return -1 on error, return 0 if successful but the output was quiet and return 1 if successful and the output not quiet
+//the sort key for the input events, the frame of the event in the block
+static uint32_t clap_event_time_key(const void* item){
+    const clap_event_header_t* head = (const clap_event_header_t*)item;
+    return head->time;
+}
 static int clap_input_events_prepare(CLAP_PLUG_INFO* plug_data, unsigned int nframes, CLAP_PLUG_PLUG* plug){
     if(!plug_data)return -1;
     if(!plug)return -1;
@@ -1653,17 +1696,17 @@ static int clap_input_events_prepare(CLAP_PLUG_INFO* plug_data, unsigned int nfr
     //reset the event array
     ub_list_reset(ub_in);
     int not_quiet = 0;
-    //TODO right now smp_groovebox does not handle automation or modulation so simply put the parameter changes into the event buffer first on the 0 offset frame
-    //put parameter changes into the event queue
-    uint32_t param_count = param_return_num_params(plug->plug_params, 1);
-    for(uint32_t param_idx = 0; param_idx < param_count; param_idx++){
-	if(param_get_if_changed(plug->plug_params, (int)param_idx, 1) != 1)continue;
+    //TODO right now smp_groovebox does not handle automation or modulation
+    //put parameter changes into the event queue, at the frame they were sent from the [main-thread]
+    //only the changed parameters are visited
+    uint32_t cycle_frame = app_jack_last_frame_time_rt(plug_data->audio_backend);
+    for(int param_idx = param_next_changed(plug->plug_params, 0, 1); param_idx >= 0; param_idx = param_next_changed(plug->plug_params, param_idx + 1, 1)){
 	if(not_quiet == 0)not_quiet = 1;
 	clap_event_header_t head;
 	head.flags = CLAP_EVENT_IS_LIVE;
 	head.size = sizeof(clap_event_param_value_t);
 	head.space_id = CLAP_CORE_EVENT_SPACE_ID;
-	head.time = 0;
+	head.time = (uint32_t)param_get_change_offset_rt(plug->plug_params, param_idx, cycle_frame, nframes);
 	head.type = CLAP_EVENT_PARAM_VALUE;
 
 	clap_event_param_value_t param_val;
@@ -1685,20 +1728,23 @@ static int clap_input_events_prepare(CLAP_PLUG_INFO* plug_data, unsigned int nfr
     
     //write to input note ports of the plugin
     CLAP_PLUG_NOTE_PORT* note_ports = &(plug->input_note_ports);
-    if(note_ports->ports_count == 0)return not_quiet;
+    if(note_ports->ports_count == 0){
+	ub_sort(ub_in, clap_event_time_key);
+	return not_quiet;
+    }
     //Add the system midi messages
     for(uint32_t port_num = 0; port_num < note_ports->ports_count; port_num++){
 	if(!(note_ports->sys_ports[port_num]))continue;
-	app_jack_midi_cont_reset(note_ports->midi_cont);
-	void* midi_buffer = app_jack_get_buffer_rt(note_ports->sys_ports[port_num], nframes);
-	if(!midi_buffer)continue;
-	app_jack_return_notes_vels_rt(midi_buffer, note_ports->midi_cont);
+	//the port events are decoded already for this cycle on the midi bus
+	const JACK_MIDI_CONT* midi_cont = app_jack_midi_bus_return_rt(plug_data->audio_backend, note_ports->sys_ports[port_num]);
+	if(!midi_cont)continue;
 	uint32_t note_dialect = note_ports->preferred_dialects[port_num];
 	//write the midi1 messages, depending on the preferred dialect of the note port
-	for(uint32_t midi_num = 0; midi_num < note_ports->midi_cont->num_events; midi_num++){
+	for(uint32_t midi_num = 0; midi_num < midi_cont->num_events; midi_num++){
+	    const JACK_MIDI_EVENT* event = &(midi_cont->events[midi_num]);
 	    if(not_quiet == 0)not_quiet = 1;
 	    clap_event_header_t clap_head;
-	    clap_head.time = note_ports->midi_cont->nframe_nums[midi_num];
+	    clap_head.time = event->frame;
 	    clap_head.flags = CLAP_EVENT_IS_LIVE;
 	    clap_head.space_id = CLAP_CORE_EVENT_SPACE_ID;
 	    
@@ -1708,7 +1754,7 @@ static int clap_input_events_prepare(CLAP_PLUG_INFO* plug_data, unsigned int nfr
 	    int16_t key = 0;
 	    double  velocity = 0;
 	    
-	    MIDI_DATA_T type = note_ports->midi_cont->types[midi_num];
+	    MIDI_DATA_T type = event->status;
 	    //Handle note off and on events
 	    if((type & 0xf0) == 0x80 || (type & 0xf0) == 0x90){
 		if((note_dialect & CLAP_NOTE_DIALECT_CLAP) == CLAP_NOTE_DIALECT_CLAP){
@@ -1717,8 +1763,8 @@ static int clap_input_events_prepare(CLAP_PLUG_INFO* plug_data, unsigned int nfr
 			clap_head.type = CLAP_EVENT_NOTE_ON;
 		    clap_head.size = sizeof(clap_event_note_t);
 		    channel = (int16_t)(type & 0x0f);
-		    key = (int16_t)note_ports->midi_cont->note_pitches[midi_num];      
-		    velocity = (double)fit_range(127, 0, 1, 0, (SAMPLE_T)note_ports->midi_cont->vel_trig[midi_num]);
+		    key = (int16_t)event->data[0];      
+		    velocity = (double)fit_range(127, 0, 1, 0, (SAMPLE_T)event->data[1]);
 		    
 		    clap_event_note_t clap_note;
 		    clap_note.channel = channel;
@@ -1735,8 +1781,8 @@ static int clap_input_events_prepare(CLAP_PLUG_INFO* plug_data, unsigned int nfr
 		    clap_head.size = sizeof(clap_event_midi_t);
 		    clap_event_midi_t clap_midi;
 		    clap_midi.data[0] = (uint8_t)type;
-		    clap_midi.data[1] = (uint8_t)note_ports->midi_cont->note_pitches[midi_num];
-		    clap_midi.data[2] = (uint8_t)note_ports->midi_cont->vel_trig[midi_num];
+		    clap_midi.data[1] = (uint8_t)event->data[0];
+		    clap_midi.data[2] = (uint8_t)event->data[1];
 		    clap_midi.header = clap_head;
 		    clap_midi.port_index = port_index;
 		    ub_push(ub_in, (void*)&(clap_midi), (uint32_t)sizeof(clap_midi));
@@ -1746,8 +1792,20 @@ static int clap_input_events_prepare(CLAP_PLUG_INFO* plug_data, unsigned int nfr
 	    //Handle Polyphonic aftertouch events
 	    if((type & 0xf0) == 0xA0){
 	    }
-	    //Control mode change events
+	    //Control mode change events, the plugin gets them as they are if it takes midi
 	    if((type & 0xf0) == 0xB0){
+		if((note_dialect & CLAP_NOTE_DIALECT_MIDI) == CLAP_NOTE_DIALECT_MIDI){
+		    clap_head.type = CLAP_EVENT_MIDI;
+		    clap_head.size = sizeof(clap_event_midi_t);
+		    clap_event_midi_t clap_midi;
+		    clap_midi.data[0] = (uint8_t)type;
+		    clap_midi.data[1] = (uint8_t)event->data[0];
+		    clap_midi.data[2] = (uint8_t)event->data[1];
+		    clap_midi.header = clap_head;
+		    clap_midi.port_index = port_index;
+		    ub_push(ub_in, (void*)&(clap_midi), (uint32_t)sizeof(clap_midi));
+		}
+		continue;
 	    }
 	    //Handle program change events
 	    if((type & 0xf0) == 0xC0){
@@ -1763,6 +1821,8 @@ static int clap_input_events_prepare(CLAP_PLUG_INFO* plug_data, unsigned int nfr
 	    }    
 	}
     }
+    //the plugin reads the input events in time order
+    ub_sort(ub_in, clap_event_time_key);
     return not_quiet;
 }
 
@@ -1852,6 +1912,7 @@ void clap_plug_clean_memory(CLAP_PLUG_INFO* plug_data){
 	clap_plug_plug_clean(plug_data, i);
     }
 
+    param_clean_param_rings(plug_data->param_rings);
     context_sub_clean(plug_data->control_data);
     
     free(plug_data);
@@ -32,6 +32,8 @@ int clap_plug_preset_load_from_path(CLAP_PLUG_INFO* plug_data,int plug_id, const
 CLAP_PLUG_INFO* clap_plug_init(uint32_t min_buffer_size, uint32_t max_buffer_size, SAMPLE_T samplerate, clap_plug_status_t* plug_error, void* audio_backend);
 //return the plugin parameter container
 PRM_CONTAIN* clap_plug_param_return_param_container(CLAP_PLUG_INFO* plug_data, int plug_id);
+//return the plugin parameter container or NULL if the plugin is stopped, use on [audio-thread]
+PRM_CONTAIN* clap_plug_param_return_param_container_rt(CLAP_PLUG_INFO* plug_data, int plug_id);
 //initiate and load plugin from its name
 int clap_plug_load_and_activate(CLAP_PLUG_INFO* plug_data, const char* plugin_name, int id);
 //return the name of the plugin, caller must free the char*
@@ -40,5 +42,8 @@ char* clap_plug_return_plugin_name(CLAP_PLUG_INFO* plug_data, int plug_id);
 void clap_process_data_rt(CLAP_PLUG_INFO* plug_data, unsigned int nframes);
 //remove the clap plugin
 int clap_plug_plug_stop_and_clean(CLAP_PLUG_INFO* plug_data, int plug_id);
+//remove the clap plugins with ids without blocking the [main-thread], the [audio-thread] stops them all in the same cycle
+//each plugin is cleaned on [main-thread] in clap_read_rt_to_ui_messages after the [audio-thread] stopped it
+int clap_plug_plugs_stop_and_clean(CLAP_PLUG_INFO* plug_data, const int* ids, unsigned int num_ids);
 //clean the plugin struct and free memory
 void clap_plug_clean_memory(CLAP_PLUG_INFO* plug_data);
@@ -2,19 +2,57 @@
 #include <semaphore.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <stdarg.h>
-#include "../util_funcs/ring_buffer.h"
+#include <stdatomic.h>
+#include "../util_funcs/msg_ring.h"
 #include "../types.h"
+#include "../util_funcs/math_funcs.h"
+#include "../util_funcs/log_funcs.h"
+
+//commands given to context_sub_submit, allocated and freed on [main-thread]
+//the [audio-thread] only writes the results and then marks the batch as applied with its seq
+typedef struct _cxcontrol_batch{
+    uint32_t seq;
+    unsigned int num_cmds;
+    CXCONTROL_CMD cmds[MAX_CX_CMD_BATCH];
+    struct _cxcontrol_batch* next;
+}CXCONTROL_BATCH;
+
+//state that the [main-thread] replaced, freed when the [audio-thread] can no longer use it
+typedef struct _cxcontrol_retired{
+    void* state;
+    void (*free_state)(void* state);
+    //the [audio-thread] epoch when the state was replaced
+    uint32_t epoch;
+    struct _cxcontrol_retired* next;
+}CXCONTROL_RETIRED;
 
 typedef struct _cxcontrol_data{
     //ring buffers for audio-thread and main-thread communication
-    RING_BUFFER* rt_to_ui_msgs;
-    RING_BUFFER* ui_to_rt_msgs;
+    MSG_RING* rt_to_ui_msgs;
+    MSG_RING* ui_to_rt_msgs;
     //semaphore when [main-thread] needs to wait for the [audio-thread] to change something (for example stop the plugin or start the plugin)
     //wait on [main-thread] post on [audio-thread], but only when [main-thread] requested - [audio-thread] can post the semaphore only in response to [main-thread] message    
     sem_t pause_for_rt;
     CXCONTROL_RT_FUNCS rt_funcs_struct;
     CXCONTROL_UI_FUNCS ui_funcs_struct;
+    //how many subnormal values were found in the context outputs, written on [audio-thread] only with SUBNORMAL_DEBUG
+    atomic_uint subnormals_found;
+    //how many of the found subnormal values were already written to the log, touch only on [main-thread]
+    unsigned int subnormals_reported;
+    //submitted batches that wait for their done functions, oldest first, touch only on [main-thread]
+    CXCONTROL_BATCH* batches_head;
+    CXCONTROL_BATCH* batches_tail;
+    //seq of the last submitted batch, touch only on [main-thread]
+    uint32_t batch_seq;
+    //seq of the last batch the [audio-thread] applied
+    atomic_uint batch_done_seq;
+    //grows by one in each context_sub_process_rt, the [audio-thread] holds no state from the cycle before at that point
+    atomic_uint rt_epoch;
+    //states waiting for the [audio-thread] to pass the next context_sub_process_rt, oldest first, touch only on [main-thread]
+    CXCONTROL_RETIRED* retired_head;
+    CXCONTROL_RETIRED* retired_tail;
 }CXCONTROL;
 
 CXCONTROL* context_sub_init(CXCONTROL_RT_FUNCS rt_funcs_struct, CXCONTROL_UI_FUNCS ui_funcs_struct){
@@ -28,17 +66,26 @@ CXCONTROL* context_sub_init(CXCONTROL_RT_FUNCS rt_funcs_struct, CXCONTROL_UI_FUN
     //set the struct to zeroes
     cxcontrol_data->rt_to_ui_msgs = NULL;
     cxcontrol_data->ui_to_rt_msgs = NULL;
+    atomic_init(&cxcontrol_data->subnormals_found, 0);
+    cxcontrol_data->subnormals_reported = 0;
+    cxcontrol_data->batches_head = NULL;
+    cxcontrol_data->batches_tail = NULL;
+    cxcontrol_data->batch_seq = 0;
+    atomic_init(&cxcontrol_data->batch_done_seq, 0);
+    atomic_init(&cxcontrol_data->rt_epoch, 0);
+    cxcontrol_data->retired_head = NULL;
+    cxcontrol_data->retired_tail = NULL;
 
     cxcontrol_data->rt_funcs_struct = rt_funcs_struct;
     cxcontrol_data->ui_funcs_struct = ui_funcs_struct;
     
     //init ring buffers
-    cxcontrol_data->rt_to_ui_msgs = ring_buffer_init(sizeof(RING_SYS_MSG), MAX_SYS_BUFFER_ARRAY_SIZE);
+    cxcontrol_data->rt_to_ui_msgs = msg_ring_init(MAX_SYS_RING_SIZE);
     if(!(cxcontrol_data->rt_to_ui_msgs)){
 	context_sub_clean(cxcontrol_data);
 	return NULL;
     }
-    cxcontrol_data->ui_to_rt_msgs = ring_buffer_init(sizeof(RING_SYS_MSG), MAX_SYS_BUFFER_ARRAY_SIZE);
+    cxcontrol_data->ui_to_rt_msgs = msg_ring_init(MAX_SYS_RING_SIZE);
     if(!(cxcontrol_data->ui_to_rt_msgs)){
 	context_sub_clean(cxcontrol_data);
 	return NULL;
@@ -48,52 +95,109 @@ CXCONTROL* context_sub_init(CXCONTROL_RT_FUNCS rt_funcs_struct, CXCONTROL_UI_FUN
 int context_sub_process_ui(CXCONTROL* cxcontrol_data){
     if(!cxcontrol_data)return -1;
 
-    RING_BUFFER* ring_buffer = cxcontrol_data->rt_to_ui_msgs;
-    if(!ring_buffer)return -1;
-    unsigned int cur_items = ring_buffer_return_items(ring_buffer);
-    for(unsigned int i = 0; i < cur_items; i++){
-	RING_SYS_MSG cur_bit;
-	int read_buffer = ring_buffer_read(ring_buffer, &cur_bit, sizeof(cur_bit));
-
-	if(read_buffer <= 0)continue;
-	
-	if(cur_bit.msg_enum == MSG_PLUGIN_REQUEST_CALLBACK){
-	    if(cxcontrol_data->ui_funcs_struct.subcx_callback)cxcontrol_data->ui_funcs_struct.subcx_callback(cur_bit.user_data);
+    MSG_RING* msg_ring = cxcontrol_data->rt_to_ui_msgs;
+    if(!msg_ring)return -1;
+    //the messages are read in place and released after they are handled
+    unsigned int msg_size = 0;
+    const RING_SYS_MSG* cur_bit = NULL;
+    while((cur_bit = (const RING_SYS_MSG*)msg_ring_peek(msg_ring, &msg_size)) != NULL){
+	if(msg_size < sizeof(RING_SYS_MSG)){
+	    msg_ring_release(msg_ring);
+	    continue;
+	}
+	if(cur_bit->msg_enum == MSG_PLUGIN_REQUEST_CALLBACK){
+	    if(cxcontrol_data->ui_funcs_struct.subcx_callback)cxcontrol_data->ui_funcs_struct.subcx_callback(cur_bit->user_data);
 	}
-	if(cur_bit.msg_enum == MSG_PLUGIN_ACTIVATE_PROCESS){
-	    if(cxcontrol_data->ui_funcs_struct.subcx_activate_start_process)cxcontrol_data->ui_funcs_struct.subcx_activate_start_process(cur_bit.user_data);
+	if(cur_bit->msg_enum == MSG_PLUGIN_ACTIVATE_PROCESS){
+	    if(cxcontrol_data->ui_funcs_struct.subcx_activate_start_process)cxcontrol_data->ui_funcs_struct.subcx_activate_start_process(cur_bit->user_data);
 	}
-	if(cur_bit.msg_enum == MSG_PLUGIN_RESTART){
-	    if(cxcontrol_data->ui_funcs_struct.subcx_restart)cxcontrol_data->ui_funcs_struct.subcx_restart(cur_bit.user_data);
+	if(cur_bit->msg_enum == MSG_PLUGIN_RESTART){
+	    if(cxcontrol_data->ui_funcs_struct.subcx_restart)cxcontrol_data->ui_funcs_struct.subcx_restart(cur_bit->user_data);
 
 	}
-	if(cur_bit.msg_enum == MSG_PLUGIN_SENT_STRING){
-	    if(cxcontrol_data->ui_funcs_struct.send_msg)cxcontrol_data->ui_funcs_struct.send_msg(cur_bit.user_data, cur_bit.msg);
+	if(cur_bit->msg_enum == MSG_PLUGIN_SENT_STRING && msg_size > sizeof(RING_SYS_MSG)){
+	    const char* msg_string = (const char*)cur_bit + sizeof(RING_SYS_MSG);
+	    if(cxcontrol_data->ui_funcs_struct.send_msg)cxcontrol_data->ui_funcs_struct.send_msg(cur_bit->user_data, msg_string);
+	}
+	msg_ring_release(msg_ring);
+    }
+    //call the done functions of the batches the [audio-thread] applied
+    uint32_t done_seq = atomic_load_explicit(&cxcontrol_data->batch_done_seq, memory_order_acquire);
+    while(cxcontrol_data->batches_head && (int32_t)(done_seq - cxcontrol_data->batches_head->seq) >= 0){
+	CXCONTROL_BATCH* batch = cxcontrol_data->batches_head;
+	cxcontrol_data->batches_head = batch->next;
+	if(!cxcontrol_data->batches_head)cxcontrol_data->batches_tail = NULL;
+	for(unsigned int i = 0; i < batch->num_cmds; i++){
+	    CXCONTROL_CMD* cmd = &(batch->cmds[i]);
+	    if(cmd->done)cmd->done(cmd->done_data, cmd->user_data, cmd->generation, cmd->result);
 	}
+	free(batch);
     }
+    //free the states the [audio-thread] could have used only in a cycle that is already over
+    uint32_t rt_epoch = atomic_load(&cxcontrol_data->rt_epoch);
+    while(cxcontrol_data->retired_head && (int32_t)(rt_epoch - cxcontrol_data->retired_head->epoch) > 0){
+	CXCONTROL_RETIRED* retired = cxcontrol_data->retired_head;
+	cxcontrol_data->retired_head = retired->next;
+	if(!cxcontrol_data->retired_head)cxcontrol_data->retired_tail = NULL;
+	if(retired->free_state)retired->free_state(retired->state);
+	free(retired);
+    }
+#if SUBNORMAL_DEBUG == 1
+    unsigned int subnormals = atomic_load(&cxcontrol_data->subnormals_found);
+    if(subnormals != cxcontrol_data->subnormals_reported){
+	log_append_logfile("%u subnormal values found in the context outputs (%u total)\n", subnormals - cxcontrol_data->subnormals_reported, subnormals);
+	cxcontrol_data->subnormals_reported = subnormals;
+    }
+#endif
     return 0;
 }
+
+void context_sub_count_subnormals_rt(CXCONTROL* cxcontrol_data, const SAMPLE_T* buffer, unsigned int nframes){
+#if SUBNORMAL_DEBUG == 1
+    if(!cxcontrol_data)return;
+    unsigned int count = math_count_subnormals(buffer, nframes);
+    if(count > 0)atomic_fetch_add(&cxcontrol_data->subnormals_found, count);
+#endif
+}
 int context_sub_process_rt(CXCONTROL* cxcontrol_data){
     if(!cxcontrol_data)return -1;
+    //quiescent point, the states loaded after this are the ones published before it
+    atomic_fetch_add(&cxcontrol_data->rt_epoch, 1);
 
-    RING_BUFFER* ring_buffer = cxcontrol_data->ui_to_rt_msgs;
-    if(!ring_buffer)return -1;
+    MSG_RING* msg_ring = cxcontrol_data->ui_to_rt_msgs;
+    if(!msg_ring)return -1;
 
-    unsigned int cur_items = ring_buffer_return_items(ring_buffer);
-    for(unsigned int i = 0; i < cur_items; i++){
-	RING_SYS_MSG cur_bit;
-	int read_buffer = ring_buffer_read(ring_buffer, &cur_bit, sizeof(cur_bit));
-	if(read_buffer <= 0)continue;
-	if(cur_bit.msg_enum == MSG_PLUGIN_PROCESS){
-	    if(cxcontrol_data->rt_funcs_struct.subcx_start_process)cxcontrol_data->rt_funcs_struct.subcx_start_process(cur_bit.user_data);
+    unsigned int msg_size = 0;
+    const RING_SYS_MSG* cur_bit = NULL;
+    while((cur_bit = (const RING_SYS_MSG*)msg_ring_peek(msg_ring, &msg_size)) != NULL){
+	if(msg_size < sizeof(RING_SYS_MSG)){
+	    msg_ring_release(msg_ring);
+	    continue;
+	}
+	if(cur_bit->msg_enum == MSG_PLUGIN_PROCESS){
+	    if(cxcontrol_data->rt_funcs_struct.subcx_start_process)cxcontrol_data->rt_funcs_struct.subcx_start_process(cur_bit->user_data);
 	    //this messages will be sent from [main-thread] only with sam_wait, so error or no error, release the semaphore
 	    sem_post(&cxcontrol_data->pause_for_rt);
 	}
-	if(cur_bit.msg_enum == MSG_PLUGIN_STOP_PROCESS){
-	    if(cxcontrol_data->rt_funcs_struct.subcx_stop_process)cxcontrol_data->rt_funcs_struct.subcx_stop_process(cur_bit.user_data);
+	if(cur_bit->msg_enum == MSG_PLUGIN_STOP_PROCESS){
+	    if(cxcontrol_data->rt_funcs_struct.subcx_stop_process)cxcontrol_data->rt_funcs_struct.subcx_stop_process(cur_bit->user_data);
 	    //this messages will be sent from [main-thread] only with sam_wait, so error or no error, release the semaphore
 	    sem_post(&cxcontrol_data->pause_for_rt);
 	}
+	if(cur_bit->msg_enum == MSG_CMD_BATCH && cur_bit->user_data){
+	    CXCONTROL_BATCH* batch = (CXCONTROL_BATCH*)cur_bit->user_data;
+	    for(unsigned int i = 0; i < batch->num_cmds; i++){
+		CXCONTROL_CMD* cmd = &(batch->cmds[i]);
+		cmd->result = -1;
+		if(cmd->msg_enum == MSG_PLUGIN_PROCESS && cxcontrol_data->rt_funcs_struct.subcx_start_process)
+		    cmd->result = cxcontrol_data->rt_funcs_struct.subcx_start_process(cmd->user_data);
+		if(cmd->msg_enum == MSG_PLUGIN_STOP_PROCESS && cxcontrol_data->rt_funcs_struct.subcx_stop_process)
+		    cmd->result = cxcontrol_data->rt_funcs_struct.subcx_stop_process(cmd->user_data);
+	    }
+	    //the batches come in the order they were submitted, so the seq only grows
+	    atomic_store_explicit(&cxcontrol_data->batch_done_seq, batch->seq, memory_order_release);
+	}
+	msg_ring_release(msg_ring);
     }
     return 0;
 }
@@ -102,7 +206,8 @@ int context_sub_wait_for_stop(CXCONTROL* cxcontrol_data, void* user_data){
     RING_SYS_MSG send_bit;
     send_bit.msg_enum = MSG_PLUGIN_STOP_PROCESS;
     send_bit.user_data = user_data;
-    ring_buffer_write(cxcontrol_data->ui_to_rt_msgs, &send_bit, sizeof(send_bit));
+    //if the message did not fit the [audio-thread] would never post the semaphore
+    if(msg_ring_write(cxcontrol_data->ui_to_rt_msgs, &send_bit, sizeof(send_bit)) != 1)return -1;
     //lock the [main-thread]
     sem_wait(&cxcontrol_data->pause_for_rt);
     return 0;
@@ -112,11 +217,107 @@ int context_sub_wait_for_start(CXCONTROL* cxcontrol_data, void* user_data){
     RING_SYS_MSG send_bit;
     send_bit.msg_enum = MSG_PLUGIN_PROCESS;
     send_bit.user_data = user_data;
-    ring_buffer_write(cxcontrol_data->ui_to_rt_msgs, &send_bit, sizeof(send_bit));
+    //if the message did not fit the [audio-thread] would never post the semaphore
+    if(msg_ring_write(cxcontrol_data->ui_to_rt_msgs, &send_bit, sizeof(send_bit)) != 1)return -1;
     //lock the [main-thread]
     sem_wait(&cxcontrol_data->pause_for_rt);
     return 0;
 }
+int context_sub_submit(CXCONTROL* cxcontrol_data, const CXCONTROL_CMD* cmds, unsigned int num_cmds){
+    if(!cxcontrol_data)return -1;
+    if(!cmds || num_cmds == 0 || num_cmds > MAX_CX_CMD_BATCH)return -1;
+    CXCONTROL_BATCH* batch = (CXCONTROL_BATCH*)malloc(sizeof(CXCONTROL_BATCH));
+    if(!batch)return -1;
+    memcpy(batch->cmds, cmds, sizeof(CXCONTROL_CMD) * num_cmds);
+    batch->num_cmds = num_cmds;
+    batch->seq = cxcontrol_data->batch_seq + 1;
+    batch->next = NULL;
+    //the whole batch goes in one message, so the [audio-thread] can not apply only a part of it in a cycle
+    RING_SYS_MSG send_bit;
+    send_bit.msg_enum = MSG_CMD_BATCH;
+    send_bit.user_data = (void*)batch;
+    if(msg_ring_write(cxcontrol_data->ui_to_rt_msgs, &send_bit, sizeof(send_bit)) != 1){
+	free(batch);
+	return -1;
+    }
+    cxcontrol_data->batch_seq = batch->seq;
+    if(cxcontrol_data->batches_tail)cxcontrol_data->batches_tail->next = batch;
+    else cxcontrol_data->batches_head = batch;
+    cxcontrol_data->batches_tail = batch;
+    return 0;
+}
+int context_sub_start(CXCONTROL* cxcontrol_data, void* user_data, unsigned int stop_first){
+    if(!cxcontrol_data)return -1;
+    CXCONTROL_CMD cmds[2];
+    unsigned int num_cmds = 0;
+    if(stop_first == 1){
+	cmds[num_cmds].msg_enum = MSG_PLUGIN_STOP_PROCESS;
+	num_cmds += 1;
+    }
+    cmds[num_cmds].msg_enum = MSG_PLUGIN_PROCESS;
+    num_cmds += 1;
+    for(unsigned int i = 0; i < num_cmds; i++){
+	cmds[i].user_data = user_data;
+	cmds[i].done = NULL;
+	cmds[i].done_data = NULL;
+	cmds[i].generation = 0;
+	cmds[i].result = 0;
+    }
+    if(context_sub_submit(cxcontrol_data, cmds, num_cmds) == 0)return 0;
+    //could not send the batch, so block
+    if(stop_first == 1)context_sub_wait_for_stop(cxcontrol_data, user_data);
+    return context_sub_wait_for_start(cxcontrol_data, user_data);
+}
+int context_sub_stop_and_remove(CXCONTROL* cxcontrol_data, void* slots, size_t slot_size, unsigned int num_slots, const int* ids, unsigned int num_ids,
+				int (*slot_claim)(void* slot, unsigned int* generation),
+				void (*done)(void* done_data, void* user_data, unsigned int generation, int result), void* done_data){
+    if(!cxcontrol_data || !slots || !ids || !slot_claim || !done)return -1;
+    CXCONTROL_CMD cmds[MAX_CX_CMD_BATCH];
+    unsigned int num_cmds = 0;
+    for(unsigned int i = 0; i < num_ids; i++){
+	if(ids[i] >= 0 && ids[i] < (int)num_slots){
+	    void* slot = (void*)((char*)slots + slot_size * (size_t)ids[i]);
+	    unsigned int generation = 0;
+	    if(slot_claim(slot, &generation) == 0){
+		cmds[num_cmds].msg_enum = MSG_PLUGIN_STOP_PROCESS;
+		cmds[num_cmds].user_data = slot;
+		cmds[num_cmds].done = done;
+		cmds[num_cmds].done_data = done_data;
+		cmds[num_cmds].generation = generation;
+		cmds[num_cmds].result = 0;
+		num_cmds += 1;
+	    }
+	}
+	//send when the batch is full or after the last id
+	if(num_cmds == 0 || (num_cmds < MAX_CX_CMD_BATCH && i + 1 < num_ids))continue;
+	//the subcontexts are stopped in the same [audio-thread] cycle and removed when the done functions are called
+	if(context_sub_submit(cxcontrol_data, cmds, num_cmds) != 0){
+	    //could not send the batch, so block and remove one by one
+	    for(unsigned int j = 0; j < num_cmds; j++){
+		cmds[j].result = context_sub_wait_for_stop(cxcontrol_data, cmds[j].user_data);
+		done(done_data, cmds[j].user_data, cmds[j].generation, cmds[j].result);
+	    }
+	}
+	num_cmds = 0;
+    }
+    return 0;
+}
+int context_sub_retire(CXCONTROL* cxcontrol_data, void* state, void (*free_state)(void* state)){
+    if(!cxcontrol_data)return -1;
+    if(!state)return 0;
+    CXCONTROL_RETIRED* retired = (CXCONTROL_RETIRED*)malloc(sizeof(CXCONTROL_RETIRED));
+    //the state has to be leaked, the [audio-thread] could still be using it
+    if(!retired)return -1;
+    retired->state = state;
+    retired->free_state = free_state;
+    retired->next = NULL;
+    //read after the caller swapped the state pointer, a cycle that starts after this epoch can only load the new state
+    retired->epoch = atomic_load(&cxcontrol_data->rt_epoch);
+    if(cxcontrol_data->retired_tail)cxcontrol_data->retired_tail->next = retired;
+    else cxcontrol_data->retired_head = retired;
+    cxcontrol_data->retired_tail = retired;
+    return 0;
+}
 void context_sub_restart_msg(CXCONTROL* cxcontrol_data, void* user_data, bool is_audio_thread){
     if(!cxcontrol_data) return;
 
@@ -124,7 +325,7 @@ void context_sub_restart_msg(CXCONTROL* cxcontrol_data, void* user_data, bool is
 	RING_SYS_MSG send_bit;
 	send_bit.msg_enum = MSG_PLUGIN_RESTART;
 	send_bit.user_data = user_data;
-	ring_buffer_write(cxcontrol_data->rt_to_ui_msgs, &send_bit, sizeof(send_bit));
+	msg_ring_write(cxcontrol_data->rt_to_ui_msgs, &send_bit, sizeof(send_bit));
 	return;
     }
 
@@ -138,11 +339,14 @@ void context_sub_send_msg(CXCONTROL* cxcontrol_data, void* user_data, bool is_au
     vsnprintf(send_msg, MAX_STRING_MSG_LENGTH, msg, args);
     va_end(args);
     if(is_audio_thread){
-	RING_SYS_MSG send_bit;
-	snprintf(send_bit.msg, MAX_STRING_MSG_LENGTH, "%s", send_msg);
-	send_bit.msg_enum = MSG_PLUGIN_SENT_STRING;
-	send_bit.user_data = user_data;
-	ring_buffer_write(cxcontrol_data->rt_to_ui_msgs, &send_bit, sizeof(send_bit));
+	//the string goes right after the message, only as long as it is
+	unsigned int str_size = (unsigned int)strlen(send_msg) + 1;
+	RING_SYS_MSG* send_bit = (RING_SYS_MSG*)msg_ring_reserve(cxcontrol_data->rt_to_ui_msgs, sizeof(RING_SYS_MSG) + str_size);
+	if(!send_bit)return;
+	send_bit->msg_enum = MSG_PLUGIN_SENT_STRING;
+	send_bit->user_data = user_data;
+	memcpy((char*)send_bit + sizeof(RING_SYS_MSG), send_msg, str_size);
+	msg_ring_commit(cxcontrol_data->rt_to_ui_msgs, sizeof(RING_SYS_MSG) + str_size);
 	return;
     }
 
@@ -155,7 +359,7 @@ void context_sub_activate_start_process_msg(CXCONTROL* cxcontrol_data, void* use
 	RING_SYS_MSG send_bit;
 	send_bit.msg_enum = MSG_PLUGIN_ACTIVATE_PROCESS;
 	send_bit.user_data = user_data;
-	ring_buffer_write(cxcontrol_data->rt_to_ui_msgs, &send_bit, sizeof(send_bit));
+	msg_ring_write(cxcontrol_data->rt_to_ui_msgs, &send_bit, sizeof(send_bit));
 	return;
     }
 
@@ -168,7 +372,7 @@ void context_sub_callback_msg(CXCONTROL* cxcontrol_data, void* user_data, bool i
 	RING_SYS_MSG send_bit;
 	send_bit.msg_enum = MSG_PLUGIN_REQUEST_CALLBACK;
 	send_bit.user_data = user_data;
-	ring_buffer_write(cxcontrol_data->rt_to_ui_msgs, &send_bit, sizeof(send_bit));
+	msg_ring_write(cxcontrol_data->rt_to_ui_msgs, &send_bit, sizeof(send_bit));
 	return;
     }
 
@@ -178,11 +382,26 @@ void context_sub_callback_msg(CXCONTROL* cxcontrol_data, void* user_data, bool i
 int context_sub_clean(CXCONTROL* cxcontrol_data){
     if(!cxcontrol_data) return -1;
 
-    if(cxcontrol_data->rt_to_ui_msgs)ring_buffer_clean(cxcontrol_data->rt_to_ui_msgs);
-    if(cxcontrol_data->ui_to_rt_msgs)ring_buffer_clean(cxcontrol_data->ui_to_rt_msgs);
+    if(cxcontrol_data->rt_to_ui_msgs)msg_ring_clean(cxcontrol_data->rt_to_ui_msgs);
+    if(cxcontrol_data->ui_to_rt_msgs)msg_ring_clean(cxcontrol_data->ui_to_rt_msgs);
 
     sem_destroy(&cxcontrol_data->pause_for_rt);
 
+    CXCONTROL_BATCH* batch = cxcontrol_data->batches_head;
+    while(batch){
+	CXCONTROL_BATCH* next = batch->next;
+	free(batch);
+	batch = next;
+    }
+    //the [audio-thread] does not run anymore, so the retired states can be freed
+    CXCONTROL_RETIRED* retired = cxcontrol_data->retired_head;
+    while(retired){
+	CXCONTROL_RETIRED* next = retired->next;
+	if(retired->free_state)retired->free_state(retired->state);
+	free(retired);
+	retired = next;
+    }
+
     free(cxcontrol_data);
     return 0;
 }
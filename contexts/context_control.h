@@ -8,6 +8,8 @@ for each context.
  */
 #pragma once
 #include <stdbool.h>
+#include <stddef.h>
+#include "../structs.h"
 
 typedef struct _cxcontrol_data CXCONTROL;
 //user functions for [audio-thread], set NULL if func is not necessary
@@ -23,12 +25,23 @@ typedef struct _cxcontrol_ui_funcs{
     int (*subcx_restart)(void* user_data); //called when received a sys message from [audio-thread] to restart the subcontext
 }CXCONTROL_UI_FUNCS;
 
+//a command for context_sub_submit, done is called on [main-thread] after the [audio-thread] applied the command
+typedef struct _cxcontrol_cmd{
+    unsigned int msg_enum; //MSG_PLUGIN_PROCESS to start the subcontext or MSG_PLUGIN_STOP_PROCESS to stop it
+    void* user_data; //the subcontext, given to subcx_start_process or subcx_stop_process
+    void (*done)(void* done_data, void* user_data, unsigned int generation, int result); //can be NULL, result is what the rt function returned (-1 if there is no rt function)
+    void* done_data; //given to the done function
+    unsigned int generation; //given to the done function, so it can check that the user_data slot still holds the subcontext the command was for
+    int result; //set by the [audio-thread]
+}CXCONTROL_CMD;
+
 //init the subcontext control struct, create the ui_to_rt and rt_to_ui sys message ring buffers, init the pause semaphore
 //also get the user functions for messages from [audio-thread] like Request_callback, Sent_string etc from the rt_funcs_struct and ui_funcs_struct
 CXCONTROL* context_sub_init(CXCONTROL_RT_FUNCS rt_funcs_struct, CXCONTROL_UI_FUNCS ui_funcs_struct);
 
 //process the subcontext struct on the [main-thread]
 //read the rt_to_ui ring buffer sys messages and execute the user given functions for Request_callback, Sent_string and similar (if they are not null)
+//also calls the done functions of the submitted commands that the [audio-thread] applied and frees the retired states
 //called only on [main-thread]
 int context_sub_process_ui(CXCONTROL* cxcontrol_data);
 
@@ -48,6 +61,33 @@ int context_sub_wait_for_stop(CXCONTROL* cxcontrol_data, void* user_data);
 //if an error occures with the user function subcx_start_process the sem_post will still be called, its better to release the semaphore, then deadlock the system on an error
 int context_sub_wait_for_start(CXCONTROL* cxcontrol_data, void* user_data);
 
+//send num_cmds commands to the [audio-thread] without blocking, the [audio-thread] applies all of them at the start of the same cycle
+//the done functions of the commands are called in context_sub_process_ui after that, in the order the commands were given
+//num_cmds can be at most MAX_CX_CMD_BATCH. Returns 0 if the commands were sent, -1 on error or if the message ring is full
+//must be called only on [main-thread]
+int context_sub_submit(CXCONTROL* cxcontrol_data, const CXCONTROL_CMD* cmds, unsigned int num_cmds);
+
+//start the subcontext without blocking, the start goes to the [audio-thread] with context_sub_submit
+//if stop_first == 1 the subcontext is stopped and started again in the same [audio-thread] cycle
+//if the message ring is full this blocks with context_sub_wait_for_stop and context_sub_wait_for_start instead. Must be called only on [main-thread]
+int context_sub_start(CXCONTROL* cxcontrol_data, void* user_data, unsigned int stop_first);
+
+//stop the subcontexts in the slots of ids without blocking and call done on [main-thread] for each one after the [audio-thread] stopped it
+//the slots array has num_slots slots of slot_size bytes, the ids that are not slots are skipped
+//slot_claim returns -1 if there is nothing to remove in the slot (it is empty or its removal is on the way already),
+//otherwise it marks the removal of the slot as pending, writes the slot generation to generation and returns 0
+//if a batch does not fit the message ring, its slots are stopped with context_sub_wait_for_stop and done is called right away
+//returns 0 on success, -1 on error. Must be called only on [main-thread]
+int context_sub_stop_and_remove(CXCONTROL* cxcontrol_data, void* slots, size_t slot_size, unsigned int num_slots, const int* ids, unsigned int num_ids,
+				int (*slot_claim)(void* slot, unsigned int* generation),
+				void (*done)(void* done_data, void* user_data, unsigned int generation, int result), void* done_data);
+
+//give a state to free after the [audio-thread] can no longer use it, for states that the [audio-thread] loads from an atomic pointer
+//swap the new state in first (atomic_exchange), then retire the old one. free_state is called on [main-thread] in context_sub_process_ui
+//after the [audio-thread] passed the next context_sub_process_rt, so the context has to call context_sub_process_rt before it loads its states in a cycle
+//returns 0 on success, -1 on error (then the state is not freed). Must be called only on [main-thread]
+int context_sub_retire(CXCONTROL* cxcontrol_data, void* state, void (*free_state)(void* state));
+
 //these functions ask the user_data to do something - restart for example. If is_audio_thread == 0, the apropriate user function will be called right away (for example subcx_restart)
 //otherwise a message will be written to the rt_to_ui_msgs ring buffer to call that function on the [main-thread]
 void context_sub_restart_msg(CXCONTROL* cxcontrol_data, void* user_data, bool is_audio_thread);
@@ -55,6 +95,11 @@ void context_sub_send_msg(CXCONTROL* cxcontrol_data, void* user_data, bool is_au
 void context_sub_activate_start_process_msg(CXCONTROL* cxcontrol_data, void* user_data, bool is_audio_thread);
 void context_sub_callback_msg(CXCONTROL* cxcontrol_data, void* user_data, bool is_audio_thread);
 
+//count the subnormal values in an output buffer of the context, the count is written to the log on the [main-thread] in context_sub_process_ui
+//does nothing unless the program is built with SUBNORMAL_DEBUG=1 (make build_subnormal_debug). Called only on [audio-thread]
+void context_sub_count_subnormals_rt(CXCONTROL* cxcontrol_data, const SAMPLE_T* buffer, unsigned int nframes);
+
 //clean the subcontext control struct, free ring buffers, destroy the pause semaphore
+//submitted commands that did not finish yet are freed without calling their done functions
 //the user has to be sure, that the [audio-thread] will not call context_sub_process_rt function when context_sub_clean is called from the [main_thread] 
 int context_sub_clean(CXCONTROL* cxcontrol_data);
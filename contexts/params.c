@@ -4,10 +4,21 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include "../util_funcs/log_funcs.h"
 #include "../util_funcs/ring_buffer.h"
+#include "../util_funcs/msg_ring.h"
 //default speed per samples to interpolate the parameters when requested
 #define INTERP_SAMPLES 400
+//how many parameters fit in one word of the changed bitsets
+#define CHANGED_WORD_BITS 64
+//the one pole ramp jumps to its target when its this close, relative to the parameter range
+#define RAMP_SNAP_RANGE 0.00001
+//the name index has at least this many slots per parameter, so the probe chains stay short
+#define NAME_INDEX_LOAD 2
+//how many parameter messages are read from the ring at once in param_msgs_process
+#define PARAM_READ_BATCH 32
 
 typedef struct _params_interp_val{
     PARAM_T cur_inc; //how much to increment the value 
@@ -18,6 +29,20 @@ typedef struct _params_interp_val{
     int dir_mult; //to what direction to go, if from_val > to_val we have to cur_inc *= -1;
 }PRM_INTERP_VAL;
 
+//the block ramp state of a parameter, used by param_fill_ramp_rt
+typedef struct _params_ramp{
+    unsigned char ramp_type; //check prmRampType in types.h, 0 if the parameter has no ramp
+    unsigned int ramp_samples; //how many samples the linear ramp takes
+    PARAM_T coef; //how much of the distance to the target the one pole ramp moves each sample
+    PARAM_T cur_val; //where the ramp is right now
+    PARAM_T to_val; //where the ramp is going
+    PARAM_T inc; //how much the linear ramp moves each sample
+    unsigned int samples_left; //how many samples are left for the linear ramp
+    unsigned int started; //0 until the first fill, so the ramp does not start from 0
+}PRM_RAMP;
+
+//the parameter data that is read on every param_get_value, the rt and ui arrays both have a copy
+//kept small so reading a parameter touches one cache line
 typedef struct _params_param{
     //value of the parameter
     PARAM_T val;
@@ -26,33 +51,66 @@ typedef struct _params_param{
     PARAM_T def_val; //default value
     //how much to increase or decrease the parameter
     PARAM_T inc_am;
+    //for exponential parameters this is where the table for the exp or any other curve should be
+    //this table needs to be normalized (range 0..1) and malloced outside of this context and added here
+    //with the param_add_curve_table
+    MATH_RANGE_TABLE* curve_table;
+    //sometimes we might want to get an interpolated version of the parameter, so it does not change so quickly,
+    //for example to avoid a click when changing amplitude of a synth oscillator
+    PRM_INTERP_VAL* interp_val;
     //the type of the parameter value, used for ui display purposes
     //check the appReturnType in the types.h
     unsigned char val_type;
     //if this is 1 the parameter was just changed, this will change to 0 when get_value will be invoked
-    unsigned int just_changed;
-    //if the ui_name of parameter just changed this will be 1, and will become a 0 if param_ui_name_changed is called
+    unsigned char just_changed;
+    //TODO instead of is hidden implement flag system for parameters
+    //is the parameter hidden
+    unsigned char is_hidden;
+    //the audio clock frame of the last change that came from the other thread, 0 if the change had no frame
+    //only used on the rt_params, check param_get_change_offset_rt
+    uint32_t change_frame;
+}PRM_PARAM;
+
+//the display name of the parameter, the rt and ui arrays both have a copy since it can change during the lifetime of the program
+typedef struct _params_param_name{
+    //ui_name is the display name for the user
+    char ui_name[MAX_PARAM_NAME_LENGTH];
+    //if the ui_name of parameter just changed this will be 1, and will become a 0 if param_get_ui_name is called
     unsigned int ui_name_just_changed;
+}PRM_PARAM_NAME;
+
+//the value of the parameter formatted for the ui, only on [main-thread]
+//made again only when the value is different from shown_val, so refreshing the ui does not format the same value again and again
+typedef struct _params_param_display{
+    char val_string[MAX_PARAM_VALUE_STRING];
+    //the ui value the val_string was made from
+    PARAM_T shown_val;
+    //0 if the val_string has to be made again even if the value did not change
+    unsigned int valid;
+}PRM_PARAM_DISPLAY;
+
+//the parameter data that does not change after the container is initialized, one copy for both threads
+typedef struct _params_param_info{
     //name will not change during the lifetime of parameter
     char name[MAX_PARAM_NAME_LENGTH];
-    //ui_name is the display name for the user. This can change during the lifetime of the program
-    char ui_name[MAX_PARAM_NAME_LENGTH];
-    //sometimes we might want to get an interpolated version of the parameter, so it does not change so quickly,
-    //for example to avoid a click when changing amplitude of a synth oscillator
-    PRM_INTERP_VAL* interp_val;
-    //for exponential parameters this is where the table for the exp or any other curve should be
-    //this table needs to be normalized (range 0..1) and malloced outside of this context and added here
-    //with the param_add_curve_table
-    MATH_RANGE_TABLE* curve_table;
     //for parameters that contain strings to display for user
     unsigned int param_strings_num; // how many strings there are for this parameter
     char** param_strings; //the string array
     //user data for convenience (for example clap plugins has a void* cookie for faster loading of params from events)
     PRM_USER_DATA user_data;
-    //TODO instead of is hidden implement flag system for parameters
-    //is the parameter hidden
-    uint16_t is_hidden;
-}PRM_PARAM;
+}PRM_PARAM_INFO;
+
+//all the parameter values of a container, published to the [audio-thread] at once with param_snapshot_publish
+typedef struct _params_snapshot{
+    unsigned int num_of_params;
+    PARAM_T* vals;
+    //the publish number of the snapshot, the Operation_Snapshot message carries it in param_frame
+    uint32_t seq;
+    //1 when the [audio-thread] finished setting the values, then the [main-thread] can free the snapshot
+    atomic_uint consumed;
+    //the published snapshots that are not freed yet, only for [main-thread]
+    struct _params_snapshot* next;
+}PRM_SNAPSHOT;
 
 typedef struct _params_container{
     //the parameters arrays
@@ -60,15 +118,70 @@ typedef struct _params_container{
     //usually the ui thread
     PRM_PARAM* rt_params;
     PRM_PARAM* ui_params;
+    //the display names for each thread, same rules as for the parameter arrays
+    PRM_PARAM_NAME* rt_names;
+    PRM_PARAM_NAME* ui_names;
+    //the parameter info that does not change, read by both threads
+    PRM_PARAM_INFO* param_info;
+    //the formatted values for the ui, only for [main-thread]
+    PRM_PARAM_DISPLAY* ui_display;
+    //open addressing hash table of the parameter names for param_find_name, each slot is a parameter id or -1 if its empty
+    //built once in params_init_param_container, the names dont change after that so both threads can read it
+    int32_t* name_index;
+    unsigned int name_index_size;
+    //block ramps for the rt_params, NULL until param_set_ramp is called on the container
+    PRM_RAMP* rt_ramps;
     //how many parameters are there
     unsigned int num_of_params_ui;
     unsigned int num_of_params_rt;
-    //ring buffers for parameter manipulation/communication
-    RING_BUFFER* param_rt_to_ui;
-    RING_BUFFER* param_ui_to_rt;
+    //bitsets that mirror the just_changed of the parameters, a bit per parameter, so the changed parameters can be found without going through all of them
+    uint64_t* changed_rt;
+    uint64_t* changed_ui;
+    unsigned int changed_words;
+    //bitsets of the values that did not fit the ring to the other thread, the same size as the changed bitsets
+    //pending_ui is for the ui_to_rt ring and is touched only on [main-thread], pending_rt only on [audio-thread]
+    //param_msgs_process sends the current value of these parameters again, so only the last value is sent no matter how many changes there were
+    uint64_t* pending_rt;
+    uint64_t* pending_ui;
+    //the parameter rings of the context this container sends its messages through, and the container id in them
+    PRM_RINGS* param_rings;
+    unsigned int cont_id;
+    //the param_rings rt_reads count when the container was removed, the container is freed once the [audio-thread] read the rings twice after that
+    unsigned int retired_at;
+    //the published snapshot the [audio-thread] did not take yet, the [audio-thread] takes it with an atomic exchange
+    //when it reads the Operation_Snapshot message of the snapshot, so the messages sent after the snapshot are set after it
+    _Atomic(PRM_SNAPSHOT*) snapshot_pending;
+    //the seq of the last published snapshot and 1 if its Operation_Snapshot message did not fit the ring yet, only for [main-thread]
+    //while the message is not sent the values of the container wait in pending_ui, so they do not get to the [audio-thread] before the snapshot
+    uint32_t snapshot_seq;
+    unsigned int snapshot_unsent;
+    //the published snapshots that the [main-thread] still has to free
+    PRM_SNAPSHOT* snapshots_sent;
     PRM_CONT_USER_DATA user_data;
 }PRM_CONTAIN;
 
+typedef struct _params_rings{
+    //ring buffers for parameter manipulation/communication, shared by all the containers of the context
+    RING_BUFFER* param_rt_to_ui;
+    RING_BUFFER* param_ui_to_rt;
+    //ring buffers for the messages with strings (Operation_ChangeName), these are rare so the value messages dont carry the string
+    MSG_RING* string_rt_to_ui;
+    MSG_RING* string_ui_to_rt;
+    //the containers that send messages through these rings, the cont_id of a message is the index here
+    //written only on [main-thread], read on both threads
+    _Atomic(PRM_CONTAIN*) conts[MAX_PARAM_RING_CONTAINERS];
+    //removed containers that can still get messages on the [audio-thread], freed in param_msgs_process on [main-thread]
+    PRM_CONTAIN* retired[MAX_PARAM_RING_CONTAINERS];
+    //how many times the [audio-thread] finished reading the ui_to_rt rings
+    atomic_uint rt_reads;
+    //1 if any container has pending values for the other thread, each is touched only by the thread that sends
+    unsigned int pending_from_ui;
+    unsigned int pending_from_rt;
+    //the audio clock that stamps the ui_to_rt messages, can be NULL then the messages have no frame
+    uint32_t(*frame_time)(void* clock_data);
+    void* clock_data;
+}PRM_RINGS;
+
 PRM_INTERP_VAL* params_init_interpolated_val(PARAM_T max_range, unsigned int total_samples){
     if(total_samples <= 0)return NULL;
     if(max_range <= 0)return NULL;
@@ -113,19 +226,110 @@ PARAM_T params_interp_val_get_value(PRM_INTERP_VAL* intrp_val, PARAM_T new_val){
     return intrp_val->cur_val;
 }
 
+PRM_RINGS* params_init_param_rings(uint32_t(*frame_time)(void* clock_data), void* clock_data){
+    PRM_RINGS* param_rings = (PRM_RINGS*)malloc(sizeof(PRM_RINGS));
+    if(!param_rings)return NULL;
+    param_rings->frame_time = frame_time;
+    param_rings->clock_data = clock_data;
+    param_rings->param_rt_to_ui = NULL;
+    param_rings->param_ui_to_rt = NULL;
+    param_rings->string_rt_to_ui = NULL;
+    param_rings->string_ui_to_rt = NULL;
+    for(unsigned int i = 0; i < MAX_PARAM_RING_CONTAINERS; i++){
+	atomic_init(&param_rings->conts[i], NULL);
+	param_rings->retired[i] = NULL;
+    }
+    atomic_init(&param_rings->rt_reads, 0);
+    param_rings->pending_from_ui = 0;
+    param_rings->pending_from_rt = 0;
+
+    param_rings->param_rt_to_ui = ring_buffer_init(sizeof(PARAM_RING_DATA_BIT), MAX_PARAM_RING_BUFFER_ARRAY_SIZE);
+    param_rings->param_ui_to_rt = ring_buffer_init(sizeof(PARAM_RING_DATA_BIT), MAX_PARAM_RING_BUFFER_ARRAY_SIZE);
+    param_rings->string_rt_to_ui = msg_ring_init(MAX_PARAM_STRING_RING_SIZE);
+    param_rings->string_ui_to_rt = msg_ring_init(MAX_PARAM_STRING_RING_SIZE);
+    if(!param_rings->param_rt_to_ui || !param_rings->param_ui_to_rt || !param_rings->string_rt_to_ui || !param_rings->string_ui_to_rt){
+	param_clean_param_rings(param_rings);
+	return NULL;
+    }
+    return param_rings;
+}
+
+//find a free id in the param_rings for the container, the ids of retired containers are not free until they are freed
+static int param_rings_add_container(PRM_RINGS* param_rings, PRM_CONTAIN* param_container){
+    for(unsigned int i = 0; i < MAX_PARAM_RING_CONTAINERS; i++){
+	if(atomic_load(&param_rings->conts[i]) != NULL)continue;
+	if(param_rings->retired[i] != NULL)continue;
+	param_container->param_rings = param_rings;
+	param_container->cont_id = i;
+	atomic_store(&param_rings->conts[i], param_container);
+	return 0;
+    }
+    return -1;
+}
+
+//hash of the parameter name for the name_index (fnv-1a)
+static uint32_t param_name_hash(const char* name){
+    uint32_t hash = 2166136261u;
+    for(const unsigned char* c = (const unsigned char*)name; *c != '\0'; c++){
+	hash ^= (uint32_t)*c;
+	hash *= 16777619u;
+    }
+    return hash;
+}
+
+//build the name_index from the param_info names, if two parameters have the same name the first one is found, same as going through the names
+static int param_build_name_index(PRM_CONTAIN* param_container){
+    unsigned int index_size = 1;
+    while(index_size < param_container->num_of_params_ui * NAME_INDEX_LOAD)index_size *= 2;
+    param_container->name_index = malloc(sizeof(int32_t) * index_size);
+    if(!param_container->name_index)return -1;
+    param_container->name_index_size = index_size;
+    for(unsigned int i = 0; i < index_size; i++)param_container->name_index[i] = -1;
+    for(int id = 0; id < param_container->num_of_params_ui; id++){
+	const char* name = param_container->param_info[id].name;
+	unsigned int slot = param_name_hash(name) & (index_size - 1);
+	while(param_container->name_index[slot] != -1){
+	    if(strcmp(param_container->param_info[param_container->name_index[slot]].name, name) == 0)break;
+	    slot = (slot + 1) & (index_size - 1);
+	}
+	if(param_container->name_index[slot] == -1)param_container->name_index[slot] = id;
+    }
+    return 0;
+}
+
 PRM_CONTAIN* params_init_param_container(unsigned int num_of_params, char** param_names, PARAM_T* param_vals,
 					 PARAM_T* param_mins, PARAM_T* param_maxs, PARAM_T* param_incs, unsigned char* val_types,
-					 PRM_USER_DATA* user_data_per_param, const PRM_CONT_USER_DATA* user_data_per_container){
+					 PRM_USER_DATA* user_data_per_param, const PRM_CONT_USER_DATA* user_data_per_container, PRM_RINGS* param_rings){
     if(num_of_params<=0) return NULL;
+    //the parameter ids have to fit the parameter ring messages
+    if(num_of_params > MAX_PARAMS_PER_CONTAINER)return NULL;
     if(!param_names || !param_vals || !param_mins || !param_maxs || !param_incs || !val_types) return NULL;
+    if(!param_rings)return NULL;
     PRM_CONTAIN* param_container = (PRM_CONTAIN*)malloc(sizeof(PRM_CONTAIN));
     if(!param_container)return NULL;
-    param_container->param_rt_to_ui = NULL;
-    param_container->param_ui_to_rt = NULL;
+    param_container->param_rings = NULL;
+    param_container->cont_id = 0;
+    param_container->retired_at = 0;
     param_container->num_of_params_rt = 0;
     param_container->num_of_params_ui = 0;
     param_container->rt_params = NULL;
     param_container->ui_params = NULL;
+    param_container->rt_names = NULL;
+    param_container->ui_names = NULL;
+    param_container->param_info = NULL;
+    param_container->ui_display = NULL;
+    param_container->name_index = NULL;
+    param_container->name_index_size = 0;
+    param_container->rt_ramps = NULL;
+    param_container->changed_rt = NULL;
+    param_container->changed_ui = NULL;
+    param_container->changed_words = 0;
+    param_container->pending_rt = NULL;
+    param_container->pending_ui = NULL;
+    atomic_init(&param_container->snapshot_pending, NULL);
+    param_container->snapshot_seq = 0;
+    param_container->snapshot_unsent = 0;
+    param_container->snapshots_sent = NULL;
     param_container->user_data.user_data = NULL;
     param_container->user_data.val_to_string = NULL;
     if(user_data_per_container){
@@ -133,18 +337,25 @@ PRM_CONTAIN* params_init_param_container(unsigned int num_of_params, char** para
 	param_container->user_data.val_to_string = user_data_per_container->val_to_string;
     }
     
-    param_container->param_rt_to_ui = ring_buffer_init(sizeof(PARAM_RING_DATA_BIT), MAX_PARAM_RING_BUFFER_ARRAY_SIZE);
-    param_container->param_ui_to_rt = ring_buffer_init(sizeof(PARAM_RING_DATA_BIT), MAX_PARAM_RING_BUFFER_ARRAY_SIZE);
-    if(!param_container->param_rt_to_ui || !param_container->param_ui_to_rt){
-	param_clean_param_container(param_container);
-	return NULL;
-    }
-    
     param_container->num_of_params_rt = num_of_params;
     param_container->rt_params = calloc(num_of_params, sizeof(PRM_PARAM));
     param_container->num_of_params_ui = num_of_params;
     param_container->ui_params = calloc(num_of_params, sizeof(PRM_PARAM));
-    if(!param_container->rt_params || !param_container->ui_params){
+    param_container->rt_names = calloc(num_of_params, sizeof(PRM_PARAM_NAME));
+    param_container->ui_names = calloc(num_of_params, sizeof(PRM_PARAM_NAME));
+    param_container->param_info = calloc(num_of_params, sizeof(PRM_PARAM_INFO));
+    param_container->ui_display = calloc(num_of_params, sizeof(PRM_PARAM_DISPLAY));
+    if(!param_container->rt_params || !param_container->ui_params || !param_container->rt_names || !param_container->ui_names || !param_container->param_info ||
+       !param_container->ui_display){
+	param_clean_param_container(param_container);
+	return NULL;
+    }
+    param_container->changed_words = (num_of_params + CHANGED_WORD_BITS - 1) / CHANGED_WORD_BITS;
+    param_container->changed_rt = calloc(param_container->changed_words, sizeof(uint64_t));
+    param_container->changed_ui = calloc(param_container->changed_words, sizeof(uint64_t));
+    param_container->pending_rt = calloc(param_container->changed_words, sizeof(uint64_t));
+    param_container->pending_ui = calloc(param_container->changed_words, sizeof(uint64_t));
+    if(!param_container->changed_rt || !param_container->changed_ui || !param_container->pending_rt || !param_container->pending_ui){
 	param_clean_param_container(param_container);
 	return NULL;
     }
@@ -152,14 +363,12 @@ PRM_CONTAIN* params_init_param_container(unsigned int num_of_params, char** para
     for(int i = 0; i< num_of_params; i++){
 	PRM_PARAM* rt_params = &(param_container->rt_params[i]);
 	PRM_PARAM* ui_params = &(param_container->ui_params[i]);
+	PRM_PARAM_NAME* rt_name = &(param_container->rt_names[i]);
+	PRM_PARAM_NAME* ui_name = &(param_container->ui_names[i]);
+	PRM_PARAM_INFO* param_info = &(param_container->param_info[i]);
 	
 	rt_params->interp_val = params_init_interpolated_val(fabs(param_maxs[i] - param_mins[i]) , INTERP_SAMPLES);
-	if(!rt_params->interp_val)continue;	
 	ui_params->interp_val = params_init_interpolated_val(fabs(param_maxs[i] - param_mins[i]) , INTERP_SAMPLES);
-	if(!ui_params->interp_val){
-	    free(rt_params->interp_val);
-	    continue;
-	}	
 	rt_params->just_changed = 0;
 	ui_params->just_changed = 0;
 		
@@ -186,18 +395,25 @@ PRM_CONTAIN* params_init_param_container(unsigned int num_of_params, char** para
 	ui_params->is_hidden = 0;
 	
 	const char* param_name = param_names[i];
-	snprintf(rt_params->name, MAX_PARAM_NAME_LENGTH, "%s", param_name);
-	snprintf(ui_params->name, MAX_PARAM_NAME_LENGTH, "%s", param_name);
-	snprintf(rt_params->ui_name, MAX_PARAM_NAME_LENGTH, "%s", param_name);
-	snprintf(ui_params->ui_name, MAX_PARAM_NAME_LENGTH, "%s", param_name);
-	rt_params->ui_name_just_changed = 0;
-	ui_params->ui_name_just_changed = 0;
+	snprintf(param_info->name, MAX_PARAM_NAME_LENGTH, "%s", param_name);
+	snprintf(rt_name->ui_name, MAX_PARAM_NAME_LENGTH, "%s", param_name);
+	snprintf(ui_name->ui_name, MAX_PARAM_NAME_LENGTH, "%s", param_name);
+	rt_name->ui_name_just_changed = 0;
+	ui_name->ui_name_just_changed = 0;
 
 	if(user_data_per_param){
-	    rt_params->user_data = user_data_per_param[i];
-	    ui_params->user_data = user_data_per_param[i];
+	    param_info->user_data = user_data_per_param[i];
 	}
     }
+    if(param_build_name_index(param_container) != 0){
+	param_clean_param_container(param_container);
+	return NULL;
+    }
+    //only now the container can get messages from the param_rings
+    if(param_rings_add_container(param_rings, param_container) != 0){
+	param_clean_param_container(param_container);
+	return NULL;
+    }
 
     return param_container;
 }
@@ -215,11 +431,12 @@ int param_add_curve_table(PRM_CONTAIN* param_container, int val_id, MATH_RANGE_T
     
     cur_param_rt->curve_table = table;
     cur_param_ui->curve_table = table;
+    param_container->ui_display[val_id].valid = 0;
 
     return 0;
 }
 
-static void param_set_value_directly(PRM_PARAM* cur_param, PARAM_T set_to, const char* in_string, unsigned char param_op){
+static void param_set_value_directly(PRM_PARAM* cur_param, PRM_PARAM_NAME* cur_name, PARAM_T set_to, const char* in_string, unsigned char param_op){
     if(!cur_param)return;
     PARAM_T prev_value = cur_param->val;
 
@@ -245,9 +462,9 @@ static void param_set_value_directly(PRM_PARAM* cur_param, PARAM_T set_to, const
 	cur_param->just_changed = 1;
 	break;
     case Operation_ChangeName:
-	if(in_string){
-	    snprintf(cur_param->ui_name, MAX_PARAM_NAME_LENGTH, "%s", in_string);
-	    cur_param->ui_name_just_changed = 1;
+	if(in_string && cur_name){
+	    snprintf(cur_name->ui_name, MAX_PARAM_NAME_LENGTH, "%s", in_string);
+	    cur_name->ui_name_just_changed = 1;
 	}
 	break;
     case Operation_ToggleHidden:
@@ -267,79 +484,380 @@ static void param_set_value_directly(PRM_PARAM* cur_param, PARAM_T set_to, const
     }
 }
 
-void param_msgs_process(PRM_CONTAIN* param_container, unsigned int rt_params){
-    if(!param_container)return;
+static void param_free_param_container(PRM_CONTAIN* param_container);
 
-    PRM_PARAM* prm_array = NULL;
-    RING_BUFFER* ring_buffer = NULL;
-    if(!rt_params){
-	prm_array = param_container->ui_params;
-	ring_buffer = param_container->param_rt_to_ui;
+//set the changed bit of the parameter if the parameter is just_changed
+static void param_mark_if_changed(PRM_CONTAIN* param_container, int val_id, unsigned int rt_params){
+    PRM_PARAM* cur_param = &(param_container->ui_params[val_id]);
+    uint64_t* changed_bits = param_container->changed_ui;
+    if(rt_params){
+	cur_param = &(param_container->rt_params[val_id]);
+	changed_bits = param_container->changed_rt;
     }
+    if(cur_param->just_changed == 0)return;
+    changed_bits[val_id / CHANGED_WORD_BITS] |= (uint64_t)1 << (val_id % CHANGED_WORD_BITS);
+}
+
+//mark the parameter as no longer just_changed and clear its changed bit
+static void param_clear_changed(PRM_CONTAIN* param_container, int val_id, unsigned int rt_params){
+    PRM_PARAM* cur_param = &(param_container->ui_params[val_id]);
+    uint64_t* changed_bits = param_container->changed_ui;
     if(rt_params){
-	prm_array = param_container->rt_params;
-	ring_buffer = param_container->param_ui_to_rt;
+	cur_param = &(param_container->rt_params[val_id]);
+	changed_bits = param_container->changed_rt;
+    }
+    cur_param->just_changed = 0;
+    changed_bits[val_id / CHANGED_WORD_BITS] &= ~((uint64_t)1 << (val_id % CHANGED_WORD_BITS));
+}
+
+//free the retired containers that the [audio-thread] can no longer reach, if force == 1 free all of them. Called only on [main-thread]
+static void param_rings_free_retired(PRM_RINGS* param_rings, unsigned int force){
+    unsigned int rt_reads = atomic_load(&param_rings->rt_reads);
+    for(unsigned int i = 0; i < MAX_PARAM_RING_CONTAINERS; i++){
+	PRM_CONTAIN* retired = param_rings->retired[i];
+	if(!retired)continue;
+	//the read that was running when the container was removed could still see it, the one after that could not
+	if(force == 0 && rt_reads - retired->retired_at < 2)continue;
+	param_free_param_container(retired);
+	param_rings->retired[i] = NULL;
+    }
+}
+
+//write a value message for the parameter to the ring to the other thread, returns what ring_buffer_write returns (1 if written)
+static int param_send_value(PRM_CONTAIN* param_container, int val_id, PARAM_T set_to, unsigned char param_op, unsigned int rt_params){
+    PRM_RINGS* param_rings = param_container->param_rings;
+    RING_BUFFER* ring_buffer = param_rings->param_ui_to_rt;
+    if(rt_params)ring_buffer = param_rings->param_rt_to_ui;
+    PARAM_RING_DATA_BIT send_bit;
+    send_bit.param_value = set_to;
+    send_bit.param_frame = 0;
+    //stamp the messages to the [audio-thread] with the audio clock, 0 is kept for messages without a frame
+    if(rt_params == 0 && param_rings->frame_time){
+	send_bit.param_frame = param_rings->frame_time(param_rings->clock_data);
+	if(send_bit.param_frame == 0)send_bit.param_frame = 1;
     }
-    if(!prm_array || !ring_buffer)return;
+    send_bit.param_id = val_id;
+    send_bit.cont_id = param_container->cont_id;
+    send_bit.param_op = param_op;
+    return ring_buffer_write(ring_buffer, &send_bit, sizeof(send_bit));
+}
+
+//write the Operation_Snapshot message of the last published snapshot to the [audio-thread], returns 1 if written. Use only on [main-thread]
+static int param_send_snapshot(PRM_CONTAIN* param_container){
+    PARAM_RING_DATA_BIT send_bit;
+    send_bit.param_value = 0;
+    send_bit.param_frame = param_container->snapshot_seq;
+    send_bit.param_id = 0;
+    send_bit.cont_id = param_container->cont_id;
+    send_bit.param_op = Operation_Snapshot;
+    return ring_buffer_write(param_container->param_rings->param_ui_to_rt, &send_bit, sizeof(send_bit));
+}
+
+//send the values that did not fit the ring before, with the current value of the parameter. Only on the thread that sends (rt_params)
+static void param_flush_pending(PRM_RINGS* param_rings, unsigned int rt_params){
+    unsigned int* pending_flag = &(param_rings->pending_from_ui);
+    if(rt_params)pending_flag = &(param_rings->pending_from_rt);
+    if(*pending_flag == 0)return;
+    *pending_flag = 0;
+    for(unsigned int i = 0; i < MAX_PARAM_RING_CONTAINERS; i++){
+	PRM_CONTAIN* cont = atomic_load(&param_rings->conts[i]);
+	if(!cont)continue;
+	uint64_t* pending_bits = cont->pending_ui;
+	PRM_PARAM* param_array = cont->ui_params;
+	if(rt_params){
+	    pending_bits = cont->pending_rt;
+	    param_array = cont->rt_params;
+	}
+	//the snapshot goes before the values that waited for it
+	if(rt_params == 0 && cont->snapshot_unsent == 1){
+	    if(param_send_snapshot(cont) != 1){
+		*pending_flag = 1;
+		return;
+	    }
+	    cont->snapshot_unsent = 0;
+	}
+	for(unsigned int word = 0; word < cont->changed_words; word++){
+	    while(pending_bits[word] != 0){
+		int val_id = (int)(word * CHANGED_WORD_BITS) + __builtin_ctzll(pending_bits[word]);
+		//still full, try again on the next param_msgs_process
+		if(param_send_value(cont, val_id, param_array[val_id].val, Operation_SetValue, rt_params) != 1){
+		    *pending_flag = 1;
+		    return;
+		}
+		pending_bits[word] &= pending_bits[word] - 1;
+	    }
+	}
+    }
+}
+
+//set the values of the pending snapshot on the rt_params when its Operation_Snapshot message with seq is read, use only on [audio-thread]
+static void param_snapshot_apply_rt(PRM_CONTAIN* param_container, uint32_t seq){
+    PRM_SNAPSHOT* snapshot = atomic_exchange(&param_container->snapshot_pending, NULL);
+    if(!snapshot)return;
+    //a newer snapshot was published after this message, its own message comes later in the ring
+    if((int32_t)(snapshot->seq - seq) > 0){
+	PRM_SNAPSHOT* expected = NULL;
+	if(atomic_compare_exchange_strong(&param_container->snapshot_pending, &expected, snapshot))return;
+	//an even newer snapshot was published meanwhile, this one will never be set
+	atomic_store(&snapshot->consumed, 1);
+	return;
+    }
+    unsigned int num_of_params = snapshot->num_of_params;
+    if(num_of_params > param_container->num_of_params_rt)num_of_params = param_container->num_of_params_rt;
+    for(int i = 0; i < num_of_params; i++){
+	PRM_PARAM* cur_param = &(param_container->rt_params[i]);
+	if(cur_param->val == snapshot->vals[i])continue;
+	param_set_value_directly(cur_param, NULL, snapshot->vals[i], NULL, Operation_SetValue);
+	cur_param->change_frame = 0;
+	param_mark_if_changed(param_container, i, 1);
+    }
+    //the [main-thread] can free the snapshot now
+    atomic_store(&snapshot->consumed, 1);
+}
 
+//free the sent snapshots the [audio-thread] is done with, if force == 1 free all of them. Use only on [main-thread]
+static void param_snapshots_free_sent(PRM_CONTAIN* param_container, unsigned int force){
+    PRM_SNAPSHOT** link = &(param_container->snapshots_sent);
+    while(*link){
+	PRM_SNAPSHOT* snapshot = *link;
+	if(force == 0 && atomic_load(&snapshot->consumed) == 0){
+	    link = &(snapshot->next);
+	    continue;
+	}
+	*link = snapshot->next;
+	free(snapshot);
+    }
+}
+
+void param_msgs_process(PRM_RINGS* param_rings, unsigned int rt_params){
+    if(!param_rings)return;
+
+    RING_BUFFER* ring_buffer = param_rings->param_rt_to_ui;
+    MSG_RING* string_ring = param_rings->string_rt_to_ui;
+    if(rt_params){
+	ring_buffer = param_rings->param_ui_to_rt;
+	string_ring = param_rings->string_ui_to_rt;
+    }
+    if(!ring_buffer || !string_ring)return;
+
+    //read the messages in batches, that are there at the start, so the other thread can not keep this loop going
     unsigned int cur_items = ring_buffer_return_items(ring_buffer);
-    for(unsigned int i = 0; i < cur_items; i++){
-	PARAM_RING_DATA_BIT cur_bit;
-	int read_buffer = ring_buffer_read(ring_buffer, &cur_bit, sizeof(cur_bit));
-	if(read_buffer <= 0)continue;
-	param_set_value_directly(&(prm_array[cur_bit.param_id]), cur_bit.param_value, cur_bit.param_string, cur_bit.param_op);
-    }    
-    
+    PARAM_RING_DATA_BIT batch[PARAM_READ_BATCH];
+    while(cur_items > 0){
+	unsigned int want = cur_items;
+	if(want > PARAM_READ_BATCH)want = PARAM_READ_BATCH;
+	int read_items = ring_buffer_read_batch(ring_buffer, batch, sizeof(PARAM_RING_DATA_BIT), want);
+	if(read_items <= 0)break;
+	cur_items -= (unsigned int)read_items;
+	for(int i = 0; i < read_items; i++){
+	    PARAM_RING_DATA_BIT* cur_bit = &(batch[i]);
+	    if(cur_bit->cont_id >= MAX_PARAM_RING_CONTAINERS)continue;
+	    //the container could be removed already, then the message is dropped
+	    PRM_CONTAIN* cont = atomic_load(&param_rings->conts[cur_bit->cont_id]);
+	    if(!cont)continue;
+	    //the snapshot is set in its place among the messages, so the changes sent after it win
+	    if(cur_bit->param_op == Operation_Snapshot){
+		if(rt_params)param_snapshot_apply_rt(cont, cur_bit->param_frame);
+		continue;
+	    }
+	    PRM_PARAM* prm_array = cont->ui_params;
+	    if(rt_params)prm_array = cont->rt_params;
+	    param_set_value_directly(&(prm_array[cur_bit->param_id]), NULL, cur_bit->param_value, NULL, cur_bit->param_op);
+	    //the [audio-thread] keeps the frame so the change can be placed in the block
+	    if(rt_params)prm_array[cur_bit->param_id].change_frame = cur_bit->param_frame;
+	    param_mark_if_changed(cont, cur_bit->param_id, rt_params);
+	}
+    }
+    //the strings are used right in the message ring memory, the message is released after the string is copied to the parameter name
+    unsigned int msg_size = 0;
+    const PARAM_RING_STRING_BIT* str_bit = NULL;
+    while((str_bit = (const PARAM_RING_STRING_BIT*)msg_ring_peek(string_ring, &msg_size)) != NULL){
+	if(msg_size <= sizeof(PARAM_RING_STRING_BIT) || str_bit->cont_id >= MAX_PARAM_RING_CONTAINERS){
+	    msg_ring_release(string_ring);
+	    continue;
+	}
+	PRM_CONTAIN* cont = atomic_load(&param_rings->conts[str_bit->cont_id]);
+	if(cont){
+	    PRM_PARAM* prm_array = cont->ui_params;
+	    PRM_PARAM_NAME* name_array = cont->ui_names;
+	    if(rt_params){
+		prm_array = cont->rt_params;
+		name_array = cont->rt_names;
+	    }
+	    const char* param_string = (const char*)str_bit + sizeof(PARAM_RING_STRING_BIT);
+	    param_set_value_directly(&(prm_array[str_bit->param_id]), &(name_array[str_bit->param_id]), 0, param_string, str_bit->param_op);
+	    param_mark_if_changed(cont, str_bit->param_id, rt_params);
+	}
+	msg_ring_release(string_ring);
+    }
+
+    //now that the other thread had time to read, send the values that did not fit before
+    param_flush_pending(param_rings, rt_params);
+    if(rt_params){
+	//after this the [main-thread] knows this read does not touch the removed containers anymore
+	atomic_fetch_add(&param_rings->rt_reads, 1);
+	return;
+    }
+    for(unsigned int i = 0; i < MAX_PARAM_RING_CONTAINERS; i++){
+	PRM_CONTAIN* cont = atomic_load(&param_rings->conts[i]);
+	if(!cont)continue;
+	param_snapshots_free_sent(cont, 0);
+    }
+    param_rings_free_retired(param_rings, 0);
+}
+
+PRM_SNAPSHOT* param_snapshot_init(PRM_CONTAIN* param_container){
+    if(!param_container)return NULL;
+    unsigned int num_of_params = param_container->num_of_params_ui;
+    //the values are in the same allocation, right after the struct
+    PRM_SNAPSHOT* snapshot = malloc(sizeof(PRM_SNAPSHOT) + sizeof(PARAM_T) * num_of_params);
+    if(!snapshot)return NULL;
+    snapshot->num_of_params = num_of_params;
+    snapshot->vals = (PARAM_T*)(snapshot + 1);
+    atomic_init(&snapshot->consumed, 0);
+    snapshot->next = NULL;
+    for(int i = 0; i < num_of_params; i++){
+	snapshot->vals[i] = param_container->ui_params[i].val;
+    }
+    return snapshot;
+}
+
+int param_snapshot_set_value(PRM_SNAPSHOT* snapshot, int val_id, PARAM_T set_to){
+    if(!snapshot)return -1;
+    if(isnan(set_to))return -1;
+    if(val_id < 0 || val_id >= snapshot->num_of_params)return -1;
+    snapshot->vals[val_id] = set_to;
+    return 0;
+}
+
+int param_snapshot_publish(PRM_CONTAIN* param_container, PRM_SNAPSHOT* snapshot){
+    if(!snapshot)return -1;
+    if(!param_container || !param_container->param_rings || snapshot->num_of_params != param_container->num_of_params_ui){
+	free(snapshot);
+	return -1;
+    }
+    PRM_RINGS* param_rings = param_container->param_rings;
+    //the ui_params get the values right away, the snapshot keeps the values after clamping so both threads have the same values
+    for(int i = 0; i < snapshot->num_of_params; i++){
+	PRM_PARAM* cur_param = &(param_container->ui_params[i]);
+	param_set_value_directly(cur_param, NULL, snapshot->vals[i], NULL, Operation_SetValue);
+	param_mark_if_changed(param_container, i, 0);
+	snapshot->vals[i] = cur_param->val;
+    }
+    atomic_store(&snapshot->consumed, 0);
+    param_container->snapshot_seq += 1;
+    snapshot->seq = param_container->snapshot_seq;
+    snapshot->next = param_container->snapshots_sent;
+    param_container->snapshots_sent = snapshot;
+    //a snapshot that the [audio-thread] did not take yet is replaced, it will never be taken so it can be freed
+    //the snapshot has to be pending before its message is in the ring
+    PRM_SNAPSHOT* replaced = atomic_exchange(&param_container->snapshot_pending, snapshot);
+    if(replaced)atomic_store(&replaced->consumed, 1);
+    //the ring is full, the message is sent from param_msgs_process before the values that wait in pending_ui
+    if(param_container->snapshot_unsent == 1 || param_send_snapshot(param_container) != 1){
+	param_container->snapshot_unsent = 1;
+	param_rings->pending_from_ui = 1;
+    }
+    return 0;
+}
+
+void param_snapshot_clean(PRM_SNAPSHOT* snapshot){
+    if(!snapshot)return;
+    free(snapshot);
 }
 
 int param_set_value(PRM_CONTAIN* param_container, int val_id, PARAM_T set_to, const char* set_string_to, unsigned char param_op, unsigned int rt_params){
     if(!param_container)return -1;
     if(isnan(set_to))return -1;
+    PRM_RINGS* param_rings = param_container->param_rings;
+    if(!param_rings)return -1;
     PRM_PARAM* param_array = NULL;
+    PRM_PARAM_NAME* name_array = NULL;
     RING_BUFFER* ring_buffer = NULL;
+    MSG_RING* string_ring = NULL;
     int num_of_params = -1;
     if(rt_params == 0){
 	param_array = param_container->ui_params;
+	name_array = param_container->ui_names;
 	num_of_params = param_container->num_of_params_ui;
-	ring_buffer = param_container->param_ui_to_rt;
+	ring_buffer = param_rings->param_ui_to_rt;
+	string_ring = param_rings->string_ui_to_rt;
     }
     if(rt_params == 1){
 	param_array = param_container->rt_params;
+	name_array = param_container->rt_names;
 	num_of_params = param_container->num_of_params_rt;
-	ring_buffer = param_container->param_rt_to_ui;
+	ring_buffer = param_rings->param_rt_to_ui;
+	string_ring = param_rings->string_rt_to_ui;
     }
-    if(val_id >= num_of_params || !param_array || !ring_buffer)return -1;
+    if(val_id >= num_of_params || !param_array || !name_array || !ring_buffer || !string_ring)return -1;
 
     PRM_PARAM* cur_param = &(param_array[val_id]);
-    param_set_value_directly(cur_param, set_to, set_string_to, param_op);
+    param_set_value_directly(cur_param, &(name_array[val_id]), set_to, set_string_to, param_op);
+    param_mark_if_changed(param_container, val_id, rt_params);
+    //a change made on the [audio-thread] itself happens at the start of the block
+    if(rt_params == 1)cur_param->change_frame = 0;
+    //strings go through their own ring, so the value messages stay small
+    if(param_op == Operation_ChangeName){
+	if(!set_string_to || param_ui_name_changed(param_container, val_id, rt_params) != 1)return 0;
+	//the string is written right after the message header, only as long as it is
+	unsigned int str_size = (unsigned int)strnlen(set_string_to, MAX_PARAM_NAME_LENGTH - 1) + 1;
+	PARAM_RING_STRING_BIT* send_bit = (PARAM_RING_STRING_BIT*)msg_ring_reserve(string_ring, sizeof(PARAM_RING_STRING_BIT) + str_size);
+	if(!send_bit)return 0;
+	send_bit->param_id = val_id;
+	send_bit->cont_id = param_container->cont_id;
+	send_bit->param_op = param_op;
+	char* send_string = (char*)send_bit + sizeof(PARAM_RING_STRING_BIT);
+	memcpy(send_string, set_string_to, str_size - 1);
+	send_string[str_size - 1] = '\0';
+	msg_ring_commit(string_ring, sizeof(PARAM_RING_STRING_BIT) + str_size);
+	return 0;
+    }
     //only send the change to the other thread if the parameter actually changed its value
-    if(param_get_if_changed(param_container, val_id, rt_params) == 1 || param_ui_name_changed(param_container, val_id, rt_params) == 1){
-	PARAM_RING_DATA_BIT send_bit;
-	send_bit.param_id = val_id;
-	send_bit.param_op = param_op;
-	if(set_string_to)
-	    snprintf(send_bit.param_string, MAX_PARAM_NAME_LENGTH, "%s", set_string_to);
-	send_bit.param_value = set_to;
-	ring_buffer_write(ring_buffer, &send_bit, sizeof(send_bit));
+    if(param_get_if_changed(param_container, val_id, rt_params) != 1)return 0;
+    uint64_t* pending_bits = param_container->pending_ui;
+    unsigned int* pending_flag = &(param_rings->pending_from_ui);
+    if(rt_params == 1){
+	pending_bits = param_container->pending_rt;
+	pending_flag = &(param_rings->pending_from_rt);
+    }
+    uint64_t val_bit = (uint64_t)1 << (val_id % CHANGED_WORD_BITS);
+    unsigned int value_op = (param_op == Operation_SetValue || param_op == Operation_Increase || param_op == Operation_Decrease || param_op == Operation_DefValue);
+    //the value is already waiting to be sent, it will go with the newest value
+    if(value_op && (pending_bits[val_id / CHANGED_WORD_BITS] & val_bit) != 0)return 0;
+    //the snapshot message is still waiting for the ring, the value has to go after it
+    if(value_op && rt_params == 0 && param_container->snapshot_unsent == 1){
+	pending_bits[val_id / CHANGED_WORD_BITS] |= val_bit;
+	*pending_flag = 1;
+	return 0;
+    }
+    if(param_send_value(param_container, val_id, set_to, param_op, rt_params) == 1)return 0;
+    //the ring is full, keep only the last value of the parameter and send it from param_msgs_process
+    //changes that are not values (increments, default values etc.) are rare and are dropped if the ring is full
+    if(value_op){
+	pending_bits[val_id / CHANGED_WORD_BITS] |= val_bit;
+	*pending_flag = 1;
     }
     return 0;    
 }
+int param_set_value_normalized(PRM_CONTAIN* param_container, int val_id, PARAM_T norm_val, unsigned int rt_params){
+    if(!param_container)return -1;
+    if(isnan(norm_val))return -1;
+    if(val_id < 0 || val_id >= (int)param_return_num_params(param_container, rt_params))return -1;
+    PRM_PARAM* cur_param = &(param_container->ui_params[val_id]);
+    if(rt_params == 1)cur_param = &(param_container->rt_params[val_id]);
+    if(norm_val < 0)norm_val = 0;
+    if(norm_val > 1)norm_val = 1;
+    PARAM_T set_to = cur_param->min_val + norm_val * (cur_param->max_val - cur_param->min_val);
+    return param_set_value(param_container, val_id, set_to, NULL, Operation_SetValue, rt_params);
+}
+
 int param_user_data_return(PRM_CONTAIN* param_container, int val_id, PRM_USER_DATA* user_data, unsigned int rt_params){
     if(!param_container)return -1;
-    PRM_PARAM* param_array = NULL;
-    int num_of_params = -1;
-    if(rt_params == 0){
-	param_array = param_container->ui_params;
-	num_of_params = param_container->num_of_params_ui;
-    }
-    if(rt_params == 1){
-	param_array = param_container->rt_params;
-	num_of_params = param_container->num_of_params_rt;
-    }
+    int num_of_params = (int)param_return_num_params(param_container, rt_params);
     if(val_id >= num_of_params)return -1;
 
-    PRM_PARAM cur_param = param_array[val_id];
-    *user_data = cur_param.user_data;
+    *user_data = param_container->param_info[val_id].user_data;
     return 0;
 }
 PARAM_T param_get_increment(PRM_CONTAIN* param_container, int val_id, unsigned int rt_params){
@@ -356,9 +874,9 @@ PARAM_T param_get_increment(PRM_CONTAIN* param_container, int val_id, unsigned i
     }
     if(val_id >= num_of_params)return -1;
 
-    PRM_PARAM cur_param = param_array[val_id];
+    PRM_PARAM* cur_param = &(param_array[val_id]);
 
-    PARAM_T ret_increment = cur_param.inc_am;
+    PARAM_T ret_increment = cur_param->inc_am;
     
     return ret_increment;
 }
@@ -382,6 +900,19 @@ static unsigned char param_get_val_type(PRM_CONTAIN* param_container, int val_id
     return cur_param->val_type;
 }
 
+//return the parameter value from its curve_table, or the value itself if the parameter has no curve
+static PARAM_T param_curve_value(PRM_PARAM* cur_param, PARAM_T ret_val){
+    if(!cur_param->curve_table)return ret_val;
+    PARAM_T val_min = cur_param->min_val;
+    PARAM_T val_max = cur_param->max_val;
+    //first make the param range 0..1
+    PARAM_T val_norm = fit_range(val_max, val_min, 1.0, 0.0, ret_val);
+    //now get what this value is in the table
+    PARAM_T val_curve = math_range_table_convert_value(cur_param->curve_table, val_norm);
+    //and return to the original range
+    return fit_range(1.0, 0.0, val_max, val_min, val_curve);
+}
+
 PARAM_T param_get_value(PRM_CONTAIN* param_container, int val_id, unsigned int curved, unsigned int interp, unsigned int rt_params){
     if(!param_container)return -1;
     PRM_PARAM* param_array = NULL;
@@ -398,23 +929,11 @@ PARAM_T param_get_value(PRM_CONTAIN* param_container, int val_id, unsigned int c
     if(!param_array)return -1;
     PRM_PARAM* cur_param = &(param_array[val_id]);
     //when returning the value we mark this param as no longer just_changed
-    cur_param->just_changed = 0;
+    param_clear_changed(param_container, val_id, rt_params);
 
     PARAM_T ret_val = cur_param->val;
     //check if this parameter is of exponential or other curve nature
-    if(curved == 1){
-	if(cur_param->curve_table){
-	    //if there is a curve table
-	    PARAM_T val_min = cur_param->min_val;
-	    PARAM_T val_max = cur_param->max_val;
-	    //first make the param range 0..1
-	    PARAM_T val_norm = fit_range(val_max, val_min, 1.0, 0.0, ret_val);
-	    //now get what this value is in the table
-	    PARAM_T val_curve = math_range_table_convert_value(cur_param->curve_table, val_norm);
-	    //and return to the original range
-	    ret_val = fit_range(1.0, 0.0, val_max, val_min, val_curve);
-	}
-    }
+    if(curved == 1)ret_val = param_curve_value(cur_param, ret_val);
     
     //if user wants to interpolate the value and not return it right away
     if(interp == 1){
@@ -425,56 +944,153 @@ PARAM_T param_get_value(PRM_CONTAIN* param_container, int val_id, unsigned int c
     return ret_val;
 }
 
+int param_set_ramp(PRM_CONTAIN* param_container, int val_id, unsigned char ramp_type, PARAM_T ramp_ms, SAMPLE_T samplerate){
+    if(!param_container)return -1;
+    if(val_id < 0 || val_id >= param_container->num_of_params_rt)return -1;
+    if(samplerate <= 0)return -1;
+    if(!param_container->rt_ramps){
+	param_container->rt_ramps = calloc(param_container->num_of_params_rt, sizeof(PRM_RAMP));
+	if(!param_container->rt_ramps)return -1;
+    }
+    PRM_RAMP* ramp = &(param_container->rt_ramps[val_id]);
+    ramp->ramp_type = ramp_type;
+    if(ramp_ms < 0)ramp_ms = 0;
+    PARAM_T ramp_len = (ramp_ms * 0.001) * (PARAM_T)samplerate;
+    ramp->ramp_samples = (unsigned int)ramp_len;
+    //after ramp_ms the one pole ramp is ~63% of the way to the target
+    ramp->coef = 1.0;
+    if(ramp_len >= 1)ramp->coef = 1.0 - exp(-1.0 / ramp_len);
+    ramp->samples_left = 0;
+    ramp->started = 0;
+    return 0;
+}
+
+int param_get_change_offset_rt(PRM_CONTAIN* param_container, int val_id, uint32_t cycle_frame, unsigned int nframes){
+    if(!param_container)return 0;
+    if(val_id < 0 || val_id >= param_container->num_of_params_rt)return 0;
+    if(nframes == 0)return 0;
+    uint32_t change_frame = param_container->rt_params[val_id].change_frame;
+    if(change_frame == 0)return 0;
+    //the message was sent during the previous cycle, so a buffer later it lands at the same spot in this one
+    //the difference is signed so the offset is right when the clock wraps around
+    int32_t offset = (int32_t)(change_frame + (uint32_t)nframes - cycle_frame);
+    if(offset < 0)return 0;
+    if(offset >= (int32_t)nframes)return (int)nframes - 1;
+    return (int)offset;
+}
+
+//run the ramp towards to_val for nframes and write it to ramp_buffer, returns 1 if the ramp moved
+static int param_ramp_run(PRM_RAMP* ramp, PRM_PARAM* cur_param, PARAM_T to_val, SAMPLE_T* ramp_buffer, unsigned int nframes){
+    int moving = 0;
+    if(ramp->ramp_type == Ramp_Linear){
+	//a new target starts the ramp again from where it is now
+	if(to_val != ramp->to_val){
+	    ramp->to_val = to_val;
+	    ramp->samples_left = ramp->ramp_samples;
+	    if(ramp->samples_left == 0)ramp->cur_val = to_val;
+	    else ramp->inc = (to_val - ramp->cur_val) / (PARAM_T)ramp->samples_left;
+	}
+	unsigned int run = ramp->samples_left;
+	if(run > nframes)run = nframes;
+	PARAM_T start_val = ramp->cur_val;
+	PARAM_T inc = ramp->inc;
+	unsigned int j = 0;
+	for(; j < run; j++)ramp_buffer[j] = (SAMPLE_T)(start_val + inc * (PARAM_T)(j + 1));
+	ramp->samples_left -= run;
+	ramp->cur_val = start_val + inc * (PARAM_T)run;
+	if(ramp->samples_left == 0)ramp->cur_val = ramp->to_val;
+	for(; j < nframes; j++)ramp_buffer[j] = (SAMPLE_T)ramp->cur_val;
+	if(run > 0)moving = 1;
+    }
+    if(ramp->ramp_type == Ramp_OnePole){
+	ramp->to_val = to_val;
+	PARAM_T cur_val = ramp->cur_val;
+	if(cur_val != to_val){
+	    PARAM_T coef = ramp->coef;
+	    for(unsigned int j = 0; j < nframes; j++){
+		cur_val += coef * (to_val - cur_val);
+		ramp_buffer[j] = (SAMPLE_T)cur_val;
+	    }
+	    //close enough, stop the ramp so it does not crawl into subnormals
+	    if(fabs(to_val - cur_val) <= fabs(cur_param->max_val - cur_param->min_val) * RAMP_SNAP_RANGE)cur_val = to_val;
+	    ramp->cur_val = cur_val;
+	    moving = 1;
+	}
+	else{
+	    for(unsigned int j = 0; j < nframes; j++)ramp_buffer[j] = (SAMPLE_T)to_val;
+	}
+    }
+    return moving;
+}
+
+int param_fill_ramp_rt(PRM_CONTAIN* param_container, int val_id, unsigned int curved, SAMPLE_T* ramp_buffer, unsigned int nframes, unsigned int start_frame){
+    if(!param_container)return -1;
+    if(!ramp_buffer)return -1;
+    if(val_id < 0 || val_id >= param_container->num_of_params_rt)return -1;
+    PRM_PARAM* cur_param = &(param_container->rt_params[val_id]);
+    PARAM_T to_val = cur_param->val;
+    if(curved == 1)to_val = param_curve_value(cur_param, to_val);
+
+    PRM_RAMP* ramp = NULL;
+    if(param_container->rt_ramps)ramp = &(param_container->rt_ramps[val_id]);
+    //no ramp on this parameter, the value is constant for the whole block
+    if(!ramp || ramp->ramp_type == 0){
+	for(unsigned int j = 0; j < nframes; j++)ramp_buffer[j] = (SAMPLE_T)to_val;
+	return 0;
+    }
+    if(ramp->started == 0){
+	ramp->cur_val = to_val;
+	ramp->to_val = to_val;
+	ramp->samples_left = 0;
+	ramp->started = 1;
+    }
+    int moving = 0;
+    //a new target starts from start_frame, before that the ramp keeps going to the old target
+    if(start_frame >= nframes)start_frame = 0;
+    if(to_val != ramp->to_val && start_frame > 0){
+	moving = param_ramp_run(ramp, cur_param, ramp->to_val, ramp_buffer, start_frame);
+	ramp_buffer += start_frame;
+	nframes -= start_frame;
+    }
+    if(param_ramp_run(ramp, cur_param, to_val, ramp_buffer, nframes) == 1)moving = 1;
+    return moving;
+}
+
 int param_set_param_strings(PRM_CONTAIN* param_container, int val_id, char** strings, unsigned int num_strings){
     if(!param_container)return -1;
     if(!strings)return -1;
     if(num_strings <= 0)return -1;
     if(val_id >= param_container->num_of_params_ui)return -1;
-    PRM_PARAM* param_array_rt = param_container->rt_params;
-    PRM_PARAM* param_array_ui = param_container->ui_params;
 
-    PRM_PARAM* cur_param_rt = &(param_array_rt[val_id]);
-    PRM_PARAM* cur_param_ui = &(param_array_ui[val_id]);
+    PRM_PARAM* cur_param_ui = &(param_container->ui_params[val_id]);
+    PRM_PARAM_INFO* param_info = &(param_container->param_info[val_id]);
     unsigned char val_type = cur_param_ui->val_type;
     if((val_type & 0xff) != String_Return_Type)return -1;
     //free the strings if there are labels already on this parameter
     //though the labels should be set once, on the param init
-    if(cur_param_rt->param_strings != NULL){
-	free(cur_param_rt->param_strings);
-	cur_param_rt->param_strings_num = 0;
-    }
-    if(cur_param_ui->param_strings != NULL){
-	free(cur_param_ui->param_strings);
-	cur_param_ui->param_strings_num = 0;
+    if(param_info->param_strings != NULL){
+	for(int i = 0; i < param_info->param_strings_num; i++){
+	    if(param_info->param_strings[i])free(param_info->param_strings[i]);
+	}
+	free(param_info->param_strings);
+	param_info->param_strings = NULL;
+	param_info->param_strings_num = 0;
     }
     
-    cur_param_rt->param_strings = malloc(sizeof(char*)*num_strings);
-    if(cur_param_rt->param_strings == NULL)return -1;
-    cur_param_ui->param_strings = malloc(sizeof(char*)*num_strings);
-    if(cur_param_ui->param_strings == NULL){
-	free(cur_param_rt->param_strings);
-	cur_param_rt->param_strings = NULL;
-	return -1;
-    }
-    cur_param_rt->param_strings_num = num_strings;
-    cur_param_ui->param_strings_num = num_strings;
+    param_info->param_strings = malloc(sizeof(char*)*num_strings);
+    if(param_info->param_strings == NULL)return -1;
+    param_info->param_strings_num = num_strings;
     for(int i = 0; i < num_strings; i++){
-	cur_param_rt->param_strings[i] = NULL;
-	cur_param_ui->param_strings[i] = NULL;
+	param_info->param_strings[i] = NULL;
 	const char* cur_string = strings[i];
 	if(!cur_string)continue;
-	char* copy_string_rt = malloc(sizeof(char) * (strlen(cur_string)+1));
-	if(!copy_string_rt)continue;
-	char* copy_string_ui = malloc(sizeof(char) * (strlen(cur_string)+1));
-	if(!copy_string_ui){
-	    free(copy_string_rt);
-	    continue;
-	}
-	strcpy(copy_string_rt, cur_string);
-	strcpy(copy_string_ui, cur_string);
-	cur_param_rt->param_strings[i] = copy_string_rt;
-	cur_param_ui->param_strings[i] = copy_string_ui;
+	char* copy_string = malloc(sizeof(char) * (strlen(cur_string)+1));
+	if(!copy_string)continue;
+	strcpy(copy_string, cur_string);
+	param_info->param_strings[i] = copy_string;
     }
+    //the value string has to show the new label
+    param_container->ui_display[val_id].valid = 0;
     
     return 0;
 }
@@ -493,16 +1109,16 @@ const char* param_get_param_string(PRM_CONTAIN* param_container, int val_id, uns
     }
     if(val_id >= num_of_params)return NULL;
 
-    PRM_PARAM cur_param = param_array[val_id];
-    int cur_val = (int)cur_param.val;
-    if(cur_val > cur_param.max_val || cur_val < cur_param.min_val)return NULL;
-    if(cur_param.param_strings_num <= 0 || cur_val >= cur_param.param_strings_num || cur_val < 0)return NULL;
+    PRM_PARAM* cur_param = &(param_array[val_id]);
+    PRM_PARAM_INFO* param_info = &(param_container->param_info[val_id]);
+    int cur_val = (int)cur_param->val;
+    if(cur_val > cur_param->max_val || cur_val < cur_param->min_val)return NULL;
+    if(param_info->param_strings_num <= 0 || cur_val >= param_info->param_strings_num || cur_val < 0)return NULL;
     
-    return cur_param.param_strings[cur_val];
+    return param_info->param_strings[cur_val];
 }
-unsigned int param_get_value_as_string(PRM_CONTAIN* param_container, int val_id, char* ret_string, uint32_t string_len){
-    if(string_len == 0)return 0;
-    if(!ret_string)return 0;
+//format the parameter value for the ui to ret_string, returns 1 if successful
+static unsigned int param_format_value(PRM_CONTAIN* param_container, int val_id, char* ret_string, uint32_t string_len){
     unsigned char val_type = 0;
     val_type = param_get_val_type(param_container, val_id, 0);
     if(val_type == 0)return 0;
@@ -536,6 +1152,38 @@ unsigned int param_get_value_as_string(PRM_CONTAIN* param_container, int val_id,
     return 1;
 }
 
+const char* param_get_value_string(PRM_CONTAIN* param_container, int val_id){
+    if(!param_container)return NULL;
+    if(val_id < 0 || val_id >= param_container->num_of_params_ui)return NULL;
+    PRM_PARAM_DISPLAY* display = &(param_container->ui_display[val_id]);
+    PARAM_T cur_val = param_container->ui_params[val_id].val;
+    //the ui read the value, so it is not just_changed anymore, even if the cached string is returned without formatting the value again
+    param_clear_changed(param_container, val_id, 0);
+    if(display->valid == 1 && display->shown_val == cur_val)return display->val_string;
+
+    display->valid = 0;
+    if(param_format_value(param_container, val_id, display->val_string, MAX_PARAM_VALUE_STRING) != 1)return NULL;
+    display->shown_val = cur_val;
+    display->valid = 1;
+    return display->val_string;
+}
+
+void param_value_strings_invalidate(PRM_CONTAIN* param_container){
+    if(!param_container)return;
+    for(int i = 0; i < param_container->num_of_params_ui; i++){
+	param_container->ui_display[i].valid = 0;
+    }
+}
+
+unsigned int param_get_value_as_string(PRM_CONTAIN* param_container, int val_id, char* ret_string, uint32_t string_len){
+    if(string_len == 0)return 0;
+    if(!ret_string)return 0;
+    const char* val_string = param_get_value_string(param_container, val_id);
+    if(!val_string)return 0;
+    snprintf(ret_string, string_len, "%s", val_string);
+    return 1;
+}
+
 int param_get_if_changed(PRM_CONTAIN* param_container, int val_id, unsigned int rt_params){
     if(!param_container)return -1;
     PRM_PARAM* param_array = NULL;
@@ -550,23 +1198,42 @@ int param_get_if_changed(PRM_CONTAIN* param_container, int val_id, unsigned int
     }
     if(val_id >= num_of_params)return -1;
 
-    PRM_PARAM cur_param = param_array[val_id];
-    return cur_param.just_changed;
+    return param_array[val_id].just_changed;
 }
 
 int param_get_if_any_changed(PRM_CONTAIN* param_container, unsigned int rt_params){
     if(!param_container)return -1;
-    int params_changed = 0;
-    unsigned int num_params = param_return_num_params(param_container, rt_params);
-    if(num_params<=0)return -1;
-    for(int i=0; i < num_params; i++){
-	int changed = param_get_if_changed(param_container, i, rt_params);
-	if(changed == 1){
-	    params_changed = 1;
-	    break;
+    if(param_return_num_params(param_container, rt_params) <= 0)return -1;
+    uint64_t* changed_bits = param_container->changed_ui;
+    if(rt_params == 1)changed_bits = param_container->changed_rt;
+    for(unsigned int i = 0; i < param_container->changed_words; i++){
+	if(changed_bits[i] != 0)return 1;
+    }
+    return 0;
+}
+
+int param_next_changed(PRM_CONTAIN* param_container, int from_id, unsigned int rt_params){
+    if(!param_container)return -1;
+    if(from_id < 0)from_id = 0;
+    int num_of_params = (int)param_return_num_params(param_container, rt_params);
+    if(from_id >= num_of_params)return -1;
+    uint64_t* changed_bits = param_container->changed_ui;
+    if(rt_params == 1)changed_bits = param_container->changed_rt;
+
+    unsigned int word = from_id / CHANGED_WORD_BITS;
+    //mask out the parameters before from_id in the first word
+    uint64_t cur_bits = changed_bits[word] & (~(uint64_t)0 << (from_id % CHANGED_WORD_BITS));
+    while(1){
+	if(cur_bits != 0){
+	    int val_id = (int)(word * CHANGED_WORD_BITS) + __builtin_ctzll(cur_bits);
+	    if(val_id >= num_of_params)return -1;
+	    return val_id;
 	}
+	word += 1;
+	if(word >= param_container->changed_words)return -1;
+	cur_bits = changed_bits[word];
     }
-    return params_changed;
+    return -1;
 }
 
 unsigned int param_is_hidden(PRM_CONTAIN* param_container, int val_id, unsigned int rt_params){
@@ -584,73 +1251,64 @@ unsigned int param_is_hidden(PRM_CONTAIN* param_container, int val_id, unsigned
     if(!param_array)return 0;
     if(val_id >= num_of_params)return 0;
     
-    PRM_PARAM cur_param = param_array[val_id];
-    return cur_param.is_hidden;
+    return param_array[val_id].is_hidden;
 }
 
 unsigned int param_ui_name_changed(PRM_CONTAIN* param_container, int val_id, unsigned int rt_params){
     if(!param_container)return 0;
-    PRM_PARAM* param_array = NULL;
+    PRM_PARAM_NAME* name_array = NULL;
     int num_of_params = -1;
     if(rt_params == 0){
-	param_array = param_container->ui_params;
+	name_array = param_container->ui_names;
 	num_of_params = param_container->num_of_params_ui;
     }
     if(rt_params == 1){
-	param_array = param_container->rt_params;
+	name_array = param_container->rt_names;
 	num_of_params = param_container->num_of_params_rt;
     }
-    if(!param_array)return 0;
+    if(!name_array)return 0;
     if(val_id >= num_of_params)return 0;
-    PRM_PARAM* cur_param = &(param_array[val_id]);
-    unsigned int just_changed = cur_param->ui_name_just_changed;
+    PRM_PARAM_NAME* cur_name = &(name_array[val_id]);
+    unsigned int just_changed = cur_name->ui_name_just_changed;
     return just_changed;
 }
 
 unsigned int param_get_ui_name(PRM_CONTAIN* param_container, int val_id, char* ret_name, uint32_t name_len){
     if(!param_container)return 0;
-    PRM_PARAM* param_array = param_container->ui_params;
+    PRM_PARAM_NAME* name_array = param_container->ui_names;
     int num_of_params = param_container->num_of_params_ui;
     
     if(val_id >= num_of_params)return 0;
 
-    PRM_PARAM* cur_param = &(param_array[val_id]);
-    snprintf(ret_name, name_len, "%s", cur_param->ui_name);
-    cur_param->ui_name_just_changed = 0;
+    PRM_PARAM_NAME* cur_name = &(name_array[val_id]);
+    snprintf(ret_name, name_len, "%s", cur_name->ui_name);
+    cur_name->ui_name_just_changed = 0;
     return 1;
 }
 
 unsigned int param_get_name(PRM_CONTAIN* param_container, int val_id, char* ret_name, uint32_t name_len){
     if(!param_container)return 0;
-    PRM_PARAM* param_array = param_container->ui_params;
     int num_of_params = param_container->num_of_params_ui;
     
     if(val_id >= num_of_params)return 0;
 
-    PRM_PARAM* cur_param = &(param_array[val_id]);
-    snprintf(ret_name, name_len, "%s", cur_param->name);
+    snprintf(ret_name, name_len, "%s", param_container->param_info[val_id].name);
     return 1;
 }
 
 int param_find_name(PRM_CONTAIN* param_container, const char* param_name, unsigned int rt_params){
     if(!param_container)return -1;
     if(!param_name)return -1;
-    PRM_PARAM* param_array = NULL;
-    int num_of_params = -1;
-    if(rt_params == 0){
-	param_array = param_container->ui_params;
-	num_of_params = param_container->num_of_params_ui;
-    }
-    if(rt_params == 1){
-	param_array = param_container->rt_params;
-	num_of_params = param_container->num_of_params_rt;
-    }
-
-    for(int i = 0; i < num_of_params; i++){
-	const char* cur_name = param_array[i].name;
-	if(strcmp(param_name, cur_name)==0){
-	    return i;
+    if(!param_container->name_index)return -1;
+    unsigned int index_mask = param_container->name_index_size - 1;
+    unsigned int slot = param_name_hash(param_name) & index_mask;
+    //the index always has empty slots, so the probe ends
+    while(param_container->name_index[slot] != -1){
+	int id = param_container->name_index[slot];
+	if(strcmp(param_name, param_container->param_info[id].name)==0){
+	    return id;
 	}
+	slot = (slot + 1) & index_mask;
     }
     return -1;
 }
@@ -671,24 +1329,64 @@ unsigned int param_return_num_params(PRM_CONTAIN* param_container, unsigned int
 static void param_clean_param(PRM_PARAM* param){
     if(!param)return;
     if(param->interp_val)free(param->interp_val);
-    if(param->param_strings){
-	for(int j = 0; j < param->param_strings_num; j++){
-	    if(param->param_strings[j])free(param->param_strings[j]);
+}
+
+static void param_clean_param_info(PRM_PARAM_INFO* param_info){
+    if(!param_info)return;
+    if(param_info->param_strings){
+	for(int j = 0; j < param_info->param_strings_num; j++){
+	    if(param_info->param_strings[j])free(param_info->param_strings[j]);
 	}
-	free(param->param_strings);
+	free(param_info->param_strings);
     }
 }
 
-void param_clean_param_container(PRM_CONTAIN* param_container){
+static void param_free_param_container(PRM_CONTAIN* param_container){
     if(!param_container)return;
     for(int i = 0; i < param_container->num_of_params_ui; i++){
-	param_clean_param(&(param_container->rt_params[i]));
-	param_clean_param(&(param_container->ui_params[i]));
+	if(param_container->rt_params)param_clean_param(&(param_container->rt_params[i]));
+	if(param_container->ui_params)param_clean_param(&(param_container->ui_params[i]));
+	if(param_container->param_info)param_clean_param_info(&(param_container->param_info[i]));
     }	
-    ring_buffer_clean(param_container->param_rt_to_ui);
-    ring_buffer_clean(param_container->param_ui_to_rt);
     if(param_container->rt_params)free(param_container->rt_params);
     if(param_container->ui_params)free(param_container->ui_params);
+    if(param_container->rt_names)free(param_container->rt_names);
+    if(param_container->ui_names)free(param_container->ui_names);
+    if(param_container->param_info)free(param_container->param_info);
+    if(param_container->ui_display)free(param_container->ui_display);
+    if(param_container->name_index)free(param_container->name_index);
+    if(param_container->rt_ramps)free(param_container->rt_ramps);
+    if(param_container->changed_rt)free(param_container->changed_rt);
+    if(param_container->changed_ui)free(param_container->changed_ui);
+    if(param_container->pending_rt)free(param_container->pending_rt);
+    if(param_container->pending_ui)free(param_container->pending_ui);
+    //the container is not reachable from the [audio-thread] anymore, so its snapshots can be freed even if not consumed
+    param_snapshots_free_sent(param_container, 1);
     
     free(param_container);
 }
+
+void param_clean_param_container(PRM_CONTAIN* param_container){
+    if(!param_container)return;
+    PRM_RINGS* param_rings = param_container->param_rings;
+    //the container was not added to the param_rings yet, so nothing can send messages to it
+    if(!param_rings){
+	param_free_param_container(param_container);
+	return;
+    }
+    //the [audio-thread] might be reading the rings right now, so only stop new messages from reaching the container
+    //and free it later in param_msgs_process
+    atomic_store(&param_rings->conts[param_container->cont_id], NULL);
+    param_container->retired_at = atomic_load(&param_rings->rt_reads);
+    param_rings->retired[param_container->cont_id] = param_container;
+}
+
+void param_clean_param_rings(PRM_RINGS* param_rings){
+    if(!param_rings)return;
+    param_rings_free_retired(param_rings, 1);
+    if(param_rings->param_rt_to_ui)ring_buffer_clean(param_rings->param_rt_to_ui);
+    if(param_rings->param_ui_to_rt)ring_buffer_clean(param_rings->param_ui_to_rt);
+    if(param_rings->string_rt_to_ui)msg_ring_clean(param_rings->string_rt_to_ui);
+    if(param_rings->string_ui_to_rt)msg_ring_clean(param_rings->string_ui_to_rt);
+    free(param_rings);
+}
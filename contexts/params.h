@@ -7,6 +7,10 @@ typedef struct _params_interp_val PRM_INTERP_VAL;
 typedef struct _params_container PRM_CONTAIN;
 //parameter
 typedef struct _params_param PRM_PARAM;
+//ring buffers for the parameter messages between [main-thread] and [audio-thread], one per context, shared by all its parameter containers
+typedef struct _params_rings PRM_RINGS;
+//all the parameter values of a container, built on [main-thread] and given to the [audio-thread] at once
+typedef struct _params_snapshot PRM_SNAPSHOT;
 //struct that holds user data per parameter
 //void data, special ids, etc.
 typedef struct _param_user_data{
@@ -26,17 +30,37 @@ typedef struct _params_cont_user_data{
 PRM_INTERP_VAL* params_init_interpolated_val(PARAM_T max_range, unsigned int total_samples);
 //interpolate the value and get the cur val
 PARAM_T params_interp_val_get_value(PRM_INTERP_VAL* intrp_val, PARAM_T new_val);
+//init the parameter rings for a context, should be done before any parameter container of the context is created
+//frame_time returns the current frame of the audio clock, it stamps the messages to the [audio-thread] so they can be placed in the block
+//frame_time can be NULL, then the changes happen at the start of the block
+PRM_RINGS* params_init_param_rings(uint32_t(*frame_time)(void* clock_data), void* clock_data);
 //initializes the parameter container the parameter value arrays (for min val, names etc) have to be the same size
+//the container will send and get its parameter messages through the param_rings of its context
 PRM_CONTAIN* params_init_param_container(unsigned int num_of_params, char** param_names, PARAM_T* param_vals,
 					 PARAM_T* param_mins, PARAM_T* param_maxs, PARAM_T* param_incs, unsigned char* val_types,
-					 PRM_USER_DATA* user_data_per_param, const PRM_CONT_USER_DATA* user_data_per_container);
+					 PRM_USER_DATA* user_data_per_param, const PRM_CONT_USER_DATA* user_data_per_container, PRM_RINGS* param_rings);
 //add a curve table for exponential, logarithmic etc. parameters
 //should be added in the initialization stage, while the rt thread is not launched, since will add to rt and ui parameters
 int param_add_curve_table(PRM_CONTAIN* param_container, int val_id, MATH_RANGE_TABLE* table);
 //process ring_buffers - set values on ui params when a message says so from rt thread and vise a versa
-void param_msgs_process(PRM_CONTAIN* param_container, unsigned int rt_params);
+//processes the messages for all the containers of the context at once, so call once per cycle on each thread
+//on [main-thread] this also frees the removed containers that the [audio-thread] can no longer reach
+void param_msgs_process(PRM_RINGS* param_rings, unsigned int rt_params);
+//create a snapshot with the current ui values of the container, use only on [main-thread]
+PRM_SNAPSHOT* param_snapshot_init(PRM_CONTAIN* param_container);
+//set a value in the snapshot, nothing is sent until param_snapshot_publish
+int param_snapshot_set_value(PRM_SNAPSHOT* snapshot, int val_id, PARAM_T set_to);
+//set all the snapshot values on the ui parameters and give the snapshot to the [audio-thread] with one pointer swap,
+//so the [audio-thread] gets all the values in the same cycle no matter how many parameters there are (for example when loading a preset)
+//the snapshot is set in order with the other changes of the container, so a change made after the publish is not overwritten by it
+//the snapshot belongs to the container after this, even on error, and is freed in param_msgs_process on [main-thread]
+int param_snapshot_publish(PRM_CONTAIN* param_container, PRM_SNAPSHOT* snapshot);
+//free a snapshot that was not published
+void param_snapshot_clean(PRM_SNAPSHOT* snapshot);
 //set the parameter value. param_op is what to do with parameter, check types.h the paramOperType enum
 int param_set_value(PRM_CONTAIN* param_container, int val_id, PARAM_T set_to, const char* set_string_to, unsigned char param_op, unsigned int rt_params);
+//set the parameter from a 0..1 value that is scaled to the parameter range, for example from a midi cc
+int param_set_value_normalized(PRM_CONTAIN* param_container, int val_id, PARAM_T norm_val, unsigned int rt_params);
 //return the user_data from the param (it is used for convenience - for example in clap plugins a cookie is added for fast retrieval of params from events)
 int param_user_data_return(PRM_CONTAIN* param_container, int val_id, PRM_USER_DATA* user_data, unsigned int rt_params);
 //return the parameter increment amount (by how much the parameter value increases or decreases)
@@ -45,17 +69,38 @@ PARAM_T param_get_increment(PRM_CONTAIN* param_container, int val_id, unsigned i
 //if interp == 1 the value will be interpolated slowly on each param_get_value call (the speed is INTERP_SAMPLES in params.c)
 //if curved == 1 get the value from the curve_table if there is one
 PARAM_T param_get_value(PRM_CONTAIN* param_container, int val_id, unsigned int curved, unsigned int interp, unsigned int rt_params);
+//give the parameter a block ramp for param_fill_ramp_rt, ramp_type is from prmRampType in types.h (0 removes the ramp)
+//ramp_ms is how long the linear ramp takes or the time constant of the one pole ramp
+//should be set in the initialization stage like the curve tables, and again if the samplerate changes
+int param_set_ramp(PRM_CONTAIN* param_container, int val_id, unsigned char ramp_type, PARAM_T ramp_ms, SAMPLE_T samplerate);
+//return the frame in this block where the last change of the [audio-thread] parameter from the [main-thread] should happen
+//cycle_frame is the audio clock frame of the block start, the changes have one buffer of latency so they keep their timing
+//returns 0 for changes without a frame or from earlier blocks. Use only on [audio-thread]
+int param_get_change_offset_rt(PRM_CONTAIN* param_container, int val_id, uint32_t cycle_frame, unsigned int nframes);
+//fill ramp_buffer with nframes of the smoothed [audio-thread] parameter value, the ramp moves the same no matter the buffer size
+//a new target starts ramping from start_frame (for example from param_get_change_offset_rt), 0 to start at the block start
+//if the parameter has no ramp the buffer is filled with the value. Does not change just_changed of the parameter
+//returns 1 if the value is moving in this block, 0 if its constant and -1 on error. Use only on [audio-thread]
+int param_fill_ramp_rt(PRM_CONTAIN* param_container, int val_id, unsigned int curved, SAMPLE_T* ramp_buffer, unsigned int nframes, unsigned int start_frame);
 //set the strings for paramter, the type must be String_Return_type
 int param_set_param_strings(PRM_CONTAIN* param_container, int val_id, char** strings, unsigned int num_strings);
 //get the parameter string, from the current parameter value, the values must go from >= 0 in positive direction
 const char* param_get_param_string(PRM_CONTAIN* param_container, int val_id, unsigned int rt_params);
-//Write to ret_string how to display the parameter value to the user. Use only on [main-thread]
+//Write to ret_string how to display the parameter value to the user, copied from param_get_value_string. Use only on [main-thread]
 unsigned int param_get_value_as_string(PRM_CONTAIN* param_container, int val_id, char* ret_string, uint32_t string_len);
+//return the parameter value formatted for the user, the string is kept on the container and formatted again only when the value changes
+//the pointer is valid until the next call for this parameter or until the container is cleaned, NULL on error. Use only on [main-thread]
+const char* param_get_value_string(PRM_CONTAIN* param_container, int val_id);
+//format all the value strings of the container again on the next param_get_value_string, for when the way to display the values changes
+void param_value_strings_invalidate(PRM_CONTAIN* param_container);
 //check if the parameter is just changed - returns 1 if this parameters value was not retrieved with param_get_value
 int param_get_if_changed(PRM_CONTAIN* param_container, int val_id, unsigned int rt_params);
 //check if any of the parameters have changed in the parameter set. If at least one parameter has a just_changed
-//1 the for loop will break and return 1
+//returns 1, only checks the words of the changed bitset
 int param_get_if_any_changed(PRM_CONTAIN* param_container, unsigned int rt_params);
+//return the id of the first parameter from from_id (including) that has just_changed, -1 if there are none
+//goes through the changed bitset so only the changed parameters cost anything, iterate with param_next_changed(cont, id + 1, rt_params)
+int param_next_changed(PRM_CONTAIN* param_container, int from_id, unsigned int rt_params);
 //get if parameter is hidden or not
 unsigned int param_is_hidden(PRM_CONTAIN* param_container, int val_id, unsigned int rt_params);
 //return if parameter ui_name just changed
@@ -65,8 +110,12 @@ unsigned int param_get_ui_name(PRM_CONTAIN* param_container, int val_id, char* r
 //get the parameter name, and snprintf it to ret_name, returns 1 if succesful should be used on [main-thread]
 unsigned int param_get_name(PRM_CONTAIN* param_container, int val_id, char* ret_name, uint32_t name_len);
 //return id of parameter given its name, will return -1 if name was not found
+//goes through the name hash index of the container, so its the same cost no matter how many parameters there are
 int param_find_name(PRM_CONTAIN* param_container, const char* param_name, unsigned int rt_params);
 //return how many parameters are there on the param container
 unsigned int param_return_num_params(PRM_CONTAIN* param_container, unsigned int rt_params);
-//cleans the parameter container
+//cleans the parameter container, use only on [main-thread]
+//the container is removed from its param_rings right away, but freed only when the [audio-thread] can no longer send messages to it
 void param_clean_param_container(PRM_CONTAIN* param_container);
+//cleans the parameter rings and frees the removed containers, the containers of the context have to be cleaned before this
+void param_clean_param_rings(PRM_RINGS* param_rings);
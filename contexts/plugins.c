@@ -219,8 +219,10 @@ typedef struct _plug_plug{
     unsigned int plug_instance_activated;
     //the instance id to link it to cx
     int id;
-    //audio backend midi container
-    JACK_MIDI_CONT* midi_cont;
+    //1 while the removal of this plugin is submitted to the [audio-thread], touch only on [main-thread]
+    unsigned int remove_pending;
+    //grows each time the slot is cleaned, so the done function of a removal can tell if the slot holds another plugin now, touch only on [main-thread]
+    unsigned int generation;
     //array of available ports for the plugin
     PLUG_PORT* ports;
     //how many ports do we have on plugin
@@ -282,6 +284,8 @@ typedef struct _plug_info{
     float bpm;
     //this is control for [audio-thread] and [main-thread] sys communication (wait for a plugin pause etc.)
     CXCONTROL* control_data;
+    //the parameter messages of all the plugins go through these rings
+    PRM_RINGS* param_rings;
     //rt tick var, that goes from 0 to RT_CYCLES, rt thread will send info to ui thread only when rt tick var is 0
     //should only be touched on [audio-thread]
     int rt_tick;
@@ -299,6 +303,9 @@ static int  plug_remove_plug(PLUG_INFO* plug_data, int id){
     if(id >= MAX_INSTANCES || id < 0)return -1;
       
     PLUG_PLUG* cur_plug = &(plug_data->plugins[id]);
+    //the slot is cleaned now, a removal that is still submitted should not clean it again
+    cur_plug->remove_pending = 0;
+    cur_plug->generation += 1;
     //remove preset
     if(cur_plug->preset){
 	const LilvNode* old_preset = lilv_state_get_uri(cur_plug->preset);
@@ -350,13 +357,6 @@ static int  plug_remove_plug(PLUG_INFO* plug_data, int id){
     if(cur_plug->feature_list)free(cur_plug->feature_list);
     cur_plug->feature_list = NULL;
 
-    //clean the midi container
-    if(cur_plug->midi_cont){
-	app_jack_clean_midi_cont(cur_plug->midi_cont);
-	free(cur_plug->midi_cont);
-	cur_plug->midi_cont = NULL;
-    }
-
     //clean the controls
     if(cur_plug->plug_params)param_clean_param_container(cur_plug->plug_params);
     cur_plug->plug_params = NULL;
@@ -645,6 +645,13 @@ PLUG_INFO* plug_init(uint32_t block_length, SAMPLE_T samplerate,
 	*plug_errors = plug_failed_malloc;
 	return NULL;
     }
+    plug_data->param_rings = params_init_param_rings(app_jack_frame_time, audio_backend);
+    if(!plug_data->param_rings){
+	context_sub_clean(plug_data->control_data);
+	free(plug_data);
+	*plug_errors = plug_failed_malloc;
+	return NULL;
+    }
     
     plug_data->rt_tick = 0;
     plug_data->lv_world = lilv_world_new();
@@ -668,7 +675,6 @@ PLUG_INFO* plug_init(uint32_t block_length, SAMPLE_T samplerate,
     for(int i = 0; i<(MAX_INSTANCES+1); i++){
 	PLUG_PLUG* plug = &(plug_data->plugins[i]);
         plug->is_processing = 0;
-	plug->midi_cont = NULL;
 	plug->plug = NULL;
 	plug->plug_instance = NULL;
 	plug->plug_instance_activated = 0;
@@ -684,6 +690,8 @@ PLUG_INFO* plug_init(uint32_t block_length, SAMPLE_T samplerate,
 	plug->plug_params = NULL;
 	plug->safe_restore = false;
 	plug->id = i;
+	plug->remove_pending = 0;
+	plug->generation = 0;
 	
 	//initialize the plug urids, they are the same as plug_data, used for convenience
 	plug->urids = &(plug_data->urids);
@@ -921,13 +929,8 @@ int plug_read_ui_to_rt_messages(PLUG_INFO* plug_data){
     
     //process the control_data sys messages for [audio_thread] (stop plugin and similar)
     context_sub_process_rt(plug_data->control_data);
-    //read the param messages for plugins
-    for(unsigned int i = 0; i < MAX_INSTANCES; i++){
-	PLUG_PLUG* cur_plug = &(plug_data->plugins[i]);
-	if(cur_plug->is_processing == 0)continue;
-	if(!cur_plug->plug_instance)continue;
-	param_msgs_process(cur_plug->plug_params, 1);
-    }
+    //read the param messages for all the plugins
+    param_msgs_process(plug_data->param_rings, 1);
     return 0;
 }
 int plug_read_rt_to_ui_messages(PLUG_INFO* plug_data){
@@ -935,11 +938,7 @@ int plug_read_rt_to_ui_messages(PLUG_INFO* plug_data){
     //process the control_data sys messages for [main_thread] (like send msg)
     context_sub_process_ui(plug_data->control_data);
     //read the param rt_to_ui messages and set the parameter values
-    for(unsigned int i = 0; i < MAX_INSTANCES; i++){
-	PLUG_PLUG* cur_plug = &(plug_data->plugins[i]);
-	if(!cur_plug->plug_instance)continue;
-	param_msgs_process(cur_plug->plug_params, 0);
-    }   
+    param_msgs_process(plug_data->param_rings, 0);
     return 0;
 }
 
@@ -974,8 +973,9 @@ int plug_load_and_activate(PLUG_INFO* plug_data, const char* plugin_uri, const i
 	}
     }
     if(plug_id == -1 || plug_id >= MAX_INSTANCES)return -1;
-    //just in case clean the plugin up
-    plug_stop_and_remove_plug(plug_data, plug_id);
+    //clean the plugin up if the slot is used, an empty slot is not processing so there is nothing to wait for
+    PLUG_PLUG* old_plug = &(plug_data->plugins[plug_id]);
+    if(old_plug->plug || old_plug->plug_instance || old_plug->remove_pending == 1)plug_stop_and_remove_plug(plug_data, plug_id);
 
     PLUG_PLUG* plug = &(plug_data->plugins[plug_id]);
     return_val = plug_id;
@@ -1101,7 +1101,7 @@ int plug_load_and_activate(PLUG_INFO* plug_data, const char* plugin_uri, const i
 	    param_incs[ct_iter] = cur_inc;
 	}
 	PRM_CONTAIN* plug_params = params_init_param_container(num_of_params, param_names,
-							       param_vals, param_mins, param_maxs, param_incs, val_types, NULL, NULL);
+							       param_vals, param_mins, param_maxs, param_incs, val_types, NULL, NULL, plug_data->param_rings);
 	//go through the controls again and set the strings for parameters that are string type
 	for(unsigned int ct_iter = 0; ct_iter < plug->num_controls; ct_iter++){
 	    PLUG_CONTROL* cur_ctrl = plug->controls[ct_iter];
@@ -1142,17 +1142,11 @@ int plug_load_and_activate(PLUG_INFO* plug_data, const char* plugin_uri, const i
 	plug->plug_params = plug_params;
     }
     
-    plug->midi_cont = app_jack_init_midi_cont(MAX_MIDI_CONT_ITEMS);
-    if(!plug->midi_cont){
-	plug_stop_and_remove_plug(plug_data, plug->id);
-	return -1;
-    }
-    
     //activate the plugin instance
     lilv_instance_activate(plug->plug_instance);
     plug->plug_instance_activated = 1;
-    //wait for the plugin to start processing
-    context_sub_wait_for_start(plug_data->control_data, (void*)plug);
+    //start processing the plugin, without waiting for the [audio-thread]
+    context_sub_start(plug_data->control_data, (void*)plug, 0);
     return return_val;
 }
 
@@ -1505,12 +1499,21 @@ int plug_activate_backend_ports(PLUG_INFO* plug_data, PLUG_PLUG* plug){
 
 PRM_CONTAIN* plug_param_return_param_container(PLUG_INFO* plug_data, int plug_id){
     if(!plug_data)return NULL;
-    if(plug_id >= MAX_INSTANCES)return NULL;
+    if(plug_id >= MAX_INSTANCES || plug_id < 0)return NULL;
     PLUG_PLUG* cur_plug = &(plug_data->plugins[plug_id]);
     if(!cur_plug->plug_instance || !cur_plug->plug_params)return NULL;
     return cur_plug->plug_params;
 }
 
+PRM_CONTAIN* plug_param_return_param_container_rt(PLUG_INFO* plug_data, int plug_id){
+    if(!plug_data)return NULL;
+    if(plug_id >= MAX_INSTANCES || plug_id < 0)return NULL;
+    PLUG_PLUG* cur_plug = &(plug_data->plugins[plug_id]);
+    //the [main-thread] changes or frees the plugin only after it stopped processing, so a processing plugin has a valid container
+    if(cur_plug->is_processing == 0)return NULL;
+    return cur_plug->plug_params;
+}
+
 void plug_process_data_rt(PLUG_INFO* plug_data, unsigned int nframes){ 
     if(!plug_data){
 	return;
@@ -1533,7 +1536,6 @@ void plug_process_data_rt(PLUG_INFO* plug_data, unsigned int nframes){
 	    void* a_buffer = NULL;
 	    if(cur_port->sys_port){
 		a_buffer = app_jack_get_buffer_rt(cur_port->sys_port, nframes);
-		app_jack_midi_cont_reset(plug->midi_cont);
 	    }
 	    if(cur_port->type == TYPE_AUDIO){
 		lilv_instance_connect_port(plug->plug_instance, i, a_buffer);
@@ -1554,27 +1556,29 @@ void plug_process_data_rt(PLUG_INFO* plug_data, unsigned int nframes){
 		    plug_evbuf_write(&iter_buf, 0, 0, get->type, get->size, LV2_ATOM_BODY_CONST(get));
 		}
 		//add midi event to the buffer
-		if(a_buffer){
-		    app_jack_return_notes_vels_rt(a_buffer, plug->midi_cont);
+		//the port events are decoded already for this cycle on the midi bus
+		const JACK_MIDI_CONT* midi_cont = app_jack_midi_bus_return_rt(plug_data->audio_backend, cur_port->sys_port);
+		if(midi_cont){
 		    //go through the returned audio backend midi event and write to the evbuf
-		    for(uint32_t i = 0; i<plug->midi_cont->num_events; i++){
-			const unsigned char midi_msg[3] = {plug->midi_cont->types[i], plug->midi_cont->note_pitches[i], plug->midi_cont->vel_trig[i]};
-			int write = plug_evbuf_write(&iter_buf, plug->midi_cont->nframe_nums[i], 0, cur_port->port_type_urid,
-						     plug->midi_cont->buf_size[i], midi_msg);
+		    for(uint32_t i = 0; i<midi_cont->num_events; i++){
+			const JACK_MIDI_EVENT* event = &(midi_cont->events[i]);
+			//the whole message from the port buffer, so sysex and other long messages reach the plugin too
+			int write = plug_evbuf_write(&iter_buf, event->frame, 0, cur_port->port_type_urid,
+						     event->size, event->buffer);
 		    }
 		}
-		//send plugin the transport information
-		int32_t cur_bar = 0;
-		int32_t cur_beat = 0;
-		int32_t cur_tick = 0;
-		SAMPLE_T ticks_per_beat = 0;
-		jack_nframes_t total_frames = 0;
-		float bpm = plug_data->bpm;
-		float beat_type = 0;
-		float beats_per_bar = 0;
-		unsigned int tr_playing = app_jack_return_transport_rt(plug_data->audio_backend, &cur_bar, &cur_beat, &cur_tick, &ticks_per_beat, &total_frames,
-								       &bpm, &beat_type, &beats_per_bar);
-		if(tr_playing != -1){
+		//send plugin the transport information, from the snapshot of this cycle that all the contexts share
+		const JACK_TRANSPORT_SNAP* transport = app_jack_return_transport_snap_rt(plug_data->audio_backend);
+		if(transport && transport->bbt_valid){
+		    int32_t cur_bar = transport->bar;
+		    int32_t cur_beat = transport->beat;
+		    int32_t cur_tick = transport->tick;
+		    SAMPLE_T ticks_per_beat = transport->ticks_per_beat;
+		    jack_nframes_t total_frames = transport->frame;
+		    float bpm = transport->bpm;
+		    float beat_type = transport->beat_type;
+		    float beats_per_bar = transport->beats_per_bar;
+		    unsigned int tr_playing = transport->playing;
 		    unsigned int pos_change = 0;
 		    pos_change = (tr_playing != plug_data->isPlaying || total_frames != plug_data->posFrame || bpm != plug_data->bpm);
 		    if(pos_change){
@@ -1615,9 +1619,9 @@ void plug_process_data_rt(PLUG_INFO* plug_data, unsigned int nframes){
 	//----------------------------------------------------------------------------------------------------
 	//go through controls and either set them direclty if its control port parameter or send them to the
 	//event port as atoms if its a property port
-	for(unsigned int ctrl_iter = 0; ctrl_iter < plug->num_controls; ctrl_iter ++){
-	    int param_changed = param_get_if_changed(plug->plug_params, ctrl_iter, 1);
-	    if(param_changed != 1) continue;
+	//only the changed parameters are visited
+	for(int ctrl_iter = param_next_changed(plug->plug_params, 0, 1); ctrl_iter >= 0 && ctrl_iter < plug->num_controls;
+	    ctrl_iter = param_next_changed(plug->plug_params, ctrl_iter + 1, 1)){
 	    PLUG_CONTROL* cur_control = plug->controls[ctrl_iter];
 	    if(!cur_control)continue;
 	    if(!(cur_control->is_writable))continue;
@@ -1676,7 +1680,10 @@ void plug_process_data_rt(PLUG_INFO* plug_data, unsigned int nframes){
 	    PLUG_PORT* const cur_port = &(plug->ports[i]);
 	    if(cur_port->flow!=FLOW_OUTPUT)continue;
 	    if(cur_port->type == TYPE_AUDIO){
-
+		if(cur_port->sys_port){
+		    SAMPLE_T* out_buffer = app_jack_get_buffer_rt(cur_port->sys_port, nframes);
+		    context_sub_count_subnormals_rt(plug_data->control_data, out_buffer, nframes);
+		}
 	    }
 	    if(cur_port->type == TYPE_CV){
    
@@ -1747,6 +1754,32 @@ int plug_stop_and_remove_plug(PLUG_INFO* plug_data, int id){
     return plug_remove_plug(plug_data, id);
 }
 
+//called on [main-thread] when the [audio-thread] stopped the plugin, if the slot was not cleaned in the meantime remove the plugin
+static void plug_remove_plug_done(void* done_data, void* user_data, unsigned int generation, int result){
+    PLUG_INFO* plug_data = (PLUG_INFO*)done_data;
+    PLUG_PLUG* slot = (PLUG_PLUG*)user_data;
+    if(!plug_data || !slot)return;
+    //the slot was cleaned after the removal was submitted, it could hold a new plugin with its own removal on the way
+    if(slot->generation != generation)return;
+    plug_remove_plug(plug_data, slot->id);
+}
+
+//mark the removal of the plugin as pending for context_sub_stop_and_remove, skip the plugins that are being removed already
+static int plug_remove_plug_claim(void* user_data, unsigned int* generation){
+    PLUG_PLUG* slot = (PLUG_PLUG*)user_data;
+    if(slot->remove_pending == 1)return -1;
+    slot->remove_pending = 1;
+    *generation = slot->generation;
+    return 0;
+}
+
+int plug_stop_and_remove_plugs(PLUG_INFO* plug_data, const int* ids, unsigned int num_ids){
+    if(!plug_data || !ids)return -1;
+    //the plugins are stopped in the same [audio-thread] cycle and removed when the done functions are called
+    return context_sub_stop_and_remove(plug_data->control_data, (void*)plug_data->plugins, sizeof(PLUG_PLUG), MAX_INSTANCES, ids, num_ids,
+				       plug_remove_plug_claim, plug_remove_plug_done, (void*)plug_data);
+}
+
 void plug_clean_memory(PLUG_INFO* plug_data){
     if(!plug_data)return;
     for(int i = 0; i< MAX_INSTANCES; i++){
@@ -1760,6 +1793,7 @@ void plug_clean_memory(PLUG_INFO* plug_data){
     }    
     if(plug_data->lv_world)lilv_world_free(plug_data->lv_world);
 
+    param_clean_param_rings(plug_data->param_rings);
     context_sub_clean(plug_data->control_data);
     free(plug_data);
 }
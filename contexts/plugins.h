@@ -67,6 +67,8 @@ int plug_activate_backend_ports(PLUG_INFO* plug_data, PLUG_PLUG* plug);
 
 //returns param ocntainer on the plugin, use on [main-thread]
 PRM_CONTAIN* plug_param_return_param_container(PLUG_INFO* plug_data, int plug_id);
+//returns param container on the plugin or NULL if the plugin is not processing, use on [audio-thread]
+PRM_CONTAIN* plug_param_return_param_container_rt(PLUG_INFO* plug_data, int plug_id);
 
 //connect the ports, run the plugins instances for nframes, and update the output ports, use on [audio-thread]
 void plug_process_data_rt(PLUG_INFO* plug_data, unsigned int nframes);
@@ -75,5 +77,8 @@ static void plug_run_rt(PLUG_PLUG* plug, unsigned int nframes);
 //stop processing the plugin and remove it.
 //plugin will be stopped on [audio-thread], if there is no [audio-thread] this  can result in an infinite loop
 int plug_stop_and_remove_plug(PLUG_INFO* plug_data, const int id);
+//stop the plugins with ids without blocking the [main-thread], the [audio-thread] stops them all in the same cycle
+//each plugin is removed on [main-thread] in plug_read_rt_to_ui_messages after the [audio-thread] stopped it
+int plug_stop_and_remove_plugs(PLUG_INFO* plug_data, const int* ids, unsigned int num_ids);
 //clean the plug_data memory
 void plug_clean_memory(PLUG_INFO* plug_data);
@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <threads.h>
+#include <stdatomic.h>
 //my libraries
 #include "../util_funcs/wav_funcs.h"
 #include "../util_funcs/math_funcs.h"
@@ -22,9 +23,8 @@
 
 static thread_local bool is_audio_thread = false;
 
-typedef struct _smp_smp{
-    //the note id, used to link to the cx struct
-    int id;
+//the loaded sample, built on [main-thread] and not changed after it is published to the [audio-thread]
+typedef struct _smp_state{
     //the file path of the sample
     char* file_path;
     //the sample sample rate
@@ -33,16 +33,30 @@ typedef struct _smp_smp{
     int chans;
     //the parameter container, that holds the rt and ui param arrays
     PRM_CONTAIN* params;
-    //the sample buffer that holds the audio sample in memory has to be freed
+    //the sample buffer that holds the audio sample in memory
     SAMPLE_T* buffer;
     //how many samples are loaded
     int samples_loaded;
+    //which publish of the slot this state is, the allocator can give a new state the address of a freed one
+    //so the [audio-thread] compares this too to know that the sample was replaced
+    unsigned int generation;
+}SMP_STATE;
+
+typedef struct _smp_smp{
+    //the note id, used to link to the cx struct
+    int id;
+    //the loaded sample or NULL if the slot is empty, swapped only on [main-thread]
+    //the old state is freed with context_sub_retire once the [audio-thread] can not use it anymore
+    _Atomic(SMP_STATE*) state;
+    //how many states were published for this slot, touch only on [main-thread]
+    unsigned int state_gen;
+    //the state and its generation that the [audio-thread] played in the last cycle, to restart the playhead when the sample is replaced. Touch only on [audio-thread]
+    SMP_STATE* played_state;
+    unsigned int played_gen;
     //the current playhead pos in frames of the sample
     int offset;
     //if the sample is playing
     int playing;
-    //if processing == 0 the sample will not run on the [audio-thread]
-    int processing;
     //what velocity was used to hit the sample
     SAMPLE_T midi_vel;
 }SMP_SMP;
@@ -60,8 +74,8 @@ typedef struct _smp_port{
     void* sys_port;
 }SMP_PORT;
 //the drum sampler main struct that holds the samples and other data
-//Only realtime thread directly modifies and reads the SMP_SMP, non realtime thread can remove it or add
-//new one, but before doing so it asks the realtime thread to pause sample processing.
+//Only realtime thread modifies the playhead of the SMP_SMP, non realtime thread adds or removes samples
+//by swapping the SMP_SMP state, so the realtime thread does not have to pause for it.
 typedef struct _smp_info{
     //the buffer size of the audio system
     unsigned int buffer_size;
@@ -69,6 +83,8 @@ typedef struct _smp_info{
     SAMPLE_T samplerate;
     //this is the sample array
     SMP_SMP samples [MAX_SAMPLES+1]; //one sample too many in array, the last one will be to check for the end of the array
+    //the parameter messages of all the samples go through these rings
+    PRM_RINGS* param_rings;
     //the array of ports for the audio_client;
     SMP_PORT* ports;
     //number of available ports
@@ -76,8 +92,6 @@ typedef struct _smp_info{
     //callback functions for the audio backend to manipulate ports, midi etc.
     //the audio client data 
     void* audio_backend;
-    //the midi container that has the note pitches etc.
-    JACK_MIDI_CONT* midi_cont;
     //control_data struct to control sys messages between [audio-thread] and [main-thread] (stop processing sample, start processing sample and etc.)
     CXCONTROL* control_data;
 }SMP_INFO; 
@@ -91,22 +105,26 @@ static int smp_sys_msg(void* user_data, const char* msg){
     return 0;
 }
 
-static int smp_start_process(void* user_data){
-    SMP_SMP* smp = (SMP_SMP*)user_data;
-    if(!smp)return -1;
-    if(smp->processing == 1)return 0;
-    if(!smp->buffer)return -1;
-    smp->processing = 1;
-    return 0;
+//free the sample state, called on [main-thread] when the [audio-thread] can not reach the state anymore
+static void smp_state_free(void* state){
+    SMP_STATE* smp_state = (SMP_STATE*)state;
+    if(!smp_state)return;
+    if(smp_state->buffer)free(smp_state->buffer);
+    if(smp_state->file_path)free(smp_state->file_path);
+    //the container is freed later in param_msgs_process, when the param messages can not reach it
+    if(smp_state->params)param_clean_param_container(smp_state->params);
+    free(smp_state);
 }
 
-static int smp_stop_process(void* user_data){
-    SMP_SMP* smp = (SMP_SMP*)user_data;
-    if(!smp)return -1;
-    if(smp->processing == 0)return 0;
-    //TODO could silence the sample before stopping it here
-    smp->processing = 0;
-    return 0;
+//swap the state of the sample and free the old one when the [audio-thread] is done with it, use only on [main-thread]
+static void smp_state_publish(SMP_INFO* smp_data, SMP_SMP* cur_smp, SMP_STATE* new_state){
+    cur_smp->state_gen += 1;
+    if(new_state)new_state->generation = cur_smp->state_gen;
+    SMP_STATE* old_state = atomic_exchange_explicit(&cur_smp->state, new_state, memory_order_acq_rel);
+    if(!old_state)return;
+    if(context_sub_retire(smp_data->control_data, (void*)old_state, smp_state_free) != 0){
+	log_append_logfile("Could not retire the sample state, leaking it\n");
+    }
 }
 
 int smp_read_ui_to_rt_messages(SMP_INFO* smp_data){
@@ -114,14 +132,8 @@ int smp_read_ui_to_rt_messages(SMP_INFO* smp_data){
     is_audio_thread = true;
     if(!smp_data)return -1;
     context_sub_process_rt(smp_data->control_data);
-    
-    for(unsigned int i = 0; i < MAX_SAMPLES; i++){
-	SMP_SMP* smp = &(smp_data->samples[i]);
-	//do nothing if the sample is stopped
-	if(smp->processing == 0)continue;
-	if(!smp->buffer || !smp->params)continue;
-	param_msgs_process(smp->params, 1);
-    }
+    //read the param ui_to_rt messages for all the samples
+    param_msgs_process(smp_data->param_rings, 1);
     return 0;
 }
 int smp_read_rt_to_ui_messages(SMP_INFO* smp_data){
@@ -129,35 +141,16 @@ int smp_read_rt_to_ui_messages(SMP_INFO* smp_data){
     context_sub_process_ui(smp_data->control_data);
 
     //read the param rt_to_ui messages and set the parameter values
-    for(unsigned int i = 0; i < MAX_SAMPLES; i++){
-	SMP_SMP* smp = &(smp_data->samples[i]);
-	if(!smp->buffer || !smp->params)continue;
-        param_msgs_process(smp->params, 0);
-    }    
+    param_msgs_process(smp_data->param_rings, 0);
     return 0;
 }
 
 static int smp_remove_sample(SMP_INFO* smp_data, unsigned int idx){
     if(!smp_data)return -1;
     if(idx >= MAX_SAMPLES)return -1;
-    //clear the sample audio buffer
     SMP_SMP* cur_smp = &(smp_data->samples[idx]);
- 
-    if(cur_smp->buffer)free(cur_smp->buffer);
-    cur_smp->buffer = NULL;
-    if(cur_smp->file_path)free(cur_smp->file_path);
-    cur_smp->file_path = NULL;
-    //clean the parameter container
-    if(cur_smp->params)param_clean_param_container(cur_smp->params);
-    cur_smp->params = NULL;
-
-    cur_smp->chans = 0;
-    cur_smp->midi_vel = (SAMPLE_T)1.0;
-    cur_smp->offset = 0;
-    cur_smp->playing = 0;
-    cur_smp->samplerate = 0;
-    cur_smp->samples_loaded = 0;
-
+    //the [audio-thread] skips the empty slot from its next cycle, the playhead is reset there
+    smp_state_publish(smp_data, cur_smp, NULL);
     return 0;
 }
 
@@ -172,8 +165,6 @@ SMP_INFO* smp_init(unsigned int buffer_size, SAMPLE_T samplerate,
     }
     CXCONTROL_RT_FUNCS rt_funcs_struct = {0};
     CXCONTROL_UI_FUNCS ui_funcs_struct = {0};
-    rt_funcs_struct.subcx_start_process = smp_start_process;
-    rt_funcs_struct.subcx_stop_process = smp_stop_process;
     ui_funcs_struct.send_msg = smp_sys_msg;
     smp_data->control_data = context_sub_init(rt_funcs_struct, ui_funcs_struct);
     if(!smp_data->control_data){
@@ -181,8 +172,14 @@ SMP_INFO* smp_init(unsigned int buffer_size, SAMPLE_T samplerate,
 	*status = smp_data_malloc_fail;
 	return NULL;
     }
+    smp_data->param_rings = params_init_param_rings(app_jack_frame_time, audio_backend);
+    if(!smp_data->param_rings){
+	context_sub_clean(smp_data->control_data);
+	free(smp_data);
+	*status = smp_data_malloc_fail;
+	return NULL;
+    }
 
-    smp_data->midi_cont = NULL;
     smp_data->buffer_size = buffer_size;
     smp_data->samplerate = samplerate;
     //init the ports
@@ -214,27 +211,18 @@ SMP_INFO* smp_init(unsigned int buffer_size, SAMPLE_T samplerate,
     }
     for(int i = 0; i < (MAX_SAMPLES+1); i++){
 	 SMP_SMP* samp = &(smp_data->samples[i]);
-	 samp->buffer = NULL;
-	 samp->chans = 0;
-	 samp->file_path = NULL;
+	 atomic_init(&samp->state, NULL);
+	 samp->played_state = NULL;
+	 samp->state_gen = 0;
+	 samp->played_gen = 0;
 	 samp->id = i;
 	 samp->midi_vel = (SAMPLE_T)1.0;
 	 samp->offset = 0;
-	 samp->params = NULL;
-	 samp->processing = 0;
 	 samp->playing = 0;
-	 samp->samplerate = 0;
-	 samp->samples_loaded = 0;
     }
      
      //inititalize the callbacks from the audio backend
      smp_data->audio_backend = audio_backend;
-     smp_data->midi_cont = app_jack_init_midi_cont(MAX_MIDI_CONT_ITEMS);
-     if(!smp_data->midi_cont){
-	 smp_clean_memory(smp_data);
-	 return NULL;
-     }
-     
      smp_activate_backend_ports(smp_data);
 
      return smp_data;
@@ -260,51 +248,56 @@ int smp_add(SMP_INFO *smp_data, const char* samp_path, int in_id){
     if(smp_id == -1){
 	for(int i = 0; i < (MAX_SAMPLES+1); i++){
 	    SMP_SMP* cur_smp = &(smp_data->samples[i]);
-	    if(cur_smp->file_path)continue;
+	    if(atomic_load_explicit(&cur_smp->state, memory_order_relaxed))continue;
 	    smp_id = cur_smp->id;
 	    break;
 	}
     }
     if(smp_id == -1 || smp_id >= MAX_SAMPLES)return -1;
-    //remove sample if this sample slot is occupied for some reason
-    smp_stop_and_remove_sample(smp_data, smp_id);
     
     SMP_SMP *cur_smp = &(smp_data->samples[smp_id]);
+    //the new state is built here while the [audio-thread] keeps playing the old one of this slot, if there is one
+    SMP_STATE* new_state = (SMP_STATE*)calloc(1, sizeof(SMP_STATE));
+    if(!new_state)return -1;
     //init the sample parameters to default values
-    cur_smp->params = params_init_param_container(NUM_PARAMS, (char*[1]){"Note"}, (PARAM_T[1]){40}, (PARAM_T[1]){0},
-						  (PARAM_T[1]){127}, (PARAM_T[1]){1}, (unsigned char[1]){Uchar_type}, NULL, NULL);
+    new_state->params = params_init_param_container(NUM_PARAMS, (char*[1]){"Note"}, (PARAM_T[1]){40}, (PARAM_T[1]){0},
+						  (PARAM_T[1]){127}, (PARAM_T[1]){1}, (unsigned char[1]){Uchar_type}, NULL, NULL, smp_data->param_rings);
     
     //TODO samplerate is not needed, when we load sample to memory we also need to convert it to the system
     //sample rate, when system sample rate changes, the jack callback of samplerate change
     //calls a function in app_data to change variables on various structs that depend on the samplerate
     //one of those members is the cur_smp->buffer- the app_data function will call the function in
     //smp_data to adapt the buffer to the new sample rate.
+    if(!new_state->params){
+	smp_state_free(new_state);
+	return -1;
+    }
     SF_INFO samp_props;
     //load sample to memory, remember that sample channels can differ
     int load_err = 0;
     load_err = load_wav_mem(&samp_props, SINGLE_READ_SAMPLE_B,
-			    samp_path, &cur_smp->buffer);
+			    samp_path, &new_state->buffer);
     //if could not load the file, free memory this sample will not be loaded
     if(load_err<0){
-	smp_stop_and_remove_sample(smp_data, smp_id);
+	smp_state_free(new_state);
         return sample_load_memory_failed;
     }
     //if the buffer was loaded succesfuly the load_err will contain the number of samples loaded
-    cur_smp->samples_loaded = load_err;
+    new_state->samples_loaded = load_err;
     //write the samplerate and number of channels
-    cur_smp->samplerate = samp_props.samplerate;
-    cur_smp->chans = samp_props.channels;
+    new_state->samplerate = samp_props.samplerate;
+    new_state->chans = samp_props.channels;
 
     //malloc the file_path of the sample
-    cur_smp->file_path = (char*)malloc(sizeof(char) * (strlen(samp_path)+1));
-    if(!cur_smp->file_path){
-	smp_stop_and_remove_sample(smp_data, smp_id);
+    new_state->file_path = (char*)malloc(sizeof(char) * (strlen(samp_path)+1));
+    if(!new_state->file_path){
+	smp_state_free(new_state);
 	return -1;
     }
 
-    strcpy(cur_smp->file_path, samp_path);
-    //now this sample can start processing
-    context_sub_wait_for_start(smp_data->control_data, (void*)cur_smp);
+    strcpy(new_state->file_path, samp_path);
+    //now this sample can start processing, the old sample of the slot is freed when the [audio-thread] moved on
+    smp_state_publish(smp_data, cur_smp, new_state);
     return smp_id;
 }
 
@@ -312,42 +305,58 @@ int smp_sample_process_rt(SMP_INFO* smp_data, uint32_t nframes){
     SMP_PORT* midi_port = &(smp_data->ports[0]);
     SMP_PORT* out_L_port = &(smp_data->ports[1]);
     SMP_PORT* out_R_port = &(smp_data->ports[2]);    
-    void* midi_buffer = app_jack_get_buffer_rt(midi_port->sys_port , nframes);
     SAMPLE_T* out_L = app_jack_get_buffer_rt(out_L_port->sys_port, nframes);
     SAMPLE_T* out_R = app_jack_get_buffer_rt(out_R_port->sys_port, nframes);
-    if(!midi_buffer || !out_L || !out_R)return -1;
+    if(!out_L || !out_R)return -1;
     memset(out_L, '\0', sizeof(SAMPLE_T)*nframes);
     memset(out_R, '\0', sizeof(SAMPLE_T)*nframes); 
 
-    if(!smp_data->midi_cont)return -1;
-    //get the notes
-    app_jack_midi_cont_reset(smp_data->midi_cont);
-    app_jack_return_notes_vels_rt(midi_buffer, smp_data->midi_cont);
-    JACK_MIDI_CONT* midi_cont = smp_data->midi_cont;
+    //get the notes, decoded already for this cycle on the midi bus
+    //without the midi port the samples that are playing still play to the end, only new notes are not heard
+    const JACK_MIDI_CONT* midi_cont = app_jack_midi_bus_return_rt(smp_data->audio_backend, midi_port->sys_port);
+    unsigned int num_events = 0;
+    if(midi_cont)num_events = midi_cont->num_events;
     //go through each sample
     for(unsigned int iter = 0; iter < MAX_SAMPLES; iter++){
 	SMP_SMP* cur_smp = &(smp_data->samples[iter]);
-	if(cur_smp->processing == 0)continue;
-	if(!cur_smp->params)continue;
+	//load the state once, it stays valid for this whole cycle even if the [main-thread] swaps it
+	SMP_STATE* smp_state = atomic_load_explicit(&cur_smp->state, memory_order_acquire);
+	unsigned int smp_gen = 0;
+	if(smp_state)smp_gen = smp_state->generation;
+	//the sample was replaced or removed, start from the beginning of the new one
+	if(smp_state != cur_smp->played_state || smp_gen != cur_smp->played_gen){
+	    cur_smp->played_state = smp_state;
+	    cur_smp->played_gen = smp_gen;
+	    cur_smp->offset = 0;
+	    cur_smp->playing = 0;
+	}
         //if the sample is not ready go to another
-        if(cur_smp->buffer==NULL)continue;
-	if(cur_smp->chans<=0)continue;
-	if(cur_smp->samples_loaded <=0)continue;
+	if(!smp_state)continue;
+	if(!smp_state->params)continue;
+        if(smp_state->buffer==NULL)continue;
+	if(smp_state->chans<=0)continue;
+	if(smp_state->samples_loaded <=0)continue;
+	//never read past the buffer of this state, even if the playhead was left from a longer sample
+	if(cur_smp->offset < 0 || cur_smp->offset >= smp_state->samples_loaded){
+	    cur_smp->offset = 0;
+	    cur_smp->playing = 0;
+	}
 	//get the note parameter from the current samples rt_param array
-	unsigned char cur_note = (unsigned char)param_get_value(cur_smp->params, 0, 0, 0, 1);
+	unsigned char cur_note = (unsigned char)param_get_value(smp_state->params, 0, 0, 0, 1);
 	//go through the frames
 	//TODO really like that goes through each frame, but not sure how to find the
 	//midi event differently
 	for(int cur_frame = 0; cur_frame < nframes; cur_frame++){
 	    //find if there is a note of a sample in the notes
 	    unsigned char this_vel = 0;
-	    for(int i = 0; i<midi_cont->num_events; i++){
+	    for(int i = 0; i<num_events; i++){
+		const JACK_MIDI_EVENT* event = &(midi_cont->events[i]);
 		//if the note is played not on this time slice skip it
-		if(midi_cont->nframe_nums[i] != cur_frame)continue;
+		if(event->frame != cur_frame)continue;
 		//we are only looking for note on
-		if((midi_cont->types[i] & 0xf0) != 0x90)continue;
-		if(midi_cont->note_pitches[i] == cur_note){
-		    this_vel = midi_cont->vel_trig[i];
+		if((event->status & 0xf0) != 0x90)continue;
+		if(event->data[0] == cur_note){
+		    this_vel = event->data[1];
 		    break;
 		}
 	    }
@@ -363,13 +372,13 @@ int smp_sample_process_rt(SMP_INFO* smp_data, uint32_t nframes){
 	    }
 	    //if sample is not playing go to next frame
 	    if(cur_smp->playing == 0)continue;
-	    smp_sum_channel_buffers_rt(cur_smp, &(out_L[cur_frame]), &(out_R[cur_frame]),
+	    smp_sum_channel_buffers_rt(smp_state, cur_smp->offset, &(out_L[cur_frame]), &(out_R[cur_frame]),
 				       cur_smp->midi_vel, OUTS);
 	    //increase the playhead if the playhead is at the end go to the start 
 	    //and stop playing the sample. We offset by the number of the channels, because the files are saved
 	    //in the buffer as interleaved
-	    cur_smp->offset += cur_smp->chans;
-	    if(cur_smp->offset>=cur_smp->samples_loaded){
+	    cur_smp->offset += smp_state->chans;
+	    if(cur_smp->offset>=smp_state->samples_loaded){
 		cur_smp->offset = 0;
 		cur_smp->playing = 0;
 	    }
@@ -379,21 +388,23 @@ int smp_sample_process_rt(SMP_INFO* smp_data, uint32_t nframes){
 	    if(out_R[cur_frame] > 1.0) out_R[cur_frame] = 1.0;
 	}
     }
+    context_sub_count_subnormals_rt(smp_data->control_data, out_L, nframes);
+    context_sub_count_subnormals_rt(smp_data->control_data, out_R, nframes);
     
     return 0;
 }
 
-static void smp_sum_channel_buffers_rt(SMP_SMP* cur_smp, SAMPLE_T* out_L, SAMPLE_T* out_R,
+static void smp_sum_channel_buffers_rt(const SMP_STATE* smp_state, int offset, SAMPLE_T* out_L, SAMPLE_T* out_R,
 			     SAMPLE_T mult, int chans){
-    //the cur_smp has the same number of channels as the system
-    if(cur_smp->chans == chans){
-	*out_L += cur_smp->buffer[cur_smp->offset] * mult;
-	*out_R += cur_smp->buffer[cur_smp->offset + 1] * mult;
+    //the sample has the same number of channels as the system
+    if(smp_state->chans == chans){
+	*out_L += smp_state->buffer[offset] * mult;
+	*out_R += smp_state->buffer[offset + 1] * mult;
     }
     //if there are less sample channels then the port buffers
-    if(cur_smp->chans < chans){
-	*out_L += cur_smp->buffer[cur_smp->offset] * mult;
-	*out_R += cur_smp->buffer[cur_smp->offset+(cur_smp->chans-1)] * mult;
+    if(smp_state->chans < chans){
+	*out_L += smp_state->buffer[offset] * mult;
+	*out_R += smp_state->buffer[offset+(smp_state->chans-1)] * mult;
     }    
 }
 
@@ -401,33 +412,46 @@ PRM_CONTAIN* smp_param_return_param_container(SMP_INFO* smp_data, int smp_id){
     if(!smp_data)return NULL;
     if(smp_id >= MAX_SAMPLES || smp_id < 0)return NULL;
     SMP_SMP* smp = &(smp_data->samples[smp_id]);
-    if(!smp->buffer || !smp->params)return NULL;
-    return smp->params;
+    //the [audio-thread] calls this too (for the midi learn), so acquire to see the state the [main-thread] filled in before publishing it
+    SMP_STATE* smp_state = atomic_load_explicit(&smp->state, memory_order_acquire);
+    if(!smp_state || !smp_state->buffer || !smp_state->params)return NULL;
+    return smp_state->params;
 }
 
 char* smp_get_sample_file_path(SMP_INFO* smp_data, int smp_id){
     if(!smp_data)return NULL;
     if(smp_id >= MAX_SAMPLES)return NULL;
     SMP_SMP* cur_smp = &(smp_data->samples[smp_id]);
-    if(!cur_smp->file_path)return NULL;
-    char* ret_name = (char*)malloc(sizeof(char) * (strlen(cur_smp->file_path) + 1));
+    SMP_STATE* smp_state = atomic_load_explicit(&cur_smp->state, memory_order_relaxed);
+    if(!smp_state || !smp_state->file_path)return NULL;
+    char* ret_name = (char*)malloc(sizeof(char) * (strlen(smp_state->file_path) + 1));
     if(!ret_name)return NULL;
-    strcpy(ret_name, cur_smp->file_path);
+    strcpy(ret_name, smp_state->file_path);
     return ret_name;
 }
 
 int smp_stop_and_remove_sample(SMP_INFO* smp_data, int idx){
+    if(!smp_data)return -1;
     if(idx >= MAX_SAMPLES || idx < 0)return -1;
-    SMP_SMP* cur_smp = &(smp_data->samples[idx]);
-    //stop processing the sample
-    context_sub_wait_for_stop(smp_data->control_data, (void*)cur_smp);
+    //the [audio-thread] does not have to stop the sample first, it only sees the empty slot from its next cycle
     return smp_remove_sample(smp_data, idx);
 }
 
+int smp_stop_and_remove_samples(SMP_INFO* smp_data, const int* ids, unsigned int num_ids){
+    if(!smp_data || !ids)return -1;
+    for(unsigned int i = 0; i < num_ids; i++){
+	if(ids[i] < 0 || ids[i] >= MAX_SAMPLES)continue;
+	smp_remove_sample(smp_data, ids[i]);
+    }
+    return 0;
+}
+
 int smp_clean_memory(SMP_INFO *smp_data){
     if(!smp_data)return -1;    
+    //the [audio-thread] is not running anymore, so the states can be freed right away
     for(int i = 0; i<MAX_SAMPLES; i++){
-	smp_remove_sample(smp_data, i);
+	SMP_STATE* smp_state = atomic_exchange(&(smp_data->samples[i].state), NULL);
+	smp_state_free(smp_state);
     }
 
     if(smp_data->ports){
@@ -440,13 +464,8 @@ int smp_clean_memory(SMP_INFO *smp_data){
 	free(smp_data->ports);
     }
     smp_data->ports = NULL;
-    //remove the midi_container
-    if(smp_data->midi_cont){
-	app_jack_clean_midi_cont(smp_data->midi_cont);
-	free(smp_data->midi_cont);
-    }
-    smp_data->midi_cont = NULL;
 
+    param_clean_param_rings(smp_data->param_rings);
     context_sub_clean(smp_data->control_data);
     free(smp_data);
 
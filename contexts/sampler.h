@@ -13,6 +13,8 @@ enum SmpStatus{
 typedef enum SmpStatus smp_status_t;
 //the sample object with its buffer, that is loaded from file
 typedef struct _smp_smp SMP_SMP;
+//the loaded sample that the [audio-thread] reads, immutable after it is published
+typedef struct _smp_state SMP_STATE;
 //the sampler main struct that holds the samples and other data*/
 typedef struct _smp_info SMP_INFO;
 
@@ -29,15 +31,19 @@ int smp_add(SMP_INFO *smp_data, const char* samp_path, int in_id);
 //process the samples and return summed audio buffer
 //uses one callback to get_buffer from the sys_ports and another to get_notes from the midi sys_port
 int smp_sample_process_rt(SMP_INFO* smp_data, uint32_t nframes);
-//some the cur_smp buffer to out_L and out_R according to the number of channels of cur_smp
-static void smp_sum_channel_buffers_rt(SMP_SMP* cur_smp, SAMPLE_T* out_L, SAMPLE_T* out_R,
+//sum the smp_state buffer at offset to out_L and out_R according to the number of channels of smp_state
+static void smp_sum_channel_buffers_rt(const SMP_STATE* smp_state, int offset, SAMPLE_T* out_L, SAMPLE_T* out_R,
 				       SAMPLE_T mult, int chans);
 //param manipulation functions
+//return the parameter container of the sample, can be called on [main-thread] and [audio-thread]
 PRM_CONTAIN* smp_param_return_param_container(SMP_INFO* smp_data, int smp_id);
 
 //copy to new malloced string and return the file path of the sample
 char* smp_get_sample_file_path(SMP_INFO* smp_data, int smp_id);
-//stop processing the sample and remove it
+//remove the sample without waiting for the [audio-thread], its memory is freed in smp_read_rt_to_ui_messages
+//once the [audio-thread] can not play it anymore
 int smp_stop_and_remove_sample(SMP_INFO* smp_data, int idx);
+//remove the samples with ids, same as smp_stop_and_remove_sample for each id
+int smp_stop_and_remove_samples(SMP_INFO* smp_data, const int* ids, unsigned int num_ids);
 //clean the memory
 int smp_clean_memory(SMP_INFO *smp_data);
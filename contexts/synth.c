@@ -14,8 +14,18 @@ static thread_local bool is_audio_thread = false;
 
 //max voices that can play simultaniously
 #define MAX_SYNTH_VOICES 8
-//how many oscillators there should be
-#define MAX_OSCS 3
+//how many oscillators there can be, the oscillator buffers and ports are allocated only when the oscillator is added
+#define MAX_OSCS 16
+//how many oscillators are created when the synth is initialized
+#define SYNTH_INIT_OSCS 2
+//the length of the metronome click in seconds
+#define MTR_CLICK_TIME 0.05
+//the decay time constant of the metronome click in seconds
+#define MTR_CLICK_DECAY 0.012
+//the amplitude of the metronome click
+#define MTR_CLICK_AMP 0.8
+//how long the oscillator amp parameter ramps to a new value in ms
+#define SYNTH_AMP_RAMP_MS 20
 //number of output Audio ports for the whole synth
 #define SYNTH_OUTS 2
 //number of midi in ports for the synth
@@ -30,6 +40,88 @@ static thread_local bool is_audio_thread = false;
 #define SEMITONES_INC 0.1
 //the longest that the a, d or r in ADSR can be in seconds
 #define ADSR_MAX_TIME 5
+//how many fm/pm modulators can modulate one oscillator
+#define SYNTH_MOD_SLOTS 2
+//the parameter id of the first modulation slot parameter, each slot has 3 parameters - Osc, Amt, Type
+#define SYNTH_MOD_PARAM_START 10
+//maximum unison sub-voices per voice
+#define MAX_UNISON 7
+//the parameter id of the first unison parameter - Unison, Uni_Detune, Uni_Width
+#define SYNTH_UNI_PARAM_START 16
+//the most semitones that the outer unison sub-voices can be detuned by
+#define UNISON_MAX_DETUNE 1.0
+//how many routes the modulation matrix has per oscillator
+#define SYNTH_MATRIX_SLOTS 4
+//the parameter id of the first matrix route parameter, each route has 3 parameters - Src, Dst, Amt
+#define SYNTH_MATRIX_PARAM_START 19
+//how many lfos each oscillator has for the modulation matrix
+#define SYNTH_LFOS 2
+//the parameter id of the first lfo rate parameter
+#define SYNTH_LFO_PARAM_START 31
+//the parameter id of the midi cc number that is used as the cc source in the modulation matrix
+#define SYNTH_CC_PARAM 33
+//how many parameters each oscillator has
+#define SYNTH_NUM_PARAMS 34
+//how many parameters can be the destination of a modulation matrix route
+#define SYNTH_MATRIX_DESTS 8
+
+//sources for the modulation matrix routes, the order is the same as the Src parameter strings
+enum SynthMatrixSource{
+    Matrix_src_off = 0,
+    Matrix_src_lfo1 = 1,
+    Matrix_src_lfo2 = 2,
+    //the voice amp adsr
+    Matrix_src_env = 3,
+    //the voice midi velocity
+    Matrix_src_vel = 4,
+    //the midi cc set with the Mod_CC parameter
+    Matrix_src_cc = 5
+};
+
+//the oscillator parameters
+//Mod1 and Mod2 are the fm/pm modulation slots, Osc is the id of the modulating oscillator (-1 is off)
+//Unison is how many detuned sub-voices each voice plays, Uni_Detune and Uni_Width spread them in pitch and stereo
+//Mtx routes add the Src value multiplied by Amt and by the range of the Dst parameter to the Dst parameter
+static char* synth_param_names[SYNTH_NUM_PARAMS] = {"Amp", "Freq", "Spread", "Wobble", "Octave", "Table", "A", "D", "S", "R",
+    "Mod1_Osc", "Mod1_Amt", "Mod1_Type", "Mod2_Osc", "Mod2_Amt", "Mod2_Type",
+    "Unison", "Uni_Detune", "Uni_Width",
+    "Mtx1_Src", "Mtx1_Dst", "Mtx1_Amt", "Mtx2_Src", "Mtx2_Dst", "Mtx2_Amt",
+    "Mtx3_Src", "Mtx3_Dst", "Mtx3_Amt", "Mtx4_Src", "Mtx4_Dst", "Mtx4_Amt",
+    "Lfo1_Rate", "Lfo2_Rate", "Mod_CC"};
+static PARAM_T synth_param_vals[SYNTH_NUM_PARAMS] = {0.8, 0, 0, 0, 0, 0, 0.0, 0.0, 1.0, 0.001,
+    -1, 0.0, 0, -1, 0.0, 0,
+    1, 0.2, 0.5,
+    0, 0, 0.0, 0, 0, 0.0,
+    0, 0, 0.0, 0, 0, 0.0,
+    1.0, 0.2, 1};
+static PARAM_T synth_param_mins[SYNTH_NUM_PARAMS] = {0.00001, -12, 0, 0, ((MAX_SEMITONES - 12)/12)*-1, 0, 0.0, 0.0, 0.0, 0.0,
+    -1, 0.0, 0, -1, 0.0, 0,
+    1, 0.0, 0.0,
+    0, 0, -1.0, 0, 0, -1.0,
+    0, 0, -1.0, 0, 0, -1.0,
+    0.01, 0.01, 0};
+static PARAM_T synth_param_maxs[SYNTH_NUM_PARAMS] = {1, 12, 1, 1, (MAX_SEMITONES - 12)/12, 3, 5.0, 5.0, 1.0, 5.0,
+    MAX_OSCS - 1, 2.0, 1, MAX_OSCS - 1, 2.0, 1,
+    MAX_UNISON, 1.0, 1.0,
+    5, SYNTH_MATRIX_DESTS - 1, 1.0, 5, SYNTH_MATRIX_DESTS - 1, 1.0,
+    5, SYNTH_MATRIX_DESTS - 1, 1.0, 5, SYNTH_MATRIX_DESTS - 1, 1.0,
+    20.0, 20.0, 127};
+static PARAM_T synth_param_incs[SYNTH_NUM_PARAMS] = {0.01, 0.1, 0.01, 0.05, 1, 1, 0.1, 0.1, 0.01, 0.1,
+    1, 0.01, 1, 1, 0.01, 1,
+    1, 0.01, 0.01,
+    1, 1, 0.01, 1, 1, 0.01,
+    1, 1, 0.01, 1, 1, 0.01,
+    0.01, 0.01, 1};
+static unsigned char synth_param_types[SYNTH_NUM_PARAMS] = {DB_Return_Type, Float_type, Float_type, Float_type, Int_type, String_Return_Type,
+    Curve_Float_Return_Type, Curve_Float_Return_Type, Float_type, Curve_Float_Return_Type,
+    Int_type, Float_type, String_Return_Type, Int_type, Float_type, String_Return_Type,
+    Int_type, Float_type, Float_type,
+    String_Return_Type, String_Return_Type, Float_type, String_Return_Type, String_Return_Type, Float_type,
+    String_Return_Type, String_Return_Type, Float_type, String_Return_Type, String_Return_Type, Float_type,
+    Float_type, Float_type, Int_type};
+//the parameter ids that the modulation matrix can modulate, the order is the same as the Dst parameter strings
+static const int synth_matrix_dests[SYNTH_MATRIX_DESTS] = {0, 1, 2, 3, SYNTH_MOD_PARAM_START + 1, SYNTH_MOD_PARAM_START + 4,
+    SYNTH_UNI_PARAM_START + 1, SYNTH_UNI_PARAM_START + 2};
 
 typedef struct _synth_adsr{
     PARAM_T amp;//the current calculated amp from the adsr
@@ -60,8 +152,8 @@ typedef struct _synth_voice{
     PRM_INTERP_VAL* vco_amp_R;
     //the voice amp adsr
     SYNTH_ADSR* vco_adsr;
-    //the current phase of the vco
-    PARAM_T vco_ph;
+    //the current phases of the vco unison sub-voices, with unison 1 only the first is used
+    PARAM_T vco_ph[MAX_UNISON];
     //the current phase of the detune wobble lfo
     PARAM_T wobble_ph;
     //random seed for random stuff in the voice, this should
@@ -69,21 +161,50 @@ typedef struct _synth_voice{
     unsigned int rand_seed;
     //address of the table to use when playing
     OSC_OBJ* osc_table;
+    //phases and adsrs of the modulators, the modulators are rendered per voice with this voices midi note
+    PARAM_T mod_ph[SYNTH_MOD_SLOTS];
+    SYNTH_ADSR* mod_adsr[SYNTH_MOD_SLOTS];
 }SYNTH_VOICE;
 
+//modulation matrix route values for one block
+typedef struct _synth_matrix_route{
+    //SynthMatrixSource
+    unsigned int src;
+    //the parameter id of the destination, -1 if the route is not used
+    int dst;
+    //the amount already multiplied by the destination parameter range
+    PARAM_T amt;
+}SYNTH_MATRIX_ROUTE;
+
+//modulation slot values for one block, gathered from the carrier and modulator parameters before rendering the voices
+typedef struct _synth_mod_slot{
+    //the modulating oscillator, NULL if the slot is not used
+    SYNTH_OSC* mod_osc;
+    //the table of the modulator
+    OSC_OBJ* table;
+    //0 - pm, 1 - fm
+    unsigned int type;
+    //frequency ratio of the modulator to the voice note from the modulators Freq and Octave parameters
+    PARAM_T freq_ratio;
+    //the modulators adsr values
+    PARAM_T a;
+    PARAM_T d;
+    PARAM_T s;
+    PARAM_T r;
+}SYNTH_MOD_SLOT;
+
 typedef struct _synth_osc{
     int id;
-    //trigger, that can be used to track various oscillator behaviour
-    //for example for metronome osc this is used to test if the oscillator needs to be played
-    //starts at -1, when the osc is initialized for the first time
-    int trig;
+    //1 while the removal of this oscillator is submitted to the [audio-thread], touch only on [main-thread]
+    unsigned int remove_pending;
+    //grows each time the oscillator is cleaned, so the done function of a removal can tell if it was created again since, touch only on [main-thread]
+    unsigned int generation;
     //name of the osc that will be returned to the ui
     char* name;
     //the voice array for the oscillator
     //the voice gets its parameters from this struct
     SYNTH_VOICE* osc_voices;
-    //the number of voices for the oscillator, usually its the same amount for all oscillators
-    //but for example the metronome only has 2
+    //the number of voices for the oscillator
     unsigned int num_voices;
     //parameter container for the oscillator
     PRM_CONTAIN* params;
@@ -102,6 +223,12 @@ typedef struct _synth_osc{
     SYNTH_PORT* ports;
     //how many ports are there
     unsigned int num_ports;
+    //if processing == 0 the oscillator will not run on the [audio-thread]
+    unsigned int processing;
+    //phases of the modulation matrix lfos, the lfos are free running for the whole oscillator
+    PARAM_T lfo_ph[SYNTH_LFOS];
+    //the last value of the Mod_CC midi cc from 0 to 1
+    PARAM_T cc_val;
 }SYNTH_OSC;
 
 typedef struct _synth_port{
@@ -134,22 +261,43 @@ typedef struct _synth_data{
     MATH_RANGE_TABLE* log_curve;
     //table that has the exponential conversion for amplitude (so 0.5 amp is half the percieved loudness or 0.0313 or so)
     MATH_RANGE_TABLE* amp_to_exp;
+    //scratch buffers for the summed phase and frequency modulation of the voice that is being rendered
+    PARAM_T* pm_buffer;
+    PARAM_T* fm_buffer;
+    //the smoothed amp parameter of the oscillator that is being rendered
+    SAMPLE_T* amp_ramp;
     //sample rate for the current audio system (48000, 44100 etc.)
     SAMPLE_T samplerate;
     //should the metronome be initialized and processed
     unsigned int with_metronome;
+    //the metronome clicks, rendered once on init and copied to the metronome ports on each beat
+    SAMPLE_T* mtr_click_accent;
+    SAMPLE_T* mtr_click_normal;
+    //length of the click buffers in frames
+    NFRAMES_T mtr_click_len;
+    //the click that is playing now, NULL if none, and the position in it, touch only on [audio-thread]
+    SAMPLE_T* mtr_click;
+    NFRAMES_T mtr_click_pos;
+    //the bar and beat of the last click, so the same beat is not clicked twice, touch only on [audio-thread]
+    int32_t mtr_last_bar;
+    int32_t mtr_last_beat;
+    //the metronome output ports (out_L and out_R)
+    SYNTH_PORT* mtr_ports;
+    unsigned int mtr_num_ports;
+    //name of the synth context, used for the port names of the oscillators
+    char* cx_name;
     //the synth oscillators
-    //Synth_Osc 0 is reserved for the metronome
+    //the slots with params == NULL are empty oscillators, that are not allocated yet
     SYNTH_OSC* osc_array;
-    //how many oscilators we have
+    //how many oscilator slots we have
     unsigned int num_osc;
-    //midi container that holds the notes, velocities etc.
-    JACK_MIDI_CONT* midi_cont;
     //this is the audio backend object to send to the audio functions
     void* audio_backend;
     //this is control for [audio-thread] and [main-thread] sys communication
-    //(since there is no need to remove and add the oscillators this is used right now only for thread safe message sending)
+    //(stop processing the oscillator before removing it, start processing a new oscillator and thread safe message sending)
     CXCONTROL* control_data;
+    //the parameter messages of all the oscillators go through these rings
+    PRM_RINGS* param_rings;
 }SYNTH_DATA;
 
 static int synth_sys_msg(void* user_data, const char* msg){
@@ -158,19 +306,32 @@ static int synth_sys_msg(void* user_data, const char* msg){
     return 0;
 }
 
+static int synth_start_process(void* user_data){
+    SYNTH_OSC* osc = (SYNTH_OSC*)user_data;
+    if(!osc)return -1;
+    if(osc->processing == 1)return 0;
+    if(!osc->params || !osc->osc_voices)return -1;
+    osc->processing = 1;
+    return 0;
+}
+
+static int synth_stop_process(void* user_data){
+    SYNTH_OSC* osc = (SYNTH_OSC*)user_data;
+    if(!osc)return -1;
+    if(osc->processing == 0)return 0;
+    osc->processing = 0;
+    return 0;
+}
+
 int synth_read_ui_to_rt_messages(SYNTH_DATA* synth_data){
     //this is a local thread var its false on [main-thread] and true on [audio-thread]
     is_audio_thread = true;
 
     if(!synth_data)return -1;
-    //process the sys messages, right now only need for send messages, so on [audio-thread] does not do anything
+    //process the sys messages, start or stop processing the oscillators
     context_sub_process_rt(synth_data->control_data);
-    
-    for(unsigned int i = 0; i < MAX_OSCS; i++){
-	SYNTH_OSC* osc = &(synth_data->osc_array[i]);
-	if(!osc->params)continue;
-	param_msgs_process(osc->params, 1);
-    }
+    //read the param ui_to_rt messages for all the oscillators
+    param_msgs_process(synth_data->param_rings, 1);
     return 0;
 }
 int synth_read_rt_to_ui_messages(SYNTH_DATA* synth_data){
@@ -179,11 +340,7 @@ int synth_read_rt_to_ui_messages(SYNTH_DATA* synth_data){
     context_sub_process_ui(synth_data->control_data);
     
     //read the param rt_to_ui messages and set the parameter values
-    for(unsigned int i = 0; i < MAX_OSCS; i++){
-	SYNTH_OSC* osc = &(synth_data->osc_array[i]);
-	if(!osc->params)continue;
-	param_msgs_process(osc->params, 0);
-    }    
+    param_msgs_process(synth_data->param_rings, 0);
     return 0;
 }
 
@@ -204,6 +361,158 @@ static SYNTH_ADSR* synth_init_adsr(SAMPLE_T samplerate){
     return adsr;
 }
 
+//create the port names and the port structs for the oscillator
+static int synth_init_osc_ports(SYNTH_DATA* synth_data, SYNTH_OSC* cur_osc){
+    if(!synth_data || !cur_osc)return -1;
+    cur_osc->num_ports = SYNTH_OUTS + SYNTH_IN_MIDI;
+    cur_osc->ports = (SYNTH_PORT*)calloc(cur_osc->num_ports, sizeof(SYNTH_PORT));
+    if(!cur_osc->ports)return -1;
+
+    for(int j = 0; j < cur_osc->num_ports; j++){
+	SYNTH_PORT* cur_port = &(cur_osc->ports[j]);
+	cur_port->id = j;
+	cur_port->port_name = NULL;
+	cur_port->sys_port = NULL;
+	unsigned int port_num = j;
+	
+	unsigned int name_len = strlen(synth_data->cx_name);
+	name_len += strlen(cur_osc->name);
+	name_len += 10;
+	cur_port->port_name = malloc(sizeof(char) * name_len);
+	if(!cur_port->port_name)return -1;
+	if(port_num==0){
+	    cur_port->port_flow = FLOW_INPUT;
+	    cur_port->port_type = TYPE_MIDI;
+	    snprintf(cur_port->port_name, name_len, "%s|%s|midi_in", synth_data->cx_name, cur_osc->name);
+	}
+	if(port_num==1){
+	    cur_port->port_flow = FLOW_OUTPUT;
+	    cur_port->port_type = TYPE_AUDIO;
+	    snprintf(cur_port->port_name, name_len, "%s|%s|out_L", synth_data->cx_name, cur_osc->name);
+	}
+	if(port_num==2){
+	    cur_port->port_flow = FLOW_OUTPUT;
+	    cur_port->port_type = TYPE_AUDIO;
+	    snprintf(cur_port->port_name, name_len, "%s|%s|out_R", synth_data->cx_name, cur_osc->name);
+	}
+    }
+    return 0;
+}
+
+//allocate the buffers, voices, parameters and register the ports for the oscillator
+//the osc is not processed on the [audio-thread] until its processing member is set to 1
+static int synth_init_osc(SYNTH_DATA* synth_data, SYNTH_OSC* cur_osc){
+    if(!synth_data || !cur_osc)return -1;
+    cur_osc->last_voice = 0;
+    cur_osc->processing = 0;
+    for(int k = 0; k < SYNTH_LFOS; k++)cur_osc->lfo_ph[k] = 0;
+    cur_osc->cc_val = 0;
+    cur_osc->num_voices = MAX_SYNTH_VOICES;
+    //initiate the buffer
+    cur_osc->buffer_L = calloc(synth_data->buffer_size, sizeof(SAMPLE_T));
+    cur_osc->buffer_R = calloc(synth_data->buffer_size, sizeof(SAMPLE_T));
+    if(!cur_osc->buffer_L || !cur_osc->buffer_R)return -1;
+    
+    cur_osc->name = malloc(sizeof(char) * 12);
+    if(!cur_osc->name)return -1;
+    snprintf(cur_osc->name, 12, "Osc_%d", cur_osc->id);
+    
+    //create the oscillator ports
+    if(synth_init_osc_ports(synth_data, cur_osc) != 0)return -1;
+	
+    cur_osc->osc_voices = (SYNTH_VOICE*)calloc(cur_osc->num_voices, sizeof(SYNTH_VOICE));
+    if(!cur_osc->osc_voices)return -1;
+    for(int j = 0; j < cur_osc->num_voices; j++){
+	SYNTH_VOICE* cur_voice = &(cur_osc->osc_voices[j]);
+	cur_voice->vco_amp_L = params_init_interpolated_val(1.0, (unsigned int)(0.002 * synth_data->samplerate));
+	cur_voice->vco_amp_R = params_init_interpolated_val(1.0, (unsigned int)(0.002 * synth_data->samplerate));
+	cur_voice->vco_adsr = synth_init_adsr(synth_data->samplerate);
+	for(int k = 0; k < MAX_UNISON; k++)cur_voice->vco_ph[k] = 0;
+	cur_voice->wobble_ph = 0;
+	cur_voice->id = j;
+	cur_voice->midi_note = 0;
+	cur_voice->midi_vel = 0;
+	cur_voice->playing = 0;
+	cur_voice->stopped = 1;
+	cur_voice->rand_seed = 0;
+	cur_voice->osc_table = NULL;
+	for(int k = 0; k < SYNTH_MOD_SLOTS; k++){
+	    cur_voice->mod_ph[k] = 0;
+	    cur_voice->mod_adsr[k] = synth_init_adsr(synth_data->samplerate);
+	}
+    }
+
+    cur_osc->params = params_init_param_container(SYNTH_NUM_PARAMS, synth_param_names, synth_param_vals, synth_param_mins, synth_param_maxs,
+						  synth_param_incs, synth_param_types, NULL, NULL, synth_data->param_rings);
+    if(!cur_osc->params)return -1;
+    //write strings to parameters that are String_Return_Type
+    param_set_param_strings(cur_osc->params, 5, (char* [4]){"sin", "triang", "saw", "sqr"}, 4);
+    for(int k = 0; k < SYNTH_MOD_SLOTS; k++){
+	param_set_param_strings(cur_osc->params, SYNTH_MOD_PARAM_START + k*3 + 2, (char* [2]){"pm", "fm"}, 2);
+    }
+    for(int k = 0; k < SYNTH_MATRIX_SLOTS; k++){
+	param_set_param_strings(cur_osc->params, SYNTH_MATRIX_PARAM_START + k*3, (char* [6]){"off", "lfo1", "lfo2", "env", "vel", "cc"}, 6);
+	param_set_param_strings(cur_osc->params, SYNTH_MATRIX_PARAM_START + k*3 + 1,
+				(char* [SYNTH_MATRIX_DESTS]){"Amp", "Freq", "Spread", "Wobble", "Mod1_Amt", "Mod2_Amt", "Uni_Detune", "Uni_Width"},
+				SYNTH_MATRIX_DESTS);
+    }
+    //put a curve table for the params that should be returned as curves
+    param_add_curve_table(cur_osc->params, 6, synth_data->amp_to_exp);
+    param_add_curve_table(cur_osc->params, 7, synth_data->amp_to_exp);
+    param_add_curve_table(cur_osc->params, 9, synth_data->amp_to_exp);
+    //smooth the amp so changing it does not click, no matter the buffer size
+    param_set_ramp(cur_osc->params, 0, Ramp_Linear, SYNTH_AMP_RAMP_MS, synth_data->samplerate);
+
+    synth_activate_backend_ports(synth_data, cur_osc);
+    return 0;
+}
+
+//render one metronome click, a sine with a short attack and an exponential decay
+static SAMPLE_T* synth_render_click(SYNTH_DATA* synth_data, MIDI_DATA_T pitch){
+    SAMPLE_T* click = calloc(synth_data->mtr_click_len, sizeof(SAMPLE_T));
+    if(!click)return NULL;
+    PARAM_T freq = midi_note_to_freq(pitch);
+    //1ms attack so the click does not pop
+    PARAM_T attack_frames = 0.001 * synth_data->samplerate;
+    for(NFRAMES_T i = 0; i < synth_data->mtr_click_len; i++){
+	PARAM_T time = (PARAM_T)i / synth_data->samplerate;
+	PARAM_T env = exp(-time / MTR_CLICK_DECAY);
+	if(i < attack_frames)env = env * ((PARAM_T)i / attack_frames);
+	click[i] = (SAMPLE_T)(sin(2.0 * M_PI * freq * time) * env * MTR_CLICK_AMP);
+    }
+    return click;
+}
+
+//render the accent and normal metronome clicks and create the metronome output ports
+static int synth_init_metronome(SYNTH_DATA* synth_data){
+    if(!synth_data)return -1;
+    synth_data->mtr_click_len = (NFRAMES_T)(MTR_CLICK_TIME * synth_data->samplerate);
+    synth_data->mtr_click_accent = synth_render_click(synth_data, 72);
+    synth_data->mtr_click_normal = synth_render_click(synth_data, 60);
+    if(!synth_data->mtr_click_accent || !synth_data->mtr_click_normal)return -1;
+
+    synth_data->mtr_num_ports = SYNTH_OUTS;
+    synth_data->mtr_ports = (SYNTH_PORT*)calloc(synth_data->mtr_num_ports, sizeof(SYNTH_PORT));
+    if(!synth_data->mtr_ports)return -1;
+    const char* port_names[SYNTH_OUTS] = {"out_L", "out_R"};
+    for(int j = 0; j < synth_data->mtr_num_ports; j++){
+	SYNTH_PORT* cur_port = &(synth_data->mtr_ports[j]);
+	cur_port->id = j;
+	cur_port->port_flow = FLOW_OUTPUT;
+	cur_port->port_type = TYPE_AUDIO;
+	unsigned int name_len = strlen(synth_data->cx_name) + 16;
+	cur_port->port_name = malloc(sizeof(char) * name_len);
+	if(!cur_port->port_name)return -1;
+	snprintf(cur_port->port_name, name_len, "%s|Mtr|%s", synth_data->cx_name, port_names[j]);
+	cur_port->sys_port = NULL;
+	if(synth_data->audio_backend){
+	    cur_port->sys_port = app_jack_create_port_on_client(synth_data->audio_backend, cur_port->port_type,
+								    cur_port->port_flow, cur_port->port_name);
+	}
+    }
+    return 0;
+}
+
 SYNTH_DATA* synth_init (unsigned int buffer_size, SAMPLE_T sample_rate, const char* cx_name, unsigned int with_metronome,
 			void* audio_backend){
 
@@ -211,6 +520,8 @@ SYNTH_DATA* synth_init (unsigned int buffer_size, SAMPLE_T sample_rate, const ch
     if(!synth_data)return NULL;
     CXCONTROL_RT_FUNCS rt_funcs_struct = {0};
     CXCONTROL_UI_FUNCS ui_funcs_struct = {0};
+    rt_funcs_struct.subcx_start_process = synth_start_process;
+    rt_funcs_struct.subcx_stop_process = synth_stop_process;
     ui_funcs_struct.send_msg = synth_sys_msg;
     synth_data->control_data = context_sub_init(rt_funcs_struct, ui_funcs_struct);
     if(!synth_data->control_data){
@@ -222,15 +533,41 @@ SYNTH_DATA* synth_init (unsigned int buffer_size, SAMPLE_T sample_rate, const ch
     synth_data->with_metronome = with_metronome;
     synth_data->num_osc = MAX_OSCS;
     synth_data->osc_array = NULL;
+    synth_data->cx_name = NULL;
     synth_data->saw_osc = NULL;
     synth_data->sqr_osc = NULL;
     synth_data->triang_osc = NULL;
     synth_data->sin_osc = NULL;
-    synth_data->midi_cont = NULL;
     synth_data->audio_backend = audio_backend;
     synth_data->semi_to_freq_table = NULL;
     synth_data->log_curve = NULL;
     synth_data->amp_to_exp = NULL;
+    synth_data->pm_buffer = NULL;
+    synth_data->fm_buffer = NULL;
+    synth_data->amp_ramp = NULL;
+    synth_data->mtr_click_accent = NULL;
+    synth_data->mtr_click_normal = NULL;
+    synth_data->mtr_click_len = 0;
+    synth_data->mtr_click = NULL;
+    synth_data->mtr_click_pos = 0;
+    synth_data->mtr_last_bar = -1;
+    synth_data->mtr_last_beat = -1;
+    synth_data->mtr_ports = NULL;
+    synth_data->mtr_num_ports = 0;
+    synth_data->param_rings = NULL;
+
+    synth_data->param_rings = params_init_param_rings(app_jack_frame_time, audio_backend);
+    if(!synth_data->param_rings){
+	synth_clean_memory(synth_data);
+	return NULL;
+    }
+
+    synth_data->cx_name = malloc(sizeof(char) * (strlen(cx_name) + 1));
+    if(!synth_data->cx_name){
+	synth_clean_memory(synth_data);
+	return NULL;
+    }
+    strcpy(synth_data->cx_name, cx_name);
     
     synth_data->semi_to_freq_table = math_init_range_table(MAX_SEMITONES * -1, MAX_SEMITONES, SEMITONES_INC);
     
@@ -276,13 +613,14 @@ SYNTH_DATA* synth_init (unsigned int buffer_size, SAMPLE_T sample_rate, const ch
     }
 
     
-    //init the midi container
-    synth_data->midi_cont = app_jack_init_midi_cont(MAX_MIDI_CONT_ITEMS);
-    if(!synth_data->midi_cont){
+    synth_data->pm_buffer = calloc(synth_data->buffer_size, sizeof(PARAM_T));
+    synth_data->fm_buffer = calloc(synth_data->buffer_size, sizeof(PARAM_T));
+    synth_data->amp_ramp = calloc(synth_data->buffer_size, sizeof(SAMPLE_T));
+    if(!synth_data->pm_buffer || !synth_data->fm_buffer || !synth_data->amp_ramp){
 	synth_clean_memory(synth_data);
 	return NULL;
     }
-
+    
     //init the wavetable objects
     synth_data->sin_osc = osc_init_osc_wavetable(SIN_WAVETABLE, synth_data->samplerate);
     if(!synth_data->sin_osc){
@@ -305,6 +643,7 @@ SYNTH_DATA* synth_init (unsigned int buffer_size, SAMPLE_T sample_rate, const ch
 	return NULL;
     }
 
+    //the oscillator slots are empty, buffers, voices and ports are only allocated when the oscillator is added
     synth_data->osc_array = (SYNTH_OSC*)calloc(synth_data->num_osc, sizeof(SYNTH_OSC));
     if(!synth_data->osc_array){
 	synth_clean_memory(synth_data);
@@ -312,187 +651,136 @@ SYNTH_DATA* synth_init (unsigned int buffer_size, SAMPLE_T sample_rate, const ch
     }
     for(int i = 0; i < synth_data->num_osc; i++){
 	SYNTH_OSC* cur_osc = &(synth_data->osc_array[i]);
-	cur_osc->name = NULL;
 	cur_osc->triang_osc = synth_data->triang_osc;
 	cur_osc->sqr_osc = synth_data->sqr_osc;
 	cur_osc->saw_osc = synth_data->saw_osc;
 	cur_osc->sin_osc = synth_data->sin_osc;
 	cur_osc->id = i;
-	cur_osc->trig = -1;    
+	cur_osc->remove_pending = 0;
+	cur_osc->generation = 0;
 	cur_osc->last_voice = 0;
-	cur_osc->num_ports = 0;
+	cur_osc->processing = 0;
 	cur_osc->params = NULL;
 	cur_osc->osc_voices = NULL;
-	cur_osc->ports = NULL;
+	cur_osc->num_voices = 0;
 	cur_osc->buffer_L = NULL;
 	cur_osc->buffer_R = NULL;
 	cur_osc->name = NULL;
 	cur_osc->num_ports = 0;
 	cur_osc->ports = NULL;
-	cur_osc->num_voices = MAX_SYNTH_VOICES;	
-	//initiate the buffer
-	cur_osc->buffer_L = calloc(synth_data->buffer_size, sizeof(SAMPLE_T));
-	cur_osc->buffer_R = calloc(synth_data->buffer_size, sizeof(SAMPLE_T));
-	if(!cur_osc->buffer_L || !cur_osc->buffer_R){
-	    synth_clean_memory(synth_data);
-	    return NULL;
-	}
-	cur_osc->name = malloc(sizeof(char) * 6);
-	if(!cur_osc->name){
-	    synth_clean_memory(synth_data);
-	    return NULL;
-	}
-	sprintf(cur_osc->name, "Osc_%u", i);
-	
-	//create the oscillator ports
-	cur_osc->num_ports = SYNTH_OUTS + SYNTH_IN_MIDI;
-	cur_osc->ports = (SYNTH_PORT*)calloc(cur_osc->num_ports, sizeof(SYNTH_PORT));
-	if(!cur_osc->ports){
+	for(int k = 0; k < SYNTH_LFOS; k++)cur_osc->lfo_ph[k] = 0;
+	cur_osc->cc_val = 0;
+    }
+
+    //render the metronome clicks and create the metronome ports
+    if(synth_data->with_metronome == 1){
+	if(synth_init_metronome(synth_data) != 0){
 	    synth_clean_memory(synth_data);
 	    return NULL;
 	}
+    }
 
-	for(int j = 0; j < cur_osc->num_ports; j++){
-	    SYNTH_PORT* cur_port = &(cur_osc->ports[j]);
-	    
-	    unsigned int name_len = strlen(cx_name);
-	    name_len += strlen(cur_osc->name);
-	    
-	    cur_port->id = j;
-	    if(j==0){
-		cur_port->port_flow = FLOW_INPUT;
-		cur_port->port_type = TYPE_MIDI;
-		name_len += 10;
-		cur_port->port_name = malloc(sizeof(char) * name_len);
-		if(!cur_port->port_name){
-		    synth_clean_memory(synth_data);
-		    return NULL;
-		}
-		sprintf(cur_port->port_name, "%s|%s|midi_in", cx_name, cur_osc->name, i);
-	    }
-	    if(j==1){
-		cur_port->port_flow = FLOW_OUTPUT;
-		cur_port->port_type = TYPE_AUDIO;
-		name_len += 8;
-		cur_port->port_name = malloc(sizeof(char) * name_len);
-		if(!cur_port->port_name){
-		    synth_clean_memory(synth_data);
-		    return NULL;
-		}
-		sprintf(cur_port->port_name, "%s|%s|out_L", cx_name, cur_osc->name, i);
-	    }
-	    if(j==2){
-		cur_port->port_flow = FLOW_OUTPUT;
-		cur_port->port_type = TYPE_AUDIO;
-		name_len += 8;
-		cur_port->port_name = malloc(sizeof(char) * name_len);
-		if(!cur_port->port_name){
-		    synth_clean_memory(synth_data);
-		    return NULL;
-		}
-		sprintf(cur_port->port_name, "%s|%s|out_R", cx_name, cur_osc->name, i);
-	    }
-	}
-	
-	//if this is the 0 oscillator and the metronome should be initialized 
-	if(i == 0 && synth_data->with_metronome == 1){
-	    cur_osc->num_voices = 2;
-	    if(cur_osc->name)free(cur_osc->name);
-	    cur_osc->name = malloc(sizeof(char) * 4);
-	    if(!cur_osc->name){
-		synth_clean_memory(synth_data);
-		return NULL;
-	    }
-	    sprintf(cur_osc->name, "Mtr");
-	    //change the ports
-	    synth_clean_ports(synth_data, &(cur_osc->ports), cur_osc->num_ports);
-	    cur_osc->num_ports = SYNTH_OUTS;
-	    cur_osc->ports = (SYNTH_PORT*)calloc(cur_osc->num_ports, sizeof(SYNTH_PORT));
-	    if(!cur_osc->ports){
-		synth_clean_memory(synth_data);
-		return NULL;
-	    }
-
-	    for(int j = 0; j < cur_osc->num_ports; j++){
-		SYNTH_PORT* cur_port = &(cur_osc->ports[j]);
-		cur_port->id = j;
-		unsigned int name_len = strlen(cx_name);
-		name_len += strlen(cur_osc->name);		
-		if(j==0){
-		    cur_port->port_flow = FLOW_OUTPUT;
-		    cur_port->port_type = TYPE_AUDIO;
-		    name_len += 8;
-		    cur_port->port_name = malloc(sizeof(char) * name_len);
-		    if(!cur_port->port_name){
-			synth_clean_memory(synth_data);
-			return NULL;
-		    }
-		    sprintf(cur_port->port_name, "%s|%s|out_L", cx_name, cur_osc->name);
-		}
-		if(j==1){
-		    cur_port->port_flow = FLOW_OUTPUT;
-		    cur_port->port_type = TYPE_AUDIO;
-		    name_len += 8;
-		    cur_port->port_name = malloc(sizeof(char) * name_len);
-		    if(!cur_port->port_name){
-			synth_clean_memory(synth_data);
-			return NULL;
-		    }
-		    sprintf(cur_port->port_name, "%s|%s|out_R", cx_name, cur_osc->name);
-		}
-	    }
-	}
-	
-	cur_osc->osc_voices = (SYNTH_VOICE*)calloc(cur_osc->num_voices, sizeof(SYNTH_VOICE));
-	if(!cur_osc->osc_voices){
+    //create the default oscillators, they start from the 1 slot so they keep the ids and port names
+    //they had when the 0 slot was reserved for the metronome oscillator
+    //the synth is not processed on the [audio-thread] yet (app_data is not processing), so set the processing directly
+    for(int i = 1; i <= SYNTH_INIT_OSCS && i < synth_data->num_osc; i++){
+	SYNTH_OSC* cur_osc = &(synth_data->osc_array[i]);
+	if(synth_init_osc(synth_data, cur_osc) != 0){
 	    synth_clean_memory(synth_data);
 	    return NULL;
 	}
-	for(int j = 0; j < cur_osc->num_voices; j++){
-	    SYNTH_VOICE* cur_voice = &(cur_osc->osc_voices[j]);
-	    cur_voice->vco_amp_L = params_init_interpolated_val(1.0, (unsigned int)(0.002 * synth_data->samplerate));
-	    cur_voice->vco_amp_R = params_init_interpolated_val(1.0, (unsigned int)(0.002 * synth_data->samplerate));
-	    cur_voice->vco_adsr = synth_init_adsr(synth_data->samplerate);
-	    cur_voice->vco_ph = 0;
-	    cur_voice->wobble_ph = 0;
-	    cur_voice->id = j;
-	    cur_voice->midi_note = 0;
-	    cur_voice->midi_vel = 0;
-	    cur_voice->playing = 0;
-	    cur_voice->stopped = 1;
-	    cur_voice->rand_seed = 0;
-	    cur_voice->osc_table = NULL;
-	}
-
-	cur_osc->params = params_init_param_container(10, (char* [10]){"Amp", "Freq", "Spread", "Wobble", "Octave", "Table", "A", "D", "S", "R"},
-						      (PARAM_T [10]){0.8, 0, 0, 0, 0, 0, 0.0, 0.0, 1.0, 0.001},
-						      (PARAM_T [10]){0.00001, -12, 0, 0, ((MAX_SEMITONES - 12)/12)*-1, 0, 0.0, 0.0, 0.0, 0.0},
-						      (PARAM_T [10]){1, 12, 1, 1, (MAX_SEMITONES - 12)/12, 3, 5.0, 5.0, 1.0, 5.0},
-						      (PARAM_T [10]){0.01, 0.1, 0.01, 0.05, 1, 1, 0.1, 0.1, 0.01, 0.1},
-						      (unsigned char [10]){DB_Return_Type, Float_type, Float_type, Float_type, Int_type, String_Return_Type,
-							  Curve_Float_Return_Type, Curve_Float_Return_Type, Float_type, Curve_Float_Return_Type},
-						      NULL, NULL);
-	//write strings to parameters that are String_Return_Type
-	param_set_param_strings(cur_osc->params, 5, (char* [4]){"sin", "triang", "saw", "sqr"}, 4);
-	//put a curve table for the params that should be returned as curves
-	param_add_curve_table(cur_osc->params, 6, synth_data->amp_to_exp);
-	param_add_curve_table(cur_osc->params, 7, synth_data->amp_to_exp);
-	param_add_curve_table(cur_osc->params, 9, synth_data->amp_to_exp);
-
-	synth_activate_backend_ports(synth_data, cur_osc);
+	cur_osc->processing = 1;
     }
     
     return synth_data;   
 }
 
+int synth_add_osc(SYNTH_DATA* synth_data, int osc_id){
+    if(!synth_data)return -1;
+    if(!synth_data->osc_array)return -1;
+    if(osc_id >= (int)synth_data->num_osc)return -1;
+    //find an empty oscillator slot if id is -1
+    if(osc_id < 0){
+	for(int i = 0; i < synth_data->num_osc; i++){
+	    SYNTH_OSC* cur_osc = &(synth_data->osc_array[i]);
+	    if(cur_osc->params)continue;
+	    osc_id = cur_osc->id;
+	    break;
+	}
+    }
+    if(osc_id < 0)return -1;
+    SYNTH_OSC* cur_osc = &(synth_data->osc_array[osc_id]);
+    //the oscillator is stopped and waits to be removed, remove it now so it can be created again
+    if(cur_osc->remove_pending == 1)synth_stop_and_remove_osc(synth_data, osc_id);
+    //the oscillator already exists, for example it was created on the synth init
+    if(cur_osc->params)return osc_id;
+
+    if(synth_init_osc(synth_data, cur_osc) != 0){
+	synth_clean_osc(synth_data, cur_osc);
+	return -1;
+    }
+    //now this oscillator can start processing, without waiting for the [audio-thread]
+    context_sub_start(synth_data->control_data, (void*)cur_osc, 0);
+    return osc_id;
+}
+
+int synth_stop_and_remove_osc(SYNTH_DATA* synth_data, int osc_id){
+    if(!synth_data)return -1;
+    if(!synth_data->osc_array)return -1;
+    if(osc_id < 0 || osc_id >= (int)synth_data->num_osc)return -1;
+    SYNTH_OSC* cur_osc = &(synth_data->osc_array[osc_id]);
+    if(!cur_osc->params)return -1;
+    //stop processing the oscillator and then free its buffers and ports
+    context_sub_wait_for_stop(synth_data->control_data, (void*)cur_osc);
+    return synth_clean_osc(synth_data, cur_osc);
+}
+
+//called on [main-thread] when the [audio-thread] stopped the oscillator, if the slot was not cleaned in the meantime free the oscillator
+static void synth_clean_osc_done(void* done_data, void* user_data, unsigned int generation, int result){
+    SYNTH_DATA* synth_data = (SYNTH_DATA*)done_data;
+    SYNTH_OSC* slot = (SYNTH_OSC*)user_data;
+    if(!synth_data || !slot)return;
+    //the oscillator was cleaned after the removal was submitted, it could be created again with its own removal on the way
+    if(slot->generation != generation)return;
+    synth_clean_osc(synth_data, slot);
+}
+
+//mark the removal of the oscillator as pending for context_sub_stop_and_remove, skip the empty oscillators and the ones that are being removed already
+static int synth_clean_osc_claim(void* user_data, unsigned int* generation){
+    SYNTH_OSC* slot = (SYNTH_OSC*)user_data;
+    if(!slot->params)return -1;
+    if(slot->remove_pending == 1)return -1;
+    slot->remove_pending = 1;
+    *generation = slot->generation;
+    return 0;
+}
+
+int synth_stop_and_remove_oscs(SYNTH_DATA* synth_data, const int* ids, unsigned int num_ids){
+    if(!synth_data || !ids)return -1;
+    if(!synth_data->osc_array)return -1;
+    //the oscillators are stopped in the same [audio-thread] cycle and removed when the done functions are called
+    return context_sub_stop_and_remove(synth_data->control_data, (void*)synth_data->osc_array, sizeof(SYNTH_OSC), synth_data->num_osc, ids, num_ids,
+				       synth_clean_osc_claim, synth_clean_osc_done, (void*)synth_data);
+}
+
 PRM_CONTAIN* synth_param_return_param_container(SYNTH_DATA* synth_data, int osc_id){
     if(!synth_data)return NULL;
-    if(osc_id >= MAX_OSCS)return NULL;
+    if(osc_id >= synth_data->num_osc || osc_id < 0)return NULL;
     SYNTH_OSC* cur_osc = &(synth_data->osc_array[osc_id]);
     if(!cur_osc->params)return NULL;
     return cur_osc->params;
 }
 
+PRM_CONTAIN* synth_param_return_param_container_rt(SYNTH_DATA* synth_data, int osc_id){
+    if(!synth_data)return NULL;
+    if(!synth_data->osc_array)return NULL;
+    if(osc_id >= synth_data->num_osc || osc_id < 0)return NULL;
+    SYNTH_OSC* cur_osc = &(synth_data->osc_array[osc_id]);
+    //the oscillator is removed only after it stopped processing
+    if(cur_osc->processing == 0)return NULL;
+    return cur_osc->params;
+}
+
 int synth_activate_backend_ports(SYNTH_DATA* synth_data, SYNTH_OSC* osc){
     if(!synth_data)return -1;
     if(!synth_data->audio_backend)return -1;
@@ -589,6 +877,163 @@ static void synth_adsr_update(SYNTH_ADSR* adsr, PARAM_T a, PARAM_T d, PARAM_T s,
     adsr->samplerate = samplerate;
 }
 
+//return the wavetable object from the Table parameter value
+static OSC_OBJ* synth_table_from_param(SYNTH_OSC* osc, PARAM_T table){
+    if(table == TRIANGLE_WAVETABLE)return osc->triang_osc;
+    if(table == SAW_WAVETABLE)return osc->saw_osc;
+    if(table == SQUARE_WAVETABLE)return osc->sqr_osc;
+    return osc->sin_osc;
+}
+
+//gather the modulation slot values for this block, so the voices dont need to read the parameters
+//returns how many slots are used
+static unsigned int synth_mod_slots_update(SYNTH_DATA* synth_data, SYNTH_OSC* osc, SYNTH_MOD_SLOT* slots){
+    unsigned int used = 0;
+    for(int k = 0; k < SYNTH_MOD_SLOTS; k++){
+	SYNTH_MOD_SLOT* slot = &(slots[k]);
+	slot->mod_osc = NULL;
+	int param_start = SYNTH_MOD_PARAM_START + k*3;
+	int mod_id = (int)param_get_value(osc->params, param_start, 0, 0, 1);
+	if(mod_id < 0 || mod_id >= synth_data->num_osc)continue;
+	//no feedback
+	if(mod_id == osc->id)continue;
+	SYNTH_OSC* mod_osc = &(synth_data->osc_array[mod_id]);
+	//the modulator can be removed only after it stopped processing, so check this on the [audio-thread]
+	if(mod_osc->processing == 0 || !mod_osc->params)continue;
+	slot->type = (unsigned int)param_get_value(osc->params, param_start + 2, 0, 0, 1);
+	PARAM_T mod_freq_in = param_get_value(mod_osc->params, 1, 0, 0, 1);
+	PARAM_T mod_octave_in = param_get_value(mod_osc->params, 4, 0, 0, 1);
+	slot->freq_ratio = math_range_table_convert_value(synth_data->semi_to_freq_table, mod_octave_in * 12 + mod_freq_in);
+	slot->table = synth_table_from_param(mod_osc, param_get_value(mod_osc->params, 5, 0, 0, 1));
+	slot->a = param_get_value(mod_osc->params, 6, 1, 0, 1);
+	slot->d = param_get_value(mod_osc->params, 7, 1, 0, 1);
+	slot->s = param_get_value(mod_osc->params, 8, 0, 0, 1);
+	slot->r = param_get_value(mod_osc->params, 9, 1, 0, 1);
+	slot->mod_osc = mod_osc;
+	used += 1;
+    }
+    return used;
+}
+
+//render the modulators for one voice into the synth_data pm_buffer and fm_buffer
+//the modulators play with the voices note, so modulator and carrier are always in tune
+//the modulation amounts are taken from the voice ctrl array, for pm its in cycles of the carrier, for fm its the ratio of the carrier frequency
+static void synth_render_voice_mods(SYNTH_DATA* synth_data, SYNTH_VOICE* voice, SYNTH_MOD_SLOT* slots, const PARAM_T* ctrl, PARAM_T voice_freq,
+				    unsigned int* has_pm, unsigned int* has_fm, NFRAMES_T nframes){
+    *has_pm = 0;
+    *has_fm = 0;
+    for(int k = 0; k < SYNTH_MOD_SLOTS; k++){
+	SYNTH_MOD_SLOT* slot = &(slots[k]);
+	if(!slot->mod_osc)continue;
+	PARAM_T amt = ctrl[SYNTH_MOD_PARAM_START + k*3 + 1];
+	if(amt == 0)continue;
+	PARAM_T* mod_buffer = synth_data->pm_buffer;
+	if(slot->type == 1){
+	    mod_buffer = synth_data->fm_buffer;
+	    if(*has_fm == 0)memset(mod_buffer, '\0', sizeof(PARAM_T) * nframes);
+	    *has_fm = 1;
+	}
+	else{
+	    if(*has_pm == 0)memset(mod_buffer, '\0', sizeof(PARAM_T) * nframes);
+	    *has_pm = 1;
+	}
+	SYNTH_ADSR* mod_adsr = voice->mod_adsr[k];
+	synth_adsr_update(mod_adsr, slot->a, slot->d, slot->s, slot->r, synth_data->samplerate);
+	PARAM_T mod_freq = voice_freq * slot->freq_ratio;
+	PARAM_T mod_ph = voice->mod_ph[k];
+	for(int j = 0; j < nframes; j++){
+	    PARAM_T adsr_amp = 1.0;
+	    synth_process_adsr(mod_adsr, voice->playing, &adsr_amp);
+	    mod_buffer[j] += osc_getOutput(slot->table, mod_ph, mod_freq, 0, 0) * adsr_amp * amt;
+	    osc_updatePhase(slot->table, &mod_ph, mod_freq);
+	}
+	voice->mod_ph[k] = mod_ph;
+    }
+}
+
+//read all the oscillator parameters once for this block into the flat ctrl_base array
+//and add the modulation matrix routes that have sources which are the same for all voices (lfos and cc)
+//the routes are written to routes, so the per voice sources can be added in synth_ctrl_voice_update
+static void synth_ctrl_update(SYNTH_DATA* synth_data, SYNTH_OSC* osc, PARAM_T* ctrl_base, SYNTH_MATRIX_ROUTE* routes, NFRAMES_T nframes){
+    for(int i = 0; i < SYNTH_NUM_PARAMS; i++){
+	unsigned int curved = 0;
+	if(synth_param_types[i] == Curve_Float_Return_Type)curved = 1;
+	//the amp is smoothed per sample with param_fill_ramp_rt, here its only the block value for the modulation matrix
+	ctrl_base[i] = param_get_value(osc->params, i, curved, 0, 1);
+    }
+    //the lfo values for this block
+    PARAM_T lfo_vals[SYNTH_LFOS];
+    for(int k = 0; k < SYNTH_LFOS; k++){
+	PARAM_T rate = ctrl_base[SYNTH_LFO_PARAM_START + k];
+	lfo_vals[k] = osc_getOutput(osc->sin_osc, osc->lfo_ph[k], rate, 0, 0);
+	PARAM_T ph = osc->lfo_ph[k] + (rate * (PARAM_T)nframes) / synth_data->samplerate;
+	osc->lfo_ph[k] = ph - floor(ph);
+    }
+    for(int k = 0; k < SYNTH_MATRIX_SLOTS; k++){
+	SYNTH_MATRIX_ROUTE* route = &(routes[k]);
+	int param_start = SYNTH_MATRIX_PARAM_START + k*3;
+	route->dst = -1;
+	route->src = (unsigned int)ctrl_base[param_start];
+	route->amt = ctrl_base[param_start + 2];
+	if(route->src == Matrix_src_off || route->amt == 0)continue;
+	int dst_idx = (int)ctrl_base[param_start + 1];
+	if(dst_idx < 0 || dst_idx >= SYNTH_MATRIX_DESTS)continue;
+	route->dst = synth_matrix_dests[dst_idx];
+	route->amt = route->amt * (synth_param_maxs[route->dst] - synth_param_mins[route->dst]);
+	PARAM_T src_val = 0;
+	if(route->src == Matrix_src_lfo1)src_val = lfo_vals[0];
+	else if(route->src == Matrix_src_lfo2)src_val = lfo_vals[1];
+	else if(route->src == Matrix_src_cc)src_val = osc->cc_val;
+	//the env and vel sources are added per voice
+	else continue;
+	ctrl_base[route->dst] += src_val * route->amt;
+	route->dst = -1;
+    }
+}
+
+//copy the ctrl_base to the voice ctrl array and add the modulation matrix routes that depend on the voice
+//the modulated parameters are clamped to their ranges
+static void synth_ctrl_voice_update(const PARAM_T* ctrl_base, const SYNTH_MATRIX_ROUTE* routes, SYNTH_VOICE* voice,
+				    PARAM_T midi_vel_amp, PARAM_T* ctrl){
+    memcpy(ctrl, ctrl_base, sizeof(PARAM_T) * SYNTH_NUM_PARAMS);
+    for(int k = 0; k < SYNTH_MATRIX_SLOTS; k++){
+	const SYNTH_MATRIX_ROUTE* route = &(routes[k]);
+	if(route->dst < 0)continue;
+	PARAM_T src_val = 0;
+	if(route->src == Matrix_src_env)src_val = voice->vco_adsr->amp;
+	if(route->src == Matrix_src_vel)src_val = midi_vel_amp;
+	ctrl[route->dst] += src_val * route->amt;
+    }
+    for(int k = 0; k < SYNTH_MATRIX_DESTS; k++){
+	int dst = synth_matrix_dests[k];
+	if(ctrl[dst] < synth_param_mins[dst])ctrl[dst] = synth_param_mins[dst];
+	if(ctrl[dst] > synth_param_maxs[dst])ctrl[dst] = synth_param_maxs[dst];
+    }
+}
+
+//calculate the unison sub-voice frequency ratios and stereo gains from the voice ctrl array, returns the number of sub-voices
+static unsigned int synth_unison_update(SYNTH_DATA* synth_data, const PARAM_T* ctrl, PARAM_T* uni_ratios, PARAM_T* uni_gain_L, PARAM_T* uni_gain_R){
+    unsigned int uni_num = (unsigned int)ctrl[SYNTH_UNI_PARAM_START];
+    if(uni_num < 1)uni_num = 1;
+    if(uni_num > MAX_UNISON)uni_num = MAX_UNISON;
+    PARAM_T uni_detune = ctrl[SYNTH_UNI_PARAM_START + 1];
+    PARAM_T uni_width = ctrl[SYNTH_UNI_PARAM_START + 2];
+    //keep the loudness the same no matter how many sub-voices are playing
+    PARAM_T uni_norm = 1.0 / sqrt((PARAM_T)uni_num);
+    for(unsigned int k = 0; k < uni_num; k++){
+	//position of the sub-voice from -1 to 1, a single voice sits in the center
+	PARAM_T pos = 0.0;
+	if(uni_num > 1)pos = ((PARAM_T)k / (PARAM_T)(uni_num - 1)) * 2.0 - 1.0;
+	uni_ratios[k] = math_range_table_convert_value(synth_data->semi_to_freq_table, pos * uni_detune * UNISON_MAX_DETUNE);
+	PARAM_T pan = pos * uni_width;
+	uni_gain_L[k] = uni_norm;
+	uni_gain_R[k] = uni_norm;
+	if(pan > 0)uni_gain_L[k] *= (1 - pan);
+	if(pan < 0)uni_gain_R[k] *= (1 + pan);
+    }
+    return uni_num;
+}
+
 static void synth_process_osc_voices(SYNTH_DATA* synth_data, SYNTH_OSC* osc, NFRAMES_T nframes){
     if(!osc)return;
     if(!osc->osc_voices)return;
@@ -596,17 +1041,18 @@ static void synth_process_osc_voices(SYNTH_DATA* synth_data, SYNTH_OSC* osc, NFR
     memset(osc->buffer_L, '\0', sizeof(SAMPLE_T) * nframes);
     memset(osc->buffer_R, '\0', sizeof(SAMPLE_T) * nframes);
     
-    //interpolate the amp value
-    PARAM_T amp_in = param_get_value(osc->params, 0, 0, 1, 1);
-    PARAM_T freq_in = param_get_value(osc->params, 1, 0, 0, 1);
-    PARAM_T octave_in =  param_get_value(osc->params, 4, 0, 0, 1);
-    PARAM_T wobble = param_get_value(osc->params, 3, 0, 0, 1);
-    PARAM_T spread = param_get_value(osc->params, 2, 0, 0, 1);
-    //get the adsr values from the user parameters
-    PARAM_T vco_a = param_get_value(osc->params, 6, 1, 0, 1);
-    PARAM_T vco_d = param_get_value(osc->params, 7, 1, 0, 1);
-    PARAM_T vco_s = param_get_value(osc->params, 8, 0, 0, 1);
-    PARAM_T vco_r = param_get_value(osc->params, 9, 1, 0, 1);
+    //all the parameters for this block, with the lfo and cc modulation added
+    PARAM_T ctrl_base[SYNTH_NUM_PARAMS];
+    SYNTH_MATRIX_ROUTE routes[SYNTH_MATRIX_SLOTS];
+    //the amp parameter without modulation, the voices add their modulation to the smoothed amp_ramp
+    //a new amp from the [main-thread] starts ramping at the frame it was sent on
+    unsigned int amp_offset = param_get_change_offset_rt(osc->params, 0, app_jack_last_frame_time_rt(synth_data->audio_backend), nframes);
+    PARAM_T amp_param = param_get_value(osc->params, 0, 0, 0, 1);
+    param_fill_ramp_rt(osc->params, 0, 0, synth_data->amp_ramp, nframes, amp_offset);
+    synth_ctrl_update(synth_data, osc, ctrl_base, routes, nframes);
+    //the fm/pm modulators for this block
+    SYNTH_MOD_SLOT mod_slots[SYNTH_MOD_SLOTS];
+    unsigned int mods_used = synth_mod_slots_update(synth_data, osc, mod_slots);
 
     for(int i = 0; i < osc->num_voices; i++){
 	SYNTH_VOICE* cur_voice = &(osc->osc_voices[i]);
@@ -615,11 +1061,28 @@ static void synth_process_osc_voices(SYNTH_DATA* synth_data, SYNTH_OSC* osc, NFR
 	
 	if(cur_voice->stopped == 1){
 	    synth_adsr_reset(cur_voice->vco_adsr);
+	    for(int k = 0; k < SYNTH_MOD_SLOTS; k++)synth_adsr_reset(cur_voice->mod_adsr[k]);
 	    continue;
 	}
 	OSC_OBJ* osc_table = cur_voice->osc_table;
+	//linear midi vel to amp
+	PARAM_T midi_amp = fit_range(127.0, 0.0, 1.0, 0.0, cur_voice->midi_vel);
+	//the parameters for this voice with the voice modulation sources added, the render loop only reads from this array
+	PARAM_T ctrl[SYNTH_NUM_PARAMS];
+	synth_ctrl_voice_update(ctrl_base, routes, cur_voice, midi_amp, ctrl);
+	//how much the modulation matrix moves the amp for this voice
+	PARAM_T amp_mod = ctrl[0] - amp_param;
+	PARAM_T freq_in = ctrl[1];
+	PARAM_T spread = ctrl[2];
+	PARAM_T wobble = ctrl[3];
+	PARAM_T octave_in = ctrl[4];
 	//update the adsr values on the voice with the user values
-	synth_adsr_update(cur_voice->vco_adsr, vco_a, vco_d, vco_s, vco_r, synth_data->samplerate);
+	synth_adsr_update(cur_voice->vco_adsr, ctrl[6], ctrl[7], ctrl[8], ctrl[9], synth_data->samplerate);
+	//unison sub-voice frequency ratios and stereo gains
+	PARAM_T uni_ratios[MAX_UNISON];
+	PARAM_T uni_gain_L[MAX_UNISON];
+	PARAM_T uni_gain_R[MAX_UNISON];
+	unsigned int uni_num = synth_unison_update(synth_data, ctrl, uni_ratios, uni_gain_L, uni_gain_R);
 	
 	//this voices random value
 	srand((i + 1) * cur_voice->rand_seed);
@@ -638,16 +1101,22 @@ static void synth_process_osc_voices(SYNTH_DATA* synth_data, SYNTH_OSC* osc, NFR
 	}
 	    
 	PARAM_T freq = midi_note_to_freq(cur_voice->midi_note);	
-	//linear midi vel to amp
-	PARAM_T midi_amp = fit_range(127.0, 0.0, 1.0, 0.0, cur_voice->midi_vel);
 	//midi vel to amp with a curve
 	midi_amp = math_range_table_convert_value(synth_data->log_curve, midi_amp);
+	//render the modulators for the whole block first
+	unsigned int has_pm = 0;
+	unsigned int has_fm = 0;
+	if(mods_used > 0)synth_render_voice_mods(synth_data, cur_voice, mod_slots, ctrl, freq, &has_pm, &has_fm, nframes);
+	
+	//add the octaves and semitones, these are control rate so its done once per block
+	PARAM_T freq_base = freq * math_range_table_convert_value(synth_data->semi_to_freq_table, octave_in * 12 + freq_in);
 	
 	//process the wavetable, get buffer
 	for(int j = 0; j < nframes; j++){     
-	    //add the octaves and semitones
-	    PARAM_T octaves_semitones = octave_in * 12;
-	    PARAM_T freq_final = freq * math_range_table_convert_value(synth_data->semi_to_freq_table, octaves_semitones + freq_in);
+	    PARAM_T freq_final = freq_base;
+	    PARAM_T amp_in = synth_data->amp_ramp[j] + amp_mod;
+	    if(amp_in < synth_param_mins[0])amp_in = synth_param_mins[0];
+	    if(amp_in > synth_param_maxs[0])amp_in = synth_param_maxs[0];
 	    //process the adsr
 	    PARAM_T adsr_amp = 1.0;
 	    int adsr_phase = synth_process_adsr(cur_voice->vco_adsr, cur_voice->playing, &adsr_amp);
@@ -667,9 +1136,26 @@ static void synth_process_osc_voices(SYNTH_DATA* synth_data, SYNTH_OSC* osc, NFR
 		osc_updatePhase(osc->sin_osc, &(cur_voice->wobble_ph), wobble_freq);
 	    }
 
-	    PARAM_T wave_sample_L = osc_getOutput(osc_table, cur_voice->vco_ph, freq_final, 0, 0);
-	    PARAM_T wave_sample_R = wave_sample_L;
-	    osc_updatePhase(osc_table, &(cur_voice->vco_ph), freq_final);
+	    //fm changes the frequency, the frequency can not go below 0
+	    if(has_fm == 1){
+		freq_final = freq_final * (1 + synth_data->fm_buffer[j]);
+		if(freq_final < 0)freq_final = 0;
+	    }
+	    //pm offsets the phase that is read from the table, but does not change the voice phase
+	    PARAM_T read_ofs = 0;
+	    if(has_pm == 1)read_ofs = synth_data->pm_buffer[j];
+
+	    //read all the unison sub-voices at once, they share the envelope and the frequency calculations above
+	    PARAM_T uni_freqs[MAX_UNISON];
+	    PARAM_T uni_samples[MAX_UNISON];
+	    for(unsigned int k = 0; k < uni_num; k++)uni_freqs[k] = freq_final * uni_ratios[k];
+	    osc_getOutput_stack(osc_table, cur_voice->vco_ph, uni_freqs, uni_num, read_ofs, uni_samples);
+	    PARAM_T wave_sample_L = 0;
+	    PARAM_T wave_sample_R = 0;
+	    for(unsigned int k = 0; k < uni_num; k++){
+		wave_sample_L += uni_samples[k] * uni_gain_L[k];
+		wave_sample_R += uni_samples[k] * uni_gain_R[k];
+	    }
 
 	    PARAM_T interp_amp_in_L = params_interp_val_get_value(cur_voice->vco_amp_L, amp_in * adsr_amp * spread_mult_L * midi_amp);
 	    PARAM_T interp_amp_in_R = params_interp_val_get_value(cur_voice->vco_amp_R, amp_in * adsr_amp * spread_mult_R * midi_amp);	    
@@ -710,6 +1196,8 @@ static void synth_process_osc_voices(SYNTH_DATA* synth_data, SYNTH_OSC* osc, NFR
     memset(out_L, '\0', sizeof(SAMPLE_T) * nframes);
     memset(out_R, '\0', sizeof(SAMPLE_T) * nframes);
 
+    context_sub_count_subnormals_rt(synth_data->control_data, osc->buffer_L, nframes);
+    context_sub_count_subnormals_rt(synth_data->control_data, osc->buffer_R, nframes);
     memcpy(out_L, osc->buffer_L, sizeof(SAMPLE_T) * nframes);
     memcpy(out_R, osc->buffer_R, sizeof(SAMPLE_T) * nframes);
 }
@@ -731,7 +1219,9 @@ static void synth_play_osc_rt(SYNTH_OSC* osc, MIDI_DATA_T vel, MIDI_DATA_T note,
 	    to_play_voice = cur_voice;
 	    //calc a random phase for this voice, so each voice does not start on the same phase
 	    srand((unsigned int)(vel * (to_play_voice->id+1)*45999));
-	    to_play_voice->vco_ph = fit_range((PARAM_T)RAND_MAX, 0.0, 1.0, 0.0, (PARAM_T)rand());
+	    for(int k = 0; k < MAX_UNISON; k++){
+		to_play_voice->vco_ph[k] = fit_range((PARAM_T)RAND_MAX, 0.0, 1.0, 0.0, (PARAM_T)rand());
+	    }
 	    found_voice = 1;
 	    break;
 	}
@@ -761,15 +1251,14 @@ static void synth_play_osc_rt(SYNTH_OSC* osc, MIDI_DATA_T vel, MIDI_DATA_T note,
 	to_play_voice->midi_note = note;
 	to_play_voice->midi_vel = vel;
 	osc->last_voice = to_play_voice->id;
+	for(int k = 0; k < SYNTH_MOD_SLOTS; k++){
+	    to_play_voice->mod_ph[k] = 0;
+	    synth_adsr_reset(to_play_voice->mod_adsr[k]);
+	}
 	
 	//set which table to play for the voice
 	//its set before playing the voice so the table does not change while the sound is playing
-	to_play_voice->osc_table = osc->sin_osc;
-	PARAM_T table  = param_get_value(osc->params, 5, 0, 0, 1);
-	if(table == SIN_WAVETABLE)to_play_voice->osc_table = osc->sin_osc;	
-	if(table == TRIANGLE_WAVETABLE)to_play_voice->osc_table = osc->triang_osc;
-	if(table == SAW_WAVETABLE)to_play_voice->osc_table = osc->saw_osc;
-	if(table == SQUARE_WAVETABLE)to_play_voice->osc_table = osc->sqr_osc;
+	to_play_voice->osc_table = synth_table_from_param(osc, param_get_value(osc->params, 5, 0, 0, 1));
     }
 }
 //stop a voice of the osc, that matches the note given
@@ -792,28 +1281,63 @@ static void synth_stop_osc_rt(SYNTH_OSC* osc, MIDI_DATA_T vel, MIDI_DATA_T note,
     }
 }
 
-static int synth_metronome_process_rt(SYNTH_DATA* synth_data, SYNTH_OSC* metro_osc, NFRAMES_T nframes, int32_t beat, int playhead){
-    if(!metro_osc)return -1;
-    if(playhead == 0){
-	synth_stop_osc_rt(metro_osc, 127, 0, 1);
+//copy the rest of the playing click to the outputs from the start frame up to the end frame
+static void synth_metronome_copy_click(SYNTH_DATA* synth_data, SAMPLE_T* out_L, SAMPLE_T* out_R, NFRAMES_T start, NFRAMES_T end){
+    if(!synth_data->mtr_click)return;
+    if(start >= end)return;
+    NFRAMES_T len = synth_data->mtr_click_len - synth_data->mtr_click_pos;
+    if(len > end - start)len = end - start;
+    memcpy(&(out_L[start]), &(synth_data->mtr_click[synth_data->mtr_click_pos]), sizeof(SAMPLE_T) * len);
+    memcpy(&(out_R[start]), &(synth_data->mtr_click[synth_data->mtr_click_pos]), sizeof(SAMPLE_T) * len);
+    synth_data->mtr_click_pos += len;
+    if(synth_data->mtr_click_pos >= synth_data->mtr_click_len){
+	synth_data->mtr_click = NULL;
+	synth_data->mtr_click_pos = 0;
     }
-    if(playhead == 1){
-	//calculate if we need to trigger the metronome oscillator
-	unsigned int play_osc = 0;
-	if(metro_osc->trig != beat){
-	    metro_osc->trig = beat;
-	    play_osc = 1;
-	}
+}
 
-	if(play_osc == 1){
-	    MIDI_DATA_T pitch = 60;
-	    if(beat == 1)pitch = 72;
-	    synth_play_osc_rt(metro_osc, 127, pitch, beat);
-	}
+//find the frame of the beat in this cycle from the transport position and copy the click there
+static int synth_metronome_process_rt(SYNTH_DATA* synth_data, NFRAMES_T nframes){
+    if(!synth_data->mtr_ports)return -1;
+    SAMPLE_T* out_L = app_jack_get_buffer_rt(synth_data->mtr_ports[0].sys_port, nframes);
+    SAMPLE_T* out_R = app_jack_get_buffer_rt(synth_data->mtr_ports[1].sys_port, nframes);
+    if(!out_L || !out_R)return -1;
+    memset(out_L, '\0', sizeof(SAMPLE_T) * nframes);
+    memset(out_R, '\0', sizeof(SAMPLE_T) * nframes);
+    
+    const JACK_TRANSPORT_SNAP* transport = app_jack_return_transport_snap_rt(synth_data->audio_backend);
+    //when the transport stops, stop the click too, so it starts again from the first beat
+    if(!transport || transport->playing != 1 || transport->bbt_valid != 1 || transport->bpm <= 0 || transport->ticks_per_beat <= 0){
+	synth_data->mtr_click = NULL;
+	synth_data->mtr_click_pos = 0;
+	synth_data->mtr_last_bar = -1;
+	synth_data->mtr_last_beat = -1;
+	return 0;
+    }
+    //the snapshot has the beats that start in this cycle, the click is short so only the first one is clicked
+    int beat_frame = -1;
+    int32_t click_bar = transport->bar;
+    int32_t click_beat = transport->beat;
+    if(transport->num_beats > 0){
+	beat_frame = (int)transport->beats[0].frame;
+	click_bar = transport->beats[0].bar;
+	click_beat = transport->beats[0].beat;
     }
+    //dont click the same beat twice, the tick can be 0 for a couple of cycles with small buffers
+    if(beat_frame >= 0 && click_bar == synth_data->mtr_last_bar && click_beat == synth_data->mtr_last_beat)beat_frame = -1;
 
-    //now process the voices of this oscilator
-    synth_process_osc_voices(synth_data, metro_osc, nframes);  
+    NFRAMES_T end = nframes;
+    if(beat_frame >= 0)end = (NFRAMES_T)beat_frame;
+    //the rest of the click from the last cycles
+    synth_metronome_copy_click(synth_data, out_L, out_R, 0, end);
+    if(beat_frame < 0)return 0;
+    
+    synth_data->mtr_last_bar = click_bar;
+    synth_data->mtr_last_beat = click_beat;
+    synth_data->mtr_click = synth_data->mtr_click_normal;
+    if(click_beat == 1)synth_data->mtr_click = synth_data->mtr_click_accent;
+    synth_data->mtr_click_pos = 0;
+    synth_metronome_copy_click(synth_data, out_L, out_R, (NFRAMES_T)beat_frame, nframes);
     
     return 0;
 }
@@ -826,43 +1350,37 @@ int synth_process_rt(SYNTH_DATA* synth_data, NFRAMES_T nframes){
 
     //if there is a metronome process it
     if(synth_data->with_metronome == 1){
-	int32_t bar = 1;
-	int32_t beat = 1;
-	int32_t tick = 0;
-	SAMPLE_T ticks_per_beat = 0;
-	NFRAMES_T total_frames = 0;
-	float bpm = 0;
-	float beat_type = 0;
-	float beats_per_bar = 0;
-	int isPlaying = app_jack_return_transport_rt(synth_data->audio_backend, &bar, &beat, &tick, &ticks_per_beat, &total_frames,
-						     &bpm, &beat_type, &beats_per_bar);
-	if(isPlaying != -1){
-	    SYNTH_OSC* cur_osc = &(synth_data->osc_array[0]);
-	    if(!cur_osc)return -1;
-	    synth_metronome_process_rt(synth_data, cur_osc, nframes, beat, isPlaying);
-	}
+	synth_metronome_process_rt(synth_data, nframes);
     }
 
-    //here we process all the oscillators except the metronome, if there is a metronome
-    int i = 0;
-    if(synth_data->with_metronome == 1) i = 1;
-    for(i; i < synth_data->num_osc; i++){
-	if(i >= synth_data->num_osc) continue;
+    //here we process all the oscillators
+    for(int i = 0; i < synth_data->num_osc; i++){
 	SYNTH_OSC* cur_osc = &(synth_data->osc_array[i]);
-	//get the notes to the midi container
-	app_jack_midi_cont_reset(synth_data->midi_cont);
+	//empty or stopped oscillators cost nothing
+	if(cur_osc->processing == 0)continue;
+	//get the notes of this oscillator, decoded already for this cycle on the midi bus
 	SYNTH_PORT* midi_port = &(cur_osc->ports[0]);
-	void* midi_buffer = app_jack_get_buffer_rt(midi_port->sys_port, nframes);
-	app_jack_return_notes_vels_rt(midi_buffer, synth_data->midi_cont);
+	const JACK_MIDI_CONT* midi_cont = app_jack_midi_bus_return_rt(synth_data->audio_backend, midi_port->sys_port);
+	unsigned int num_events = 0;
+	if(midi_cont)num_events = midi_cont->num_events;
+	//the last value of the Mod_CC control change in this cycle is the cc source for the modulation matrix
+	int mod_cc = (int)param_get_value(cur_osc->params, SYNTH_CC_PARAM, 0, 0, 1);
+	for(int ev = 0; ev < num_events; ev++){
+	    const JACK_MIDI_EVENT* event = &(midi_cont->events[ev]);
+	    if((event->status & 0xf0) != 0xb0)continue;
+	    if(event->data[0] != mod_cc)continue;
+	    cur_osc->cc_val = (PARAM_T)event->data[1] / 127.0;
+	}
 	for(int cur_frame = 0; cur_frame < nframes; cur_frame++){
 	    MIDI_DATA_T this_vel = 0;
 	    MIDI_DATA_T this_type = 0;
 	    MIDI_DATA_T this_pitch = 0;	    
-	    for(int i = 0; i < synth_data->midi_cont->num_events; i++){
-		if(synth_data->midi_cont->nframe_nums[i] != cur_frame)continue;
-		this_vel = synth_data->midi_cont->vel_trig[i];
-		this_type = synth_data->midi_cont->types[i];
-		this_pitch = synth_data->midi_cont->note_pitches[i];
+	    for(int i = 0; i < num_events; i++){
+		const JACK_MIDI_EVENT* event = &(midi_cont->events[i]);
+		if(event->frame != cur_frame)continue;
+		this_vel = event->data[1];
+		this_type = event->status;
+		this_pitch = event->data[0];
 	    }
 	    //note on event
 	    if((this_type & 0xf0) == 0x90){
@@ -897,7 +1415,8 @@ const char* synth_return_osc_name(SYNTH_DATA* synth_data, unsigned int osc_num){
     if(!synth_data)return NULL;
     if(osc_num >= synth_data->num_osc)return NULL;
     SYNTH_OSC* cur_osc = &(synth_data->osc_array[osc_num]);
-    if(!cur_osc)return NULL;
+    //empty oscillator slots dont have names
+    if(!cur_osc->params)return NULL;
     return cur_osc->name;
 }
 
@@ -918,10 +1437,15 @@ static int synth_clean_ports(SYNTH_DATA* synth_data, SYNTH_PORT** osc_ports, uns
 	}
     }
     free(*osc_ports);
+    *osc_ports = NULL;
+    return 0;
 }
 
 static int synth_clean_osc(SYNTH_DATA* synth_data, SYNTH_OSC* synth_osc){
     if(!synth_osc)return -1;
+    //the oscillator is cleaned now, a removal that is still submitted should not clean it again
+    synth_osc->remove_pending = 0;
+    synth_osc->generation += 1;
     if(synth_osc->params)param_clean_param_container(synth_osc->params);
     synth_osc->params = NULL;
     if(synth_osc->osc_voices){
@@ -931,6 +1455,9 @@ static int synth_clean_osc(SYNTH_DATA* synth_data, SYNTH_OSC* synth_osc){
 		if(cur_voice->vco_amp_L)free(cur_voice->vco_amp_L);
 		if(cur_voice->vco_amp_R)free(cur_voice->vco_amp_R);
 		if(cur_voice->vco_adsr)free(cur_voice->vco_adsr);
+		for(int k = 0; k < SYNTH_MOD_SLOTS; k++){
+		    if(cur_voice->mod_adsr[k])free(cur_voice->mod_adsr[k]);
+		}
 	    }
 	}
 	free(synth_osc->osc_voices);
@@ -942,16 +1469,16 @@ static int synth_clean_osc(SYNTH_DATA* synth_data, SYNTH_OSC* synth_osc){
     synth_osc->buffer_R = NULL;
     if(synth_osc->ports)synth_clean_ports(synth_data, &(synth_osc->ports), synth_osc->num_ports);
     synth_osc->ports = NULL;
+    synth_osc->num_ports = 0;
     if(synth_osc->name)free(synth_osc->name);
     synth_osc->name = NULL;
+    synth_osc->num_voices = 0;
+    synth_osc->processing = 0;
+    return 0;
 }
 
 int synth_clean_memory(SYNTH_DATA* synth_data){
     if(!synth_data)return -1;
-    if(synth_data->midi_cont){
-	app_jack_clean_midi_cont(synth_data->midi_cont);
-	free(synth_data->midi_cont);
-    }
     if(synth_data->osc_array){
 	for(int i = 0; i < synth_data->num_osc; i++){
 	    synth_clean_osc(synth_data, &(synth_data->osc_array[i]));
@@ -965,6 +1492,14 @@ int synth_clean_memory(SYNTH_DATA* synth_data){
     if(synth_data->semi_to_freq_table)math_range_table_clean(synth_data->semi_to_freq_table);
     if(synth_data->log_curve)math_range_table_clean(synth_data->log_curve);
     if(synth_data->amp_to_exp)math_range_table_clean(synth_data->amp_to_exp);
+    if(synth_data->pm_buffer)free(synth_data->pm_buffer);
+    if(synth_data->fm_buffer)free(synth_data->fm_buffer);
+    if(synth_data->amp_ramp)free(synth_data->amp_ramp);
+    if(synth_data->mtr_ports)synth_clean_ports(synth_data, &(synth_data->mtr_ports), synth_data->mtr_num_ports);
+    if(synth_data->mtr_click_accent)free(synth_data->mtr_click_accent);
+    if(synth_data->mtr_click_normal)free(synth_data->mtr_click_normal);
+    if(synth_data->cx_name)free(synth_data->cx_name);
+    if(synth_data->param_rings)param_clean_param_rings(synth_data->param_rings);
 
     context_sub_clean(synth_data->control_data);
     
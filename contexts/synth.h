@@ -14,10 +14,21 @@ int synth_read_rt_to_ui_messages(SYNTH_DATA* synth_data);
 //initiate the synth data
 SYNTH_DATA* synth_init (unsigned int buffer_size, SAMPLE_T sample_rate, const char* cx_name, unsigned int with_metronome,
 			void* audio_backend);
+//add a new oscillator in the osc_id slot, if osc_id == -1 the first empty slot will be used
+//allocates the oscillator buffers, voices, parameters and registers its ports, then waits for the [audio-thread] to start processing it
+//returns the id of the oscillator, should be called only on [main-thread]
+int synth_add_osc(SYNTH_DATA* synth_data, int osc_id);
+//stop processing the oscillator and free its buffers and ports, should be called only on [main-thread]
+int synth_stop_and_remove_osc(SYNTH_DATA* synth_data, int osc_id);
+//stop the oscillators with ids without blocking the [main-thread], the [audio-thread] stops them all in the same cycle
+//each oscillator is freed on [main-thread] in synth_read_rt_to_ui_messages after the [audio-thread] stopped it
+int synth_stop_and_remove_oscs(SYNTH_DATA* synth_data, const int* ids, unsigned int num_ids);
 //process the synth_data oscillators
 int synth_process_rt(SYNTH_DATA* synth_data, NFRAMES_T nframes);
 //functions for param manipulation, should be called only on [main-thread]
 PRM_CONTAIN* synth_param_return_param_container(SYNTH_DATA* synth_data, int osc_id);
+//return the oscillator parameter container or NULL if the oscillator is not processing, use on [audio-thread]
+PRM_CONTAIN* synth_param_return_param_container_rt(SYNTH_DATA* synth_data, int osc_id);
 
 //activate the audio ports
 int synth_activate_backend_ports(SYNTH_DATA* synth_data, SYNTH_OSC* osc);
@@ -25,7 +36,7 @@ int synth_activate_backend_ports(SYNTH_DATA* synth_data, SYNTH_OSC* osc);
 PRM_CONTAIN* synth_return_param_container(SYNTH_DATA* synth_data, unsigned int osc_num);
 //return the name of the osc_num oscillators
 const char* synth_return_osc_name(SYNTH_DATA* synth_data, unsigned int osc_num);
-//return how many oscillators there are
+//return how many oscillator slots there are, empty slots return NULL for their name and param container
 int synth_return_osc_num(SYNTH_DATA* synth_data);
 //clean the ports
 static int synth_clean_ports(SYNTH_DATA* synth_data, SYNTH_PORT** osc_ports, unsigned int num_ports);
@@ -9,11 +9,43 @@
 #include "jack_funcs.h"
 #include "../types.h"
 #include "../util_funcs/log_funcs.h"
+#include "../util_funcs/math_funcs.h"
 #include "../contexts/context_control.h"
 //the maximum number of bars there can be
 #define MAX_BARS 1000
 
 static thread_local bool is_audio_thread = false;
+//add a midi input port to the midi bus of the client, called from app_jack_create_port_on_client
+static int app_jack_midi_bus_add(JACK_INFO* jack_data, jack_port_t* port);
+
+//a midi input port on the midi bus, its events are decoded once per cycle for all the contexts that read the port
+typedef struct _jack_midi_bus_port{
+    //the registered port, NULL if the slot is free. Written only on [main-thread]
+    _Atomic(jack_port_t*) port;
+    //the port the events in midi_cont are from in this cycle, touch only on [audio-thread]
+    jack_port_t* decoded_port;
+    //the decoded events, allocated when the slot is first used and kept until the jack_data is cleaned
+    JACK_MIDI_CONT* midi_cont;
+}JACK_MIDI_BUS_PORT;
+//a port that is removed from the midi bus, unregistered when the [audio-thread] can not decode it anymore
+typedef struct _jack_port_unreg{
+    struct _jack_info* jack_data;
+    jack_port_t* port;
+}JACK_PORT_UNREG;
+
+//the musical clock of the timebase, maps the transport frame to ticks with integers so it does not drift
+//ticks since frame 0 = frame * tick_num / tick_den
+typedef struct _jack_clock{
+    //the tempo in thousandths of a beat per minute
+    uint64_t bpm_milli;
+    uint32_t beats_per_bar;
+    float beat_type;
+    //the sample rate the ratio was made for
+    uint32_t frame_rate;
+    //the reduced ratio of ticks per frame, tick_den is 0 if the clock is not set yet
+    uint64_t tick_num;
+    uint64_t tick_den;
+}JACK_CLOCK;
 
 //jack main struct
 typedef struct _jack_info{
@@ -22,18 +54,34 @@ typedef struct _jack_info{
     int port_size;
     //the jack client 
     jack_client_t *client;
-    //the current server sample_rate
-    jack_nframes_t sample_rate;
+    //the current server sample_rate, written from the jack sample rate callback and read in the timebase on [audio-thread]
+    atomic_uint sample_rate;
     //the current server buffer size
     jack_nframes_t buffer_size;
     //parameters for the general song track settings, like current bar, beat
     //also play, stop etc.
     PRM_CONTAIN* trk_params;
+    //the rings for the trk_params messages
+    PRM_RINGS* param_rings;
     //rt tick var, that goes from 0 to RT_CYCLES, rt thread will send info to ui thread only when rt tick var is 0
     //should only be touched on [audio-thread]
     int rt_tick;
     //control_data for sys messages, for jack currently only uses the [thread-safe] messaging system, since this does not have any subcontexts
     CXCONTROL* control_data;
+    //the transport position of this cycle, touch only on [audio-thread]
+    JACK_TRANSPORT_SNAP transport;
+    //the clock of the timebase callback, touch only on [audio-thread]
+    JACK_CLOCK clock;
+    //the bar and beat of the last beat put in the transport snapshot, so a beat estimated from the ticks is not put there twice
+    //0 when the transport is not rolling, touch only on [audio-thread]
+    int32_t est_bar;
+    int32_t est_beat;
+    //the midi input ports of the client, decoded in app_jack_midi_bus_process_rt
+    JACK_MIDI_BUS_PORT midi_bus[MAX_MIDI_BUS_PORTS];
+    //how many slots of the midi_bus were ever used, the [audio-thread] only goes through these
+    atomic_uint midi_bus_size;
+    //counts the removed midi bus ports, so each gets its own name until it is unregistered, touch only on [main-thread]
+    unsigned int removed_ports;
 }JACK_INFO;
 //ticks per beat, since user should not set these anyway
 double time_ticks_per_beat = 1920.0;
@@ -44,6 +92,12 @@ static int app_jack_sys_send_msg(void* user_data, const char* msg){
     return 0;
 }
 
+//called by jack on the [audio-thread] before it starts processing
+static void app_jack_thread_init(void* arg){
+    //subnormal floats from decaying tails (adsr releases, param interpolation, plugin reverbs) are very slow on x86
+    math_denormals_off();
+}
+
 JACK_INFO* jack_initialize(void *arg, const char *client_name,
 			   int ports_num, unsigned int* ports_types, unsigned int *io_types,
 			   const char** ports_names,
@@ -55,6 +109,21 @@ JACK_INFO* jack_initialize(void *arg, const char *client_name,
     }
     jack_data->rt_tick = 0;
     jack_data->control_data = NULL;
+    jack_data->param_rings = NULL;
+    jack_data->client = NULL;
+    jack_data->ports = NULL;
+    for(int i = 0; i < MAX_MIDI_BUS_PORTS; i++){
+	atomic_init(&jack_data->midi_bus[i].port, NULL);
+	jack_data->midi_bus[i].decoded_port = NULL;
+	jack_data->midi_bus[i].midi_cont = NULL;
+    }
+    atomic_init(&jack_data->midi_bus_size, 0);
+    jack_data->removed_ports = 0;
+    memset(&jack_data->transport, '\0', sizeof(JACK_TRANSPORT_SNAP));
+    memset(&jack_data->clock, '\0', sizeof(JACK_CLOCK));
+    jack_data->est_bar = 0;
+    jack_data->est_beat = 0;
+    atomic_init(&jack_data->sample_rate, 0);
 
     CXCONTROL_RT_FUNCS rt_funcs_struct = {0};
     CXCONTROL_UI_FUNCS ui_funcs_struct = {0};
@@ -69,13 +138,19 @@ JACK_INFO* jack_initialize(void *arg, const char *client_name,
     jack_options_t options = JackNullOption;
     jack_status_t status = 0;
 
+    //the trk_params messages are stamped with the clock of this client, 0 until the client is open
+    jack_data->param_rings = params_init_param_rings(app_jack_frame_time, (void*)jack_data);
+    if(!jack_data->param_rings){
+	jack_clean_memory(jack_data);
+	return NULL;
+    }
     //initialize the general song trk parameters like current bar, beat, play etc.
     jack_data->trk_params = params_init_param_container(7, (char*[7]){"Tempo", "Bar", "Beat", "Tick", "Play", "BPB", "Beat_Type"},
 							(PARAM_T[7]){100, 1, 1, 0, 0, 4, 4},
 							(PARAM_T[7]){10, 1, 1, 0, 0, 2, 2}, (PARAM_T[7]){500, MAX_BARS, 16, 2000, 1, 16, 16},
 							(PARAM_T[7]){1, 1, 1, floor(time_ticks_per_beat/4), 1, 1, 1},
 							(unsigned char[7]){Int_type, Int_type, Int_type, Int_type, Int_type, Int_type, Int_type},
-							NULL, NULL);
+							NULL, NULL, jack_data->param_rings);
     if(!jack_data->trk_params){
 	jack_clean_memory(jack_data);
 	return NULL;
@@ -97,6 +172,8 @@ JACK_INFO* jack_initialize(void *arg, const char *client_name,
     }
     //what the process function is
     jack_set_process_callback(jack_data->client, process, arg);
+    //set the floating point flags on the process thread
+    jack_set_thread_init_callback(jack_data->client, app_jack_thread_init, jack_data);
     
     //call this function when the engine sample rate changes
     jack_set_sample_rate_callback(jack_data->client, sample_rate_change, jack_data);
@@ -106,7 +183,7 @@ JACK_INFO* jack_initialize(void *arg, const char *client_name,
     
     /*write some jack client attributes to the jack_data struct*/
     //sample rate of the server
-    jack_data->sample_rate = jack_get_sample_rate(jack_data->client);
+    atomic_store(&jack_data->sample_rate, jack_get_sample_rate(jack_data->client));
     jack_data->buffer_size = jack_get_buffer_size(jack_data->client);
     
     
@@ -125,40 +202,194 @@ int app_jack_read_ui_to_rt_messages(JACK_INFO* jack_data){
     context_sub_process_rt(jack_data->control_data);
     
     //read the param ui_to_rt messages and set the parameter values
-    param_msgs_process(jack_data->trk_params, 1);
+    param_msgs_process(jack_data->param_rings, 1);
 
     //if rt params just got new parameter values from the ui they will be just changed
     //in that case jack will create a new transport object and request a transport change
     app_jack_update_transport_from_params_rt(jack_data);
-    //now update the bar, beat, tick and is playing parameters from the jack transport for [audio-thread] and [main-thread]
-    //update the params on [audio-thread] in rt_tick (as slow as ui [main-thread] params) since the params will only be used to set anything if the user changes some of them on the [main-thread]
-    //all other contexts gets the real time beats, ticks and other transport vars from the jack_transport_query function in the app_jack_return_transport_rt function
-    if(jack_data->rt_tick == 0){
-	jack_position_t pos;
-	jack_transport_state_t state = jack_transport_query(jack_data->client, &pos);
-	unsigned int pos_ready = 1;
-	if(!pos.valid)pos_ready = 0;
-	if(pos.valid != JackPositionBBT)pos_ready = 0;
-	if(pos_ready == 1){
-	    if(state == JackTransportRolling){
-		//After setting the value, get the value so the parameter is_changed will be 0 and app_jack_update_transport_from_params_rt will not create a new tranport object
-		//even though a parameter was not changed by the ui
-		//get the bars
-		param_set_value(jack_data->trk_params, 1, (float)pos.bar, NULL, Operation_SetValue, 1);
-	        param_get_value(jack_data->trk_params, 1, 0, 0, 1);
-		//get the beat
-		param_set_value(jack_data->trk_params, 2, (float)pos.beat, NULL, Operation_SetValue, 1);
-		param_get_value(jack_data->trk_params, 2, 0, 0, 1);
-		//get the tick
-		param_set_value(jack_data->trk_params, 3, (float)pos.tick, NULL, Operation_SetValue, 1);
-		param_get_value(jack_data->trk_params, 3, 0, 0, 1);
-	    }
-	    //get the isPlaying state even if the Jack transport head is not rolling
-	    param_set_value(jack_data->trk_params, 4, (float)state, NULL, Operation_SetValue, 1);
-	    param_get_value(jack_data->trk_params, 4, 0, 0, 1);
+    return 0;
+}
+
+static uint64_t app_jack_clock_gcd(uint64_t a, uint64_t b){
+    while(b != 0){
+	uint64_t t = a % b;
+	a = b;
+	b = t;
+    }
+    return a;
+}
+
+//set the clock tempo, meter and sample rate and make the ticks per frame ratio
+//the bars are counted in whole beats, so a meter that is not a whole number of beats (for example 7.5) is not used,
+//the clock keeps its last meter instead (or the whole beats of the new one if it has none yet) and this returns -1
+static int app_jack_clock_set(JACK_CLOCK* clock, double bpm, double beats_per_bar, float beat_type, uint32_t frame_rate){
+    int ret = 0;
+    //clamp the tempo so frame * tick_num fits in 64 bits
+    if(bpm < 1)bpm = 1;
+    if(bpm > 1000)bpm = 1000;
+    if(beats_per_bar < 1)beats_per_bar = 1;
+    if(frame_rate == 0)frame_rate = 1;
+    clock->bpm_milli = (uint64_t)llround(bpm * 1000.0);
+    if(beats_per_bar != floor(beats_per_bar)){
+	ret = -1;
+	if(clock->beats_per_bar == 0)clock->beats_per_bar = (uint32_t)floor(beats_per_bar);
+    }
+    else{
+	clock->beats_per_bar = (uint32_t)beats_per_bar;
+    }
+    clock->beat_type = beat_type;
+    clock->frame_rate = frame_rate;
+    //ticks per frame = bpm * ticks_per_beat / (frame_rate * 60)
+    uint64_t num = clock->bpm_milli * (uint64_t)time_ticks_per_beat;
+    uint64_t den = (uint64_t)frame_rate * 60000;
+    uint64_t gcd = app_jack_clock_gcd(num, den);
+    clock->tick_num = num / gcd;
+    clock->tick_den = den / gcd;
+    return ret;
+}
+
+//ticks since frame 0 at the frame, the frame is below 2^32 and tick_num below 2^31 so this does not overflow
+static uint64_t app_jack_clock_ticks(const JACK_CLOCK* clock, jack_nframes_t frame){
+    return ((uint64_t)frame * clock->tick_num) / clock->tick_den;
+}
+
+//the first frame at or after the ticks
+static uint64_t app_jack_clock_frame(const JACK_CLOCK* clock, uint64_t ticks){
+    return (ticks * clock->tick_den + clock->tick_num - 1) / clock->tick_num;
+}
+
+//advance the bar and beat by one beat
+static void app_jack_next_beat(int32_t* bar, int32_t* beat, float beats_per_bar){
+    *beat += 1;
+    if(*beat > (int32_t)beats_per_bar){
+	*beat = 1;
+	*bar += 1;
+    }
+}
+
+//put the beats that start in this cycle in the transport snapshot
+static void app_jack_transport_beats_rt(JACK_INFO* jack_data, const jack_position_t* pos, NFRAMES_T nframes){
+    JACK_TRANSPORT_SNAP* snap = &(jack_data->transport);
+    int32_t bar = pos->bar;
+    int32_t beat = pos->beat;
+    //the beat grid from frame 0 with the tempo of the position, the same clock timebbt_callback_rt counts with
+    uint32_t frame_rate = atomic_load_explicit(&jack_data->sample_rate, memory_order_acquire);
+    if(frame_rate == 0)frame_rate = pos->frame_rate;
+    JACK_CLOCK clock = {0};
+    app_jack_clock_set(&clock, pos->beats_per_minute, pos->beats_per_bar, pos->beat_type, frame_rate);
+    uint64_t ticks_per_beat = (uint64_t)time_ticks_per_beat;
+    uint64_t abs_beat = app_jack_clock_ticks(&clock, pos->frame) / ticks_per_beat;
+    uint64_t beat_frame = app_jack_clock_frame(&clock, abs_beat * ticks_per_beat);
+    //the tick of the position on the grid in the ticks of the position, it is the same as pos->tick when the grid is the one of the timebase
+    double grid_tick = ((double)pos->frame - (double)beat_frame) / snap->frames_per_tick;
+    if(fabs(grid_tick - (double)pos->tick) <= 1.0){
+	//the current beat started before this cycle, the next beat is the first that can start in it
+	if(beat_frame < pos->frame){
+	    abs_beat += 1;
+	    beat_frame = app_jack_clock_frame(&clock, abs_beat * ticks_per_beat);
+	    app_jack_next_beat(&bar, &beat, pos->beats_per_bar);
+	}
+	while(beat_frame < (uint64_t)pos->frame + nframes && snap->num_beats < MAX_CYCLE_BEATS){
+	    JACK_TRANSPORT_BEAT* cycle_beat = &(snap->beats[snap->num_beats]);
+	    cycle_beat->frame = (NFRAMES_T)(beat_frame - pos->frame);
+	    cycle_beat->bar = bar;
+	    cycle_beat->beat = beat;
+	    snap->num_beats += 1;
+	    jack_data->est_bar = bar;
+	    jack_data->est_beat = beat;
+	    abs_beat += 1;
+	    beat_frame = app_jack_clock_frame(&clock, abs_beat * ticks_per_beat);
+	    app_jack_next_beat(&bar, &beat, pos->beats_per_bar);
 	}
+	return;
+    }
+
+    //the timebase master has its own beat grid (for example a tempo map), so estimate the beats from the ticks
+    //the ticks are whole numbers, a beat estimated in the last tick of a cycle can still have tick 0 in the next cycle
+    double frames_to_beat = 0;
+    if(pos->tick != 0){
+	frames_to_beat = ((double)pos->ticks_per_beat - (double)pos->tick) * snap->frames_per_tick;
+	app_jack_next_beat(&bar, &beat, pos->beats_per_bar);
+    }
+    else if(bar == jack_data->est_bar && beat == jack_data->est_beat){
+	frames_to_beat = pos->ticks_per_beat * snap->frames_per_tick;
+	app_jack_next_beat(&bar, &beat, pos->beats_per_bar);
+    }
+    double frames_per_beat = snap->frames_per_tick * pos->ticks_per_beat;
+    while(frames_to_beat < (double)nframes && snap->num_beats < MAX_CYCLE_BEATS){
+	JACK_TRANSPORT_BEAT* cycle_beat = &(snap->beats[snap->num_beats]);
+	cycle_beat->frame = (NFRAMES_T)frames_to_beat;
+	cycle_beat->bar = bar;
+	cycle_beat->beat = beat;
+	snap->num_beats += 1;
+	jack_data->est_bar = bar;
+	jack_data->est_beat = beat;
+	frames_to_beat += frames_per_beat;
+	app_jack_next_beat(&bar, &beat, pos->beats_per_bar);
     }
-    return 0;
+}
+
+void app_jack_transport_process_rt(JACK_INFO* jack_data, NFRAMES_T nframes){
+    if(!jack_data)return;
+    JACK_TRANSPORT_SNAP* snap = &(jack_data->transport);
+    jack_position_t pos;
+    jack_transport_state_t state = jack_transport_query(jack_data->client, &pos);
+    snap->state = state;
+    snap->playing = 0;
+    if(state != JackTransportStopped)snap->playing = 1;
+    snap->frame_valid = 0;
+    if(pos.valid)snap->frame_valid = 1;
+    snap->frame = pos.frame;
+    snap->bbt_valid = 0;
+    snap->num_beats = 0;
+    if(pos.valid != JackPositionBBT)return;
+    snap->bbt_valid = 1;
+    snap->bar = pos.bar;
+    snap->beat = pos.beat;
+    snap->tick = pos.tick;
+    snap->ticks_per_beat = (SAMPLE_T)pos.ticks_per_beat;
+    snap->bpm = pos.beats_per_minute;
+    snap->beat_type = pos.beat_type;
+    snap->beats_per_bar = pos.beats_per_bar;
+    snap->frames_per_tick = 0;
+    if(pos.beats_per_minute > 0 && pos.ticks_per_beat > 0)
+	snap->frames_per_tick = ((double)pos.frame_rate * 60.0) / (pos.beats_per_minute * pos.ticks_per_beat);
+
+    //find the beats that start in this cycle, so the contexts dont have to work them out from the ticks
+    if(state == JackTransportRolling && snap->frames_per_tick > 0){
+	app_jack_transport_beats_rt(jack_data, &pos, nframes);
+    }
+    else{
+	jack_data->est_bar = 0;
+	jack_data->est_beat = 0;
+    }
+
+    //now update the bar, beat, tick and is playing parameters from the snapshot for [audio-thread] and [main-thread]
+    //update the params on [audio-thread] in rt_tick (as slow as ui [main-thread] params) since the params will only be used to set anything if the user changes some of them on the [main-thread]
+    //all other contexts get the real time beats, ticks and other transport vars from the snapshot with app_jack_return_transport_snap_rt
+    if(jack_data->rt_tick != 0)return;
+    if(state == JackTransportRolling){
+	//After setting the value, get the value so the parameter is_changed will be 0 and app_jack_update_transport_from_params_rt will not create a new tranport object
+	//even though a parameter was not changed by the ui
+	//get the bars
+	param_set_value(jack_data->trk_params, 1, (float)pos.bar, NULL, Operation_SetValue, 1);
+	param_get_value(jack_data->trk_params, 1, 0, 0, 1);
+	//get the beat
+	param_set_value(jack_data->trk_params, 2, (float)pos.beat, NULL, Operation_SetValue, 1);
+	param_get_value(jack_data->trk_params, 2, 0, 0, 1);
+	//get the tick
+	param_set_value(jack_data->trk_params, 3, (float)pos.tick, NULL, Operation_SetValue, 1);
+	param_get_value(jack_data->trk_params, 3, 0, 0, 1);
+    }
+    //get the isPlaying state even if the Jack transport head is not rolling
+    param_set_value(jack_data->trk_params, 4, (float)state, NULL, Operation_SetValue, 1);
+    param_get_value(jack_data->trk_params, 4, 0, 0, 1);
+}
+
+const JACK_TRANSPORT_SNAP* app_jack_return_transport_snap_rt(void* audio_client){
+    JACK_INFO* jack_data = (JACK_INFO*)audio_client;
+    if(!jack_data)return NULL;
+    return &(jack_data->transport);
 }
 
 int app_jack_read_rt_to_ui_messages(JACK_INFO* jack_data){
@@ -167,7 +398,7 @@ int app_jack_read_rt_to_ui_messages(JACK_INFO* jack_data){
     context_sub_process_ui(jack_data->control_data);
     
     //read the param rt_to_ui messages and set the parameter values
-    param_msgs_process(jack_data->trk_params, 0);
+    param_msgs_process(jack_data->param_rings, 0);
     
     return 0;    
 }
@@ -179,53 +410,22 @@ PRM_CONTAIN* app_jack_param_return_param_container(JACK_INFO* jack_data){
 }
 
 void app_jack_clean_midi_cont(JACK_MIDI_CONT* midi_cont){
-    if(midi_cont->buf_size)free(midi_cont->buf_size);
-    if(midi_cont->nframe_nums)free(midi_cont->nframe_nums);
-    if(midi_cont->note_pitches)free(midi_cont->note_pitches);
-    if(midi_cont->types)free(midi_cont->types);
-    if(midi_cont->vel_trig)free(midi_cont->vel_trig);
+    if(midi_cont->events)free(midi_cont->events);
+    midi_cont->events = NULL;
 }
 
-JACK_MIDI_CONT* app_jack_init_midi_cont(unsigned int array_size){
+JACK_MIDI_CONT* app_jack_init_midi_cont(void* audio_client){
+    JACK_INFO* jack_data = (JACK_INFO*)audio_client;
+    //a jack port can have an event on each frame of the buffer
+    unsigned int array_size = MAX_MIDI_CONT_ITEMS;
+    if(jack_data && jack_data->buffer_size > array_size)array_size = jack_data->buffer_size;
     JACK_MIDI_CONT* ret_midi_cont = NULL;
     ret_midi_cont = malloc(sizeof(JACK_MIDI_CONT));
     if(!ret_midi_cont)return NULL;
     ret_midi_cont->array_size = array_size;
     ret_midi_cont->num_events = 0;
-    ret_midi_cont->w_pos = 0;
-    ret_midi_cont->buf_size = NULL;
-    ret_midi_cont->nframe_nums = NULL;
-    ret_midi_cont->note_pitches = NULL;
-    ret_midi_cont->types = NULL;
-    ret_midi_cont->vel_trig = NULL;
- 
-    ret_midi_cont->buf_size = calloc(array_size, sizeof(size_t));
-    if(!ret_midi_cont->buf_size){
-	app_jack_clean_midi_cont(ret_midi_cont);
-	free(ret_midi_cont);
-	return NULL;
-    }
-    ret_midi_cont->nframe_nums = calloc(array_size, sizeof(NFRAMES_T));
-    if(!ret_midi_cont->nframe_nums){
-	app_jack_clean_midi_cont(ret_midi_cont);
-	free(ret_midi_cont);
-	return NULL;
-    }    
-    ret_midi_cont->note_pitches = calloc(array_size, sizeof(MIDI_DATA_T));
-    if(!ret_midi_cont->note_pitches){
-	app_jack_clean_midi_cont(ret_midi_cont);
-	free(ret_midi_cont);
-	return NULL;
-    }    
-    ret_midi_cont->types = calloc(array_size, sizeof(MIDI_DATA_T));
-    if(!ret_midi_cont->types){
-	app_jack_clean_midi_cont(ret_midi_cont);
-	free(ret_midi_cont);
-	return NULL;
-    }
-    ret_midi_cont->vel_trig = calloc(array_size, sizeof(MIDI_DATA_T));
-    if(!ret_midi_cont->vel_trig){
-	app_jack_clean_midi_cont(ret_midi_cont);
+    ret_midi_cont->events = calloc(array_size, sizeof(JACK_MIDI_EVENT));
+    if(!ret_midi_cont->events){
 	free(ret_midi_cont);
 	return NULL;
     }
@@ -234,15 +434,8 @@ JACK_MIDI_CONT* app_jack_init_midi_cont(unsigned int array_size){
 
 void app_jack_midi_cont_reset(JACK_MIDI_CONT* midi_cont){
     if(!midi_cont)return;
-    unsigned int size = midi_cont->array_size;
-    if(size<=0)return;
+    //the events are written again before they are read, so they dont need to be cleared
     midi_cont->num_events = 0;
-    midi_cont->w_pos = 0;
-    memset(midi_cont->buf_size, 0, size * sizeof(size_t));
-    memset(midi_cont->nframe_nums, 0, size * sizeof(NFRAMES_T));
-    memset(midi_cont->note_pitches, 0, size * sizeof(MIDI_DATA_T));
-    memset(midi_cont->types, 0, size * sizeof(MIDI_DATA_T));
-    memset(midi_cont->vel_trig, 0, size * sizeof(MIDI_DATA_T));
 }
 
 static int init_jack_ports(JACK_INFO *jack_data, int ports_num, unsigned int *ports_types,
@@ -308,9 +501,70 @@ void* app_jack_create_port_on_client(void* client_in, unsigned int port_type, un
     
     void* ret_port = jack_port_register(client, port_name, type, io_type, 0);
     if(!ret_port)return NULL;
+    //the midi inputs are decoded once per cycle on the midi bus
+    //a midi input that is not on the bus would never get its events, so the registration fails instead
+    if(port_type == TYPE_MIDI && io_type == FLOW_INPUT){
+	if(app_jack_midi_bus_add(jack_data, (jack_port_t*)ret_port) != 0){
+	    log_append_logfile("Could not add midi port %s to the midi bus, the port is not registered\n", port_name);
+	    //the [audio-thread] never saw this port, so it can be unregistered right away
+	    jack_port_unregister(client, (jack_port_t*)ret_port);
+	    return NULL;
+	}
+    }
     return ret_port;
 }
 
+static int app_jack_midi_bus_add(JACK_INFO* jack_data, jack_port_t* port){
+    for(unsigned int i = 0; i < MAX_MIDI_BUS_PORTS; i++){
+	JACK_MIDI_BUS_PORT* bus_port = &(jack_data->midi_bus[i]);
+	if(atomic_load_explicit(&bus_port->port, memory_order_relaxed) != NULL)continue;
+	if(!bus_port->midi_cont){
+	    bus_port->midi_cont = app_jack_init_midi_cont(jack_data);
+	    if(!bus_port->midi_cont)return -1;
+	}
+	//the midi_cont has to be there before the [audio-thread] sees the port
+	atomic_store_explicit(&bus_port->port, port, memory_order_release);
+	if(i >= atomic_load_explicit(&jack_data->midi_bus_size, memory_order_relaxed))
+	    atomic_store_explicit(&jack_data->midi_bus_size, i + 1, memory_order_release);
+	return 0;
+    }
+    return -1;
+}
+
+//unregister the port that the [audio-thread] can not decode anymore, called on [main-thread] from the context_sub_process_ui
+static void app_jack_port_unreg_free(void* state){
+    JACK_PORT_UNREG* unreg = (JACK_PORT_UNREG*)state;
+    if(!unreg)return;
+    //the client is closed already, its ports are gone with it
+    if(unreg->jack_data->client)jack_port_unregister(unreg->jack_data->client, unreg->port);
+    free(unreg);
+}
+
+void app_jack_midi_bus_process_rt(JACK_INFO* jack_data, NFRAMES_T nframes){
+    if(!jack_data)return;
+    unsigned int bus_size = atomic_load_explicit(&jack_data->midi_bus_size, memory_order_acquire);
+    for(unsigned int i = 0; i < bus_size; i++){
+	JACK_MIDI_BUS_PORT* bus_port = &(jack_data->midi_bus[i]);
+	jack_port_t* port = atomic_load_explicit(&bus_port->port, memory_order_acquire);
+	bus_port->decoded_port = port;
+	if(!port)continue;
+	app_jack_midi_cont_reset(bus_port->midi_cont);
+	void* midi_buffer = jack_port_get_buffer(port, nframes);
+	app_jack_return_notes_vels_rt(midi_buffer, bus_port->midi_cont);
+    }
+}
+
+const JACK_MIDI_CONT* app_jack_midi_bus_return_rt(void* audio_client, void* port){
+    JACK_INFO* jack_data = (JACK_INFO*)audio_client;
+    if(!jack_data || !port)return NULL;
+    unsigned int bus_size = atomic_load_explicit(&jack_data->midi_bus_size, memory_order_acquire);
+    for(unsigned int i = 0; i < bus_size; i++){
+	JACK_MIDI_BUS_PORT* bus_port = &(jack_data->midi_bus[i]);
+	if(bus_port->decoded_port == port)return bus_port->midi_cont;
+    }
+    return NULL;
+}
+
 float app_jack_return_samplerate(JACK_INFO* jack_data){
     if(!jack_data)return -1;
     if(!jack_data->client)return -1;
@@ -322,6 +576,19 @@ int app_jack_return_buffer_size(JACK_INFO* jack_data){
     return jack_get_buffer_size(jack_data->client);
 }
 
+uint32_t app_jack_frame_time(void* audio_client){
+    JACK_INFO* jack_data = (JACK_INFO*)audio_client;
+    if(!jack_data)return 0;
+    if(!jack_data->client)return 0;
+    return (uint32_t)jack_frame_time(jack_data->client);
+}
+uint32_t app_jack_last_frame_time_rt(void* audio_client){
+    JACK_INFO* jack_data = (JACK_INFO*)audio_client;
+    if(!jack_data)return 0;
+    if(!jack_data->client)return 0;
+    return (uint32_t)jack_last_frame_time(jack_data->client);
+}
+
 int app_jack_activate(JACK_INFO* jack_data){
     //activate the client and launch the process function
     if(jack_activate (jack_data->client)){
@@ -388,30 +655,24 @@ int app_jack_midi_events_write_rt(void* buffer, jack_nframes_t time, const jack_
 }
 
 void app_jack_return_notes_vels_rt(void* midi_in, JACK_MIDI_CONT* midi_cont){  
-    if(midi_in == NULL)return;
-    int event_count = 0;
-    event_count = jack_midi_get_event_count(midi_in);
-    if(event_count<=0)return;
-    midi_cont->num_events = event_count;
-    if((midi_cont->num_events + midi_cont->w_pos) > midi_cont->array_size)midi_cont->num_events = (midi_cont->array_size - midi_cont->w_pos);
+    if(midi_in == NULL || midi_cont == NULL)return;
+    uint32_t event_count = jack_midi_get_event_count(midi_in);
     //go through all the midi events
-    for(int en = 0; en<midi_cont->num_events; en++){	
+    for(uint32_t en = 0; en < event_count; en++){
+	if(midi_cont->num_events >= midi_cont->array_size)return;
 	jack_midi_event_t in_event;	
 	if(jack_midi_event_get(&in_event, midi_in, en)!=0)return;
-	
-	//if the note is correct set the vel_trig array of this note index to the
-	//midi event velocity
-	if(midi_cont->vel_trig!=NULL)
-	    midi_cont->vel_trig[midi_cont->w_pos] = in_event.buffer[2];
-	if(midi_cont->note_pitches!=NULL)
-	    midi_cont->note_pitches[midi_cont->w_pos] = in_event.buffer[1];
-	if(midi_cont->nframe_nums!=NULL)
-	    midi_cont->nframe_nums[midi_cont->w_pos] = in_event.time;
-	if(midi_cont->types!=NULL)
-	    midi_cont->types[midi_cont->w_pos] = in_event.buffer[0];
-	if(midi_cont->buf_size!=NULL)
-	    midi_cont->buf_size[midi_cont->w_pos] = in_event.size;
-	midi_cont->w_pos += 1;
+	if(in_event.size == 0)continue;
+	JACK_MIDI_EVENT* event = &(midi_cont->events[midi_cont->num_events]);
+	event->frame = in_event.time;
+	event->size = (uint32_t)in_event.size;
+	event->status = in_event.buffer[0];
+	event->data[0] = 0;
+	event->data[1] = 0;
+	if(in_event.size > 1)event->data[0] = in_event.buffer[1];
+	if(in_event.size > 2)event->data[1] = in_event.buffer[2];
+	event->buffer = in_event.buffer;
+	midi_cont->num_events += 1;
     }
 }
 
@@ -488,9 +749,9 @@ const char** app_jack_port_names(JACK_INFO *jack_data, const char* port_name_pat
 int sample_rate_change(jack_nframes_t new_sample_rate, void *arg){
     JACK_INFO *jack_data = (JACK_INFO*) arg;
     if(!jack_data)return -1;
-    //TODO this should be [thread-safe] and not a simple var change
     //set the new sample rate on the app data struct so other functions can use that info
-    jack_data->sample_rate = new_sample_rate;
+    //the timebase callback sees the new rate on its next cycle and makes the clock ratio again
+    atomic_store_explicit(&jack_data->sample_rate, new_sample_rate, memory_order_release);
 
     return 0;
 }
@@ -500,6 +761,32 @@ void app_jack_unregister_port(void* client_in, void* port){
     if(!port)return;
     JACK_INFO* jack_data = (JACK_INFO*)client_in;
     jack_client_t* client = jack_data->client;
+    for(unsigned int i = 0; i < MAX_MIDI_BUS_PORTS; i++){
+	JACK_MIDI_BUS_PORT* bus_port = &(jack_data->midi_bus[i]);
+	if(atomic_load_explicit(&bus_port->port, memory_order_relaxed) != port)continue;
+	atomic_store_explicit(&bus_port->port, NULL, memory_order_release);
+	//the [audio-thread] could be decoding the port right now, so unregister it after its next cycle
+	//give it a name no other port has first, so a port with the same name can be registered right away (for example when a plugin is loaded again)
+	char removed_name[MAX_STRING_MSG_LENGTH];
+	snprintf(removed_name, MAX_STRING_MSG_LENGTH, "removed_port_%u", jack_data->removed_ports);
+	jack_data->removed_ports += 1;
+	if(jack_port_rename(client, (jack_port_t*)port, removed_name) != 0)
+	    log_append_logfile("Could not rename the removed midi port, a port with its name can not be registered until it is unregistered\n");
+	JACK_PORT_UNREG* unreg = (JACK_PORT_UNREG*)malloc(sizeof(JACK_PORT_UNREG));
+	if(unreg){
+	    unreg->jack_data = jack_data;
+	    unreg->port = (jack_port_t*)port;
+	    if(context_sub_retire(jack_data->control_data, (void*)unreg, app_jack_port_unreg_free) == 0)return;
+	    free(unreg);
+	}
+	//could not unregister the port later, so block until the [audio-thread] passed one cycle without the port and unregister it now
+	if(context_sub_wait_for_stop(jack_data->control_data, NULL) != 0){
+	    log_append_logfile("Could not unregister midi port from the midi bus\n");
+	    return;
+	}
+	jack_port_unregister(client, (jack_port_t*)port);
+	return;
+    }
     jack_port_unregister(client, port);
 }
 
@@ -508,13 +795,21 @@ void jack_clean_memory(void* jack_data_in){
     if(!jack_data)return;   
     //close the jack client
     if(jack_data->client!=NULL)jack_client_close(jack_data->client);
+    jack_data->client = NULL;
     //clear the jack_data itself
     //first the port array
     if(jack_data->ports!=NULL)free(jack_data->ports);
     //clean the general parameters
     if(jack_data->trk_params)param_clean_param_container(jack_data->trk_params);
+    if(jack_data->param_rings)param_clean_param_rings(jack_data->param_rings);
 
     context_sub_clean(jack_data->control_data);
+    for(int i = 0; i < MAX_MIDI_BUS_PORTS; i++){
+	JACK_MIDI_CONT* midi_cont = jack_data->midi_bus[i].midi_cont;
+	if(!midi_cont)continue;
+	app_jack_clean_midi_cont(midi_cont);
+	free(midi_cont);
+    }
     free(jack_data);
 }
 
@@ -535,76 +830,46 @@ static int app_jack_transport(JACK_INFO* jack_data, unsigned int transport_type)
 
 void timebbt_callback_rt(jack_transport_state_t state, jack_nframes_t nframes, jack_position_t *pos,
 	      int new_pos, void *arg){ 
-    //the struct will be used to get a struct from the circle buffer for the time_beats_per_bar and such
     JACK_INFO* jack_data = (JACK_INFO*) arg;
     if(!jack_data)return;
-    //minutes since frame 0
-    double min;
-    //ticks since frame 0
-    long abs_tick;
-    //beats since frame 0
-    long abs_beat;
-    //bars since frame 0, with remainder
-    double abs_bars;
-    //only calculate the beats and bars from frames on the first run of this function
-    if(new_pos && pos->valid != JackTransportBBT){
-	PRM_CONTAIN* transport_cntr = jack_data->trk_params;
-	pos->valid = JackPositionBBT;
-	pos->beats_per_bar = 4;
-	pos->beats_per_bar = param_get_value(transport_cntr, 5, 0, 0, 1);
-	pos->beat_type = 4;
-	pos->beat_type = param_get_value(transport_cntr, 6, 0, 0, 1);
-	
-	pos->ticks_per_beat = time_ticks_per_beat;
-	//get the bpm
-	pos->beats_per_minute = 120;
-	pos->beats_per_minute = param_get_value(transport_cntr, 0, 0, 0, 1);
-
-	//Compute the *pos members from frame
-	min = pos->frame / ((double) pos->frame_rate * 60.0);
-	abs_tick = min * pos->beats_per_minute * pos->ticks_per_beat; 
-	abs_beat = abs_tick / pos->ticks_per_beat;
-
-	pos->bar = abs_beat / pos->beats_per_bar;
-	pos->beat = abs_beat - (pos->bar * pos->beats_per_bar) + 1;
-	pos->tick = abs_tick - (abs_beat * pos->ticks_per_beat);
-	pos->bar_start_tick = pos->bar * pos->beats_per_bar * pos->ticks_per_beat;
-	pos->bar++;
-
-    }
-    else
-       {
-	   //if new pos is not requested add the ticks each cycle
-	   //TODO now tick drifts so bars and beats are calculated not from ticks, need to figure out how to
-	   //calculate from ticks and not drift
-	   if(!new_pos){
-	       pos->tick += (nframes * pos->ticks_per_beat * pos->beats_per_minute / (pos->frame_rate * 60));
-	   }
-	   double bpm_sec = (double)pos->beats_per_minute / 60.0;
-	   double secs = (double)pos->frame / (double)pos->frame_rate;
-	   double beats = bpm_sec * secs;
-	   double bar = beats/(double)pos->beats_per_bar;
-	   pos->bar = (unsigned int)bar;
-	   //pos->bar += 1;
-	   double beat_frac = bar - (unsigned int)bar;
-	   double beat_div = 1.0 / (double)pos->beats_per_bar;
-	   pos->beat = (unsigned int)(beat_frac / beat_div);
-	   pos->beat += 1;
-	   if(pos->beat == 1){
-	       pos->bar_start_tick += (pos->beats_per_bar * pos->ticks_per_beat);
-	   }
-	   while(pos->tick >= pos->ticks_per_beat){
-	       pos->tick -= pos->ticks_per_beat;
-	       /*
-	       if(++pos->beat > pos->beats_per_bar){
-		   pos->beat = 1;
-		   ++pos->bar;
-		   pos->bar_start_tick += (pos->beats_per_bar * pos->ticks_per_beat);
-	       }
-	       */
-	   }
-
-       }
+    JACK_CLOCK* clock = &(jack_data->clock);
+    uint32_t frame_rate = atomic_load_explicit(&jack_data->sample_rate, memory_order_acquire);
+    if(frame_rate == 0)frame_rate = pos->frame_rate;
+    //a new position brings the tempo with it (from a reposition) or it is taken from the transport parameters
+    if(new_pos || clock->tick_den == 0){
+	if((pos->valid & JackPositionBBT) && pos->beats_per_minute > 0){
+	    if(app_jack_clock_set(clock, pos->beats_per_minute, pos->beats_per_bar, pos->beat_type, frame_rate) != 0){
+		context_sub_send_msg(jack_data->control_data, (void*)jack_data, true,
+				     "Transport meter %g is not a whole number of beats, keeping %u beats per bar\n",
+				     (double)pos->beats_per_bar, clock->beats_per_bar);
+	    }
+	}
+	else{
+	    PRM_CONTAIN* transport_cntr = jack_data->trk_params;
+	    app_jack_clock_set(clock, param_get_value(transport_cntr, 0, 0, 0, 1), param_get_value(transport_cntr, 5, 0, 0, 1),
+			       param_get_value(transport_cntr, 6, 0, 0, 1), frame_rate);
+	}
+    }
+    //the sample rate changed, keep the tempo but make the ratio again
+    if(clock->frame_rate != frame_rate){
+	app_jack_clock_set(clock, (double)clock->bpm_milli / 1000.0, clock->beats_per_bar, clock->beat_type, frame_rate);
+    }
+
+    //the position is computed from the absolute frame each cycle, so nothing is carried over from the last cycle
+    uint64_t ticks_per_beat = (uint64_t)time_ticks_per_beat;
+    uint64_t abs_tick = app_jack_clock_ticks(clock, pos->frame);
+    uint64_t abs_beat = abs_tick / ticks_per_beat;
+    uint64_t abs_bar = abs_beat / clock->beats_per_bar;
+
+    pos->valid = JackPositionBBT;
+    pos->beats_per_minute = (double)clock->bpm_milli / 1000.0;
+    pos->beats_per_bar = (float)clock->beats_per_bar;
+    pos->beat_type = clock->beat_type;
+    pos->ticks_per_beat = time_ticks_per_beat;
+    pos->bar = (int32_t)(abs_bar + 1);
+    pos->beat = (int32_t)(abs_beat - (abs_bar * clock->beats_per_bar) + 1);
+    pos->tick = (int32_t)(abs_tick - (abs_beat * ticks_per_beat));
+    pos->bar_start_tick = (double)(abs_bar * clock->beats_per_bar * ticks_per_beat);
 
     //if the bar exceed the max number of bars available in song stop
     if(pos->bar > MAX_BARS){
@@ -649,14 +914,18 @@ void app_jack_update_transport_from_params_rt(JACK_INFO* jack_data){
     new_pos.beat_type = param_get_value(transport_cntr, 6, 0, 0, 1);
     new_pos.ticks_per_beat = time_ticks_per_beat;
 
-    //first calculate how many beats from frame 0, with remainder
-    double seconds_passed = (((new_pos.bar) * new_pos.beats_per_bar) + (new_pos.beat - 1)) +
-	(new_pos.tick/new_pos.ticks_per_beat);
-    //now calculate how many seconds has passed since frame 0
-    seconds_passed = (seconds_passed / new_pos.beats_per_minute) * 60;
-    //now calculate the new frames since frame 0
-    jack_nframes_t frame = ceil(seconds_passed * old_pos.frame_rate);
-    new_pos.frame = frame;
+    //the frame of the position with the same integer clock the timebase uses, the bar and beat params start from 1
+    JACK_CLOCK clock = {0};
+    uint32_t frame_rate = atomic_load_explicit(&jack_data->sample_rate, memory_order_acquire);
+    if(frame_rate == 0)frame_rate = old_pos.frame_rate;
+    app_jack_clock_set(&clock, new_pos.beats_per_minute, new_pos.beats_per_bar, new_pos.beat_type, frame_rate);
+    int64_t abs_beat = ((int64_t)new_pos.bar - 1) * clock.beats_per_bar + ((int64_t)new_pos.beat - 1);
+    if(abs_beat < 0)abs_beat = 0;
+    uint64_t abs_tick = (uint64_t)abs_beat * (uint64_t)time_ticks_per_beat;
+    if(new_pos.tick > 0)abs_tick += (uint64_t)new_pos.tick;
+    uint64_t frame = app_jack_clock_frame(&clock, abs_tick);
+    if(frame > UINT32_MAX)frame = UINT32_MAX;
+    new_pos.frame = (jack_nframes_t)frame;
 
     float play = param_get_value(transport_cntr, 4, 0, 0, 1);
     app_jack_transport(jack_data, (int)play);
@@ -671,22 +940,18 @@ int app_jack_return_transport_rt(void* audio_client, int32_t* cur_bar, int32_t*
     JACK_INFO* jack_data = (JACK_INFO*)audio_client;
     if(!jack_data)return -1;
     
-    int isPlaying = 0;
-    
-    jack_position_t pos;
-    jack_transport_state_t state = jack_transport_query(jack_data->client, &pos);
-    if(state != JackTransportStopped)isPlaying = 1;
+    const JACK_TRANSPORT_SNAP* snap = &(jack_data->transport);
 
-    if(pos.valid) *total_frames = pos.frame;
+    if(snap->frame_valid) *total_frames = snap->frame;
     
-    if(pos.valid != JackPositionBBT)return -1;
-    *bpm = pos.beats_per_minute;
-    *beat_type = pos.beat_type;
-    *beats_per_bar = pos.beats_per_bar;
-    *cur_bar = pos.bar;
-    *cur_beat = pos.beat;
-    *cur_tick = pos.tick;
-    *ticks_per_beat = (SAMPLE_T)pos.ticks_per_beat;
+    if(!snap->bbt_valid)return -1;
+    *bpm = snap->bpm;
+    *beat_type = snap->beat_type;
+    *beats_per_bar = snap->beats_per_bar;
+    *cur_bar = snap->bar;
+    *cur_beat = snap->beat;
+    *cur_tick = snap->tick;
+    *ticks_per_beat = snap->ticks_per_beat;
     
-    return isPlaying;
+    return snap->playing;
 }
@@ -2,28 +2,68 @@
 #include <jack/jack.h>
 #include <jack/midiport.h>
 #include "../structs.h"
+#include "../types.h"
 #include "../contexts/params.h"
+//one midi event read from a jack midi port
+typedef struct _jack_midi_cont_event{
+    //when the event happened, in frames from the start of the cycle
+    NFRAMES_T frame;
+    //number of bytes in the whole midi message
+    uint32_t size;
+    //the status byte, the type and channel of the message
+    MIDI_DATA_T status;
+    //the two bytes after the status (for example the note pitch and velocity), 0 if the message is shorter
+    MIDI_DATA_T data[2];
+    //the whole message in the port buffer, for messages longer than 3 bytes like sysex
+    //points to the jack port buffer, so its valid only in the cycle the event was read in
+    const MIDI_DATA_T* buffer;
+}JACK_MIDI_EVENT;
 //struct to keep midi events info
 //its in the definition because its more convenient to access the members of this struct
 typedef struct _jack_midi_cont{
-    //buffer to store the note pitches
-    MIDI_DATA_T* note_pitches;
-    //buffer to store the velocities that triggered the note
-    MIDI_DATA_T* vel_trig;
-    //the types of the midi events
-    MIDI_DATA_T* types;
-    //when the events happened
-    NFRAMES_T* nframe_nums;
-    //number of bytes of data in the midi event buffer (that holds the note pitches etc.)
-    size_t* buf_size;
+    //the events in the order they came from the ports
+    JACK_MIDI_EVENT* events;
     //the number of events that occured
     NFRAMES_T num_events;
-    //the index of the event that should be written to in the buffer
-    NFRAMES_T w_pos;
-    //the total size of each of the arrays on this struct
+    //how many events fit in the events array
     unsigned int array_size;
 }JACK_MIDI_CONT;
 
+//a beat that starts inside the cycle
+typedef struct _jack_transport_beat{
+    //when the beat starts, in frames from the start of the cycle. Exact when the timebase counts the beats from frame 0 (like this client does),
+    //otherwise estimated from the ticks and up to one tick late
+    NFRAMES_T frame;
+    //the bar and the beat in the bar (both from 1) of the beat that starts
+    int32_t bar;
+    int32_t beat;
+}JACK_TRANSPORT_BEAT;
+//the transport position at the start of the cycle, taken once per cycle so all the contexts see the same position
+//its in the definition because its more convenient to access the members of this struct
+typedef struct _jack_transport_snap{
+    //the jack transport state and 1 if the transport is not stopped
+    jack_transport_state_t state;
+    int playing;
+    //1 if the transport frame is valid
+    int frame_valid;
+    //the transport frame at the start of the cycle
+    jack_nframes_t frame;
+    //1 if the bar, beat, tick and tempo are valid
+    int bbt_valid;
+    int32_t bar;
+    int32_t beat;
+    int32_t tick;
+    SAMPLE_T ticks_per_beat;
+    float bpm;
+    float beat_type;
+    float beats_per_bar;
+    //how many frames one tick lasts with the current tempo
+    double frames_per_tick;
+    //the beats that start in this cycle, only when the transport is rolling
+    JACK_TRANSPORT_BEAT beats[MAX_CYCLE_BEATS];
+    unsigned int num_beats;
+}JACK_TRANSPORT_SNAP;
+
 //jack main struct
 typedef struct _jack_info JACK_INFO;
 
@@ -44,14 +84,21 @@ PRM_CONTAIN* app_jack_param_return_param_container(JACK_INFO* jack_data);
 
 //clean the midi container
 void app_jack_clean_midi_cont(JACK_MIDI_CONT* midi_cont);
-//initate the midi container where velocities, note pitches etc will be stored
-JACK_MIDI_CONT* app_jack_init_midi_cont(unsigned int array_size);
-//reset all the arrays of the midi container to 0
+//initate the midi container where the midi events will be stored
+//the container holds one event per frame of the audio_client (JACK_INFO) buffer, but not less than MAX_MIDI_CONT_ITEMS
+JACK_MIDI_CONT* app_jack_init_midi_cont(void* audio_client);
+//empty the midi container, only the event count is reset
 void app_jack_midi_cont_reset(JACK_MIDI_CONT* midi_cont);
 //initializes the ports
 static int init_jack_ports(JACK_INFO *jack_data, int ports_num, unsigned int* ports_types,
 		    unsigned int *io_types,
 		    const char** ports_names);
+//decode the events of all the midi input ports of the client, call once per cycle on [audio-thread]
+//after app_jack_read_ui_to_rt_messages and before the contexts read the midi
+void app_jack_midi_bus_process_rt(JACK_INFO* jack_data, NFRAMES_T nframes);
+//return the events of the midi input port decoded in this cycle, the container is shared so only read from it
+//audio_client is the JACK_INFO, returns NULL if the port is not on the midi bus. Use only on [audio-thread]
+const JACK_MIDI_CONT* app_jack_midi_bus_return_rt(void* audio_client, void* port);
 //rename the port on client
 int app_jack_port_rename(void* client_in, void* port, const char* new_port_name);
 //register ports on a jack client if its known to the data
@@ -61,6 +108,11 @@ void* app_jack_create_port_on_client(void* client_in, unsigned int port_type, un
 float app_jack_return_samplerate(JACK_INFO* jack_data);
 //return the buffer size
 int app_jack_return_buffer_size(JACK_INFO* jack_data);
+//return the estimated current frame of the jack server clock, used to stamp the parameter messages on [main-thread]
+//audio_client is the JACK_INFO, returns 0 if there is no client
+uint32_t app_jack_frame_time(void* audio_client);
+//return the jack server clock frame at the start of the current process cycle, use only on [audio-thread]
+uint32_t app_jack_last_frame_time_rt(void* audio_client);
 //activate the jack client
 int app_jack_activate(JACK_INFO *jack_data);
 //return buffer from a jack port name
@@ -73,7 +125,8 @@ void app_jack_midi_clear_buffer_rt(void* buffer);
 //write to the midi out buffer
 int app_jack_midi_events_write_rt(void* buffer, jack_nframes_t time, const jack_midi_data_t* data,
 				  size_t data_size);
-//return three arrays for the midi_in, notes played, velocities and the times for each in nframe
+//add the midi events of the midi_in port buffer to the midi_cont after the events that are already there
+//all message types are kept, events that do not fit in the container are dropped
 void app_jack_return_notes_vels_rt(void* midi_in, JACK_MIDI_CONT* midi_cont);
 //disconnect ports belonging to this client
 int app_jack_disconnect_all_ports(JACK_INFO* jack_data, unsigned int type_pattern, unsigned long flags);
@@ -93,7 +146,8 @@ const char** app_jack_port_names(JACK_INFO *jack_data, const char* port_name_pat
 				 unsigned long flags);
 //function callback when server changes the sample_rate
 int sample_rate_change(jack_nframes_t new_sample_rate, void *arg);
-//unregister port from client
+//unregister port from client, the midi input ports are unregistered when the [audio-thread] can not decode them anymore
+//until then they are renamed, so a port with the same name can be registered right after this
 void app_jack_unregister_port(void* client, void* port);
 //clean the memory of the jack_data
 void jack_clean_memory(void* jack_data);
@@ -103,7 +157,12 @@ void timebbt_callback_rt(jack_transport_state_t state, jack_nframes_t nframes, j
 //check if any parameters that control the transport head have changed, if yes - request an update with the new
 //parameters to the transport head
 void app_jack_update_transport_from_params_rt(JACK_INFO* jack_data);
-//return the jack transport position info to the various variables
+//take the transport snapshot for this cycle and update the transport parameters from it, call once per cycle on [audio-thread]
+//after app_jack_read_ui_to_rt_messages and before the contexts process
+void app_jack_transport_process_rt(JACK_INFO* jack_data, NFRAMES_T nframes);
+//return the transport snapshot of this cycle, audio_client is the JACK_INFO. Use only on [audio-thread]
+const JACK_TRANSPORT_SNAP* app_jack_return_transport_snap_rt(void* audio_client);
+//return the jack transport position info of this cycle to the various variables, copied from the transport snapshot
 int app_jack_return_transport_rt(void* audio_client, int32_t* cur_bar, int32_t* cur_beat,
 				 int32_t* cur_tick, SAMPLE_T* ticks_per_beat, jack_nframes_t* total_frames,
 				 float* bmp, float* beat_type, float* beats_per_bar);
@@ -11,6 +11,7 @@
 //functions for log file
 #include "util_funcs/log_funcs.h"
 #include "util_funcs/json_funcs.h"
+#include "types.h"
 
 //the ui conf file where the settings for the ui side of the app is held
 #define UI_CONF "ui_conf.json"
@@ -24,9 +25,6 @@
 #define W_HALFDELAY 100
 //maximum length for the display_text of the window
 #define MAX_DISPLAY_TEXT 100
-//maximum string length for the display of the parameter values,
-//should be short, because its hard to read values when they scroll, so better to fit in a window
-#define MAX_VALUE_TEXT 16
 
 //max windows that can fit in a window, after that scroll
 //can change the amount in UI_CONF file
@@ -1041,6 +1039,17 @@ int curr_screen_read(APP_INTRF* app_intrf, CURR_SCREEN* curr_scr){
 		    }
 		}
 	    }
+	    //right click on a parameter to midi learn it, the next control change on the master midi input will control it
+	    //right click it again before the control change to cancel, ctrl + right click removes its control changes
+	    if(event.bstate & BUTTON3_CLICKED){
+		WIN* clicked_win = ctrl_win_return_clicked(curr_scr, event.y, event.x);
+		if(clicked_win!=NULL && (clicked_win->win_type & 0xff00) == Param_win_type){
+		    if(event.bstate & BUTTON_CTRL)
+			nav_midi_forget_cx(app_intrf, clicked_win->cx_obj);
+		    else
+			nav_midi_learn_cx(app_intrf, clicked_win->cx_obj);
+		}
+	    }
 	    //check if double clicked, mainly to increase/decrease params more
 	    if(event.bstate & BUTTON1_DOUBLE_CLICKED){
 		WIN* clicked_win = ctrl_win_return_clicked(curr_scr, event.y, event.x);
@@ -1432,7 +1441,7 @@ int win_create(APP_INTRF* app_intrf, WIN* app_win, int height, int width, int st
 		app_win->children_array_size = 2;
 		app_win->children_array = win_init_win_array(app_intrf, app_win, 2, cx_param_array, NULL, (unsigned int[2]){20,15}, 0, (unsigned int[2]){1,0}, NULL);
 		//put the value of the param as the value window text right away, otherwise when refreshed the text would be empty for a moment
-		if(nav_get_cx_value_as_string(app_intrf, cx_obj, app_win->children_array[1]->display_text, MAX_VALUE_TEXT)!=1){
+		if(nav_get_cx_value_as_string(app_intrf, cx_obj, app_win->children_array[1]->display_text, MAX_PARAM_VALUE_STRING)!=1){
 		    app_win->children_array[1]->display_text = NULL;
 		}
 		app_win->children_array[1]->has_text = 1;
@@ -1554,9 +1563,14 @@ void win_refresh(APP_INTRF* app_intrf, CURR_SCREEN* curr_scr, WIN* win, unsigned
     //if this is a parameter value update it
     //otherwise the value will stay the same as when the window was created
     if(win->cx_obj && win->win_type==(Param_win_type | Param_val_win_type)){
-	if(nav_get_cx_value_as_string(app_intrf, win->cx_obj, win->display_text, MAX_VALUE_TEXT)!=1){
+	const char* val_string = nav_get_cx_value_string(app_intrf, win->cx_obj);
+	if(!val_string){
 	    win->display_text = NULL;
 	}
+	//the parameter keeps the formatted value, copy it only if it changed
+	if(val_string && win->display_text && strncmp(win->display_text, val_string, MAX_PARAM_VALUE_STRING - 1) != 0){
+	    snprintf(win->display_text, MAX_PARAM_VALUE_STRING, "%s", val_string);
+	}
 	win->has_text = 1;
     }
     //also get the name of the parameter on refresh, since it can change from the data size, without this, the user would have to exit this context and enter again to see the new parameter name
@@ -2,10 +2,19 @@
 #include "structs.h"
 #define MAX_STRING_MSG_LENGTH 128 //max string size for sys messages
 #define MAX_PARAM_NAME_LENGTH 100 //the max length for param names
-#define MAX_SYS_BUFFER_ARRAY_SIZE 256 //max size for ring buffer arrays in sys messages between threads
-#define MAX_PARAM_RING_BUFFER_ARRAY_SIZE 2048 //max size for the parameter ring buffer messaging arrays
+#define MAX_PARAM_VALUE_STRING 16 //the max length for the display string of a parameter value, short so the values fit the ui windows without scrolling
+#define MAX_SYS_RING_SIZE 8192 //size in bytes of the message rings for sys messages between threads
+#define MAX_CX_CMD_BATCH 64 //how many commands can be submitted at once with context_sub_submit
+#define MAX_PARAM_RING_BUFFER_ARRAY_SIZE 2048 //max size for the parameter ring buffer messaging arrays, these are shared by all the parameter containers of a context
+#define MAX_PARAM_STRING_RING_SIZE 8192 //size in bytes of the parameter message rings that carry strings (new ui_names and similar), these are rarely used
+#define MAX_PARAM_RING_CONTAINERS 64 //how many parameter containers can share the parameter ring buffers of one context
+#define MAX_PARAMS_PER_CONTAINER 65536 //how many parameters a parameter container can have, so the parameter id fits the parameter ring messages
 #define RT_CYCLES 25 //in what interval the rt thread should give info to the ui thread to not overwhelm it.
-#define MAX_MIDI_CONT_ITEMS 50 //how many midi events there can be in the jack midi container struct
+#define MAX_CYCLE_BEATS 16 //how many beat starts the transport snapshot of one cycle can hold
+#define MAX_MIDI_BUS_PORTS 128 //how many midi input ports the per cycle midi bus of the jack client decodes
+#define MAX_MIDI_CONT_ITEMS 256 //the least number of midi events the jack midi container struct holds, its bigger if the jack buffer is
+#define MIDI_CHANNELS 16 //how many midi channels there are, used for the midi learn table
+#define MIDI_CC_NUM 128 //how many control change numbers there are on a midi channel
 #define MAX_UNIQUE_ID_STRING 128 //max length for unique ids that use char* (for example the clap unique id for plugins)
 #define MAX_FILETYPE_STRING 20 //max length for the char* that has a filetype ("txt", "json" etc)
 #define MAX_PATH_STRING 2048 //max length for a filepath
@@ -45,7 +54,13 @@ enum paramOperType{
     Operation_SetIncr = 0x05, //set the increment of the parameter to this value
     Operation_SetDefValue = 0x06, // set the default value to this value
     Operation_ChangeName = 0x07, // change the name of the parameter
-    Operation_ToggleHidden = 0x08 //value should change if the parameter is hidden or not
+    Operation_ToggleHidden = 0x08, //value should change if the parameter is hidden or not
+    Operation_Snapshot = 0x09 //used only in params.c, set the published snapshot of the container at this place in the messages
+};
+//how the parameter block ramp moves to a new value, check param_set_ramp
+enum prmRampType{
+    Ramp_Linear = 0x01, //straight line that reaches the new value in the ramp time
+    Ramp_OnePole = 0x02 //exponential approach, fast at first and slow near the new value
 };
 
 //wavetables
@@ -94,23 +109,38 @@ enum MsgFromRT{
     MSG_PLUGIN_ACTIVATE_PROCESS = 5, //message that plugin needs to be activated on main thread and then start_processing function called on the audio thread
     MSG_PLUGIN_STOP_PROCESS = 6, //message to stop processing the plugin
     MSG_STOP_ALL = 7, //stop the whole context processing, usually done when cleaning memory
-    MSG_START_ALL = 8 //start the whole context again, usually done after stopping before init of contexts
+    MSG_START_ALL = 8, //start the whole context again, usually done after stopping before init of contexts
+    MSG_CMD_BATCH = 9 //a batch of start and stop commands from context_sub_submit, all applied in the same cycle
 };
 //this holds the subcontext data address (user_data) and the enum (from MSGfromRT) to tell what to do with the subcontext
+//messages with a string (MSG_PLUGIN_SENT_STRING) have the null terminated string right after this struct in the message ring
 typedef struct _ring_sys_msg{
     unsigned int msg_enum; //what to do with the plugin
-    char msg[MAX_STRING_MSG_LENGTH];
     void* user_data; //user data for the function that gets called depending on the msg. This can be a plugin address or a sample address and etc.
 }RING_SYS_MSG;
 
-//Parameter ring data struct. A message to manipulate the parameter
+//Parameter ring data struct. A message to manipulate the parameter value, 16 bytes so its cheap to copy on the [audio-thread]
 typedef struct _app_param_ring_data_bit{
-    //the parameter id of the object.
-    int param_id;
     //the parameter value to what to set the parameter or what the parameter value is now
     PARAM_T param_value;
-    //this can be used to send a new name to the parameter for example
-    char param_string[MAX_PARAM_NAME_LENGTH];
+    //the audio clock frame when the message was sent, the [audio-thread] places the change in its block from this
+    //0 if the message has no frame, then the change happens at the start of the block
+    uint32_t param_frame;
+    //the parameter id of the object, so a container can have at most MAX_PARAMS_PER_CONTAINER parameters
+    uint16_t param_id;
+    //the id of the parameter container in the parameter rings the message was sent through
+    uint8_t cont_id;
     //what to do with parameter? check paramOperType
     unsigned char param_op;
 }PARAM_RING_DATA_BIT;
+//Parameter ring string struct. A message that carries a string for the parameter (for example a new ui_name), sent on a separate message ring
+//since these are rare and much bigger than the value messages. The null terminated string is right after this struct in the message ring,
+//so the message is only as long as the string
+typedef struct _app_param_ring_string_bit{
+    //the parameter id of the object.
+    int32_t param_id;
+    //the id of the parameter container in the parameter rings the message was sent through
+    uint16_t cont_id;
+    //what to do with parameter? check paramOperType
+    unsigned char param_op;
+}PARAM_RING_STRING_BIT;
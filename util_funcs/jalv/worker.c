@@ -6,19 +6,22 @@
 #include "lv2/core/lv2.h"
 #include "lv2/worker/worker.h"
 #include "zix/common.h"
-#include "zix/ring.h"
 #include "zix/sem.h"
 #include "zix/thread.h"
+#include "../math_funcs.h"
+#include "../msg_ring.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define MAX_PACKET_SIZE 4096U
+// A packet can be at most half of the ring, so it always fits once read
+#define WORKER_RING_SIZE (MAX_PACKET_SIZE * 4U)
 
 struct JalvWorkerImpl {
-  ZixRing*                    requests;  ///< Requests to the worker
-  ZixRing*                    responses; ///< Responses from the worker
-  void*                       response;  ///< Worker response buffer
+  MSG_RING*                   requests;  ///< Requests to the worker
+  MSG_RING*                   responses; ///< Responses from the worker
   ZixSem*                     lock;      ///< Lock for plugin work() method
   bool                        exit;      ///< Exit flag
   ZixSem                      sem;       ///< Worker semaphore
@@ -29,17 +32,18 @@ struct JalvWorkerImpl {
 };
 
 static LV2_Worker_Status
-jalv_worker_write_packet(ZixRing* const    target,
+jalv_worker_write_packet(MSG_RING* const   target,
                          const uint32_t    size,
                          const void* const data)
 {
-  ZixRingTransaction tx = zix_ring_begin_write(target);
-  if (zix_ring_amend_write(target, &tx, &size, sizeof(size)) ||
-      zix_ring_amend_write(target, &tx, data, size)) {
+  // The packet is written in place, the ring keeps its size
+  void* const dest = msg_ring_reserve(target, size);
+  if (!dest) {
     return LV2_WORKER_ERR_NO_SPACE;
   }
 
-  zix_ring_commit_write(target, &tx);
+  memcpy(dest, data, size);
+  msg_ring_commit(target, size);
   return LV2_WORKER_SUCCESS;
 }
 
@@ -55,7 +59,8 @@ static void*
 worker_func(void* const data)
 {
   JalvWorker* const worker = (JalvWorker*)data;
-  void*             buf    = NULL;
+
+  math_denormals_off();
 
   while (true) {
     // Wait for a request
@@ -64,30 +69,22 @@ worker_func(void* const data)
       break;
     }
 
-    // Read the size header of the request
-    uint32_t size = 0;
-    zix_ring_read(worker->requests, &size, sizeof(size));
-
-    // Reallocate buffer to accommodate request if necessary
-    void* const new_buf = realloc(buf, size);
-    if (new_buf) {
-      // Read request into buffer
-      buf = new_buf;
-      zix_ring_read(worker->requests, buf, size);
-
-      // Lock and dispatch request to plugin's work handler
-      zix_sem_wait(worker->lock);
-      worker->iface->work(
-        worker->handle, jalv_worker_respond, worker, size, buf);
-      zix_sem_post(worker->lock);
-
-    } else {
-      // Reallocation failed, skip request to avoid corrupting ring
-      zix_ring_skip(worker->requests, size);
+    // The request is given to the plugin right from the ring memory
+    uint32_t          size    = 0U;
+    const void* const request = msg_ring_peek(worker->requests, &size);
+    if (!request) {
+      continue;
     }
+
+    // Lock and dispatch request to plugin's work handler
+    zix_sem_wait(worker->lock);
+    worker->iface->work(
+      worker->handle, jalv_worker_respond, worker, size, request);
+    zix_sem_post(worker->lock);
+
+    msg_ring_release(worker->requests);
   }
 
-  free(buf);
   return NULL;
 }
 
@@ -101,14 +98,14 @@ jalv_worker_launch(JalvWorker* const worker)
     return st;
   }
 
-  ZixRing* const requests = zix_ring_new(NULL, MAX_PACKET_SIZE);
+  MSG_RING* const requests = msg_ring_init(WORKER_RING_SIZE);
   if (!requests) {
     zix_thread_join(worker->thread, NULL);
     zix_sem_destroy(&worker->sem);
     return ZIX_STATUS_NO_MEM;
   }
 
-  zix_ring_mlock(requests);
+  msg_ring_mlock(requests);
   worker->requests = requests;
   return ZIX_STATUS_SUCCESS;
 }
@@ -117,25 +114,22 @@ JalvWorker*
 jalv_worker_new(ZixSem* const lock, const bool threaded)
 {
   JalvWorker* const worker    = (JalvWorker*)calloc(1, sizeof(JalvWorker));
-  ZixRing* const    responses = zix_ring_new(NULL, MAX_PACKET_SIZE);
-  void* const       response  = calloc(1, MAX_PACKET_SIZE);
+  MSG_RING* const   responses = msg_ring_init(WORKER_RING_SIZE);
 
-  if (worker && responses && response) {
+  if (worker && responses) {
+    msg_ring_mlock(responses);
     worker->threaded  = threaded;
     worker->responses = responses;
-    worker->response  = response;
     worker->lock      = lock;
     worker->exit      = false;
 
-    zix_ring_mlock(responses);
     if (!threaded || !jalv_worker_launch(worker)) {
       return worker;
     }
   }
 
   free(worker);
-  zix_ring_free(responses);
-  free(response);
+  msg_ring_clean(responses);
   return NULL;
 }
 
@@ -166,9 +160,8 @@ jalv_worker_free(JalvWorker* const worker)
 {
   if (worker) {
     jalv_worker_exit(worker);
-    zix_ring_free(worker->requests);
-    zix_ring_free(worker->responses);
-    free(worker->response);
+    msg_ring_clean(worker->requests);
+    msg_ring_clean(worker->responses);
     free(worker);
   }
 }
@@ -205,14 +198,13 @@ jalv_worker_schedule(LV2_Worker_Schedule_Handle handle,
 void
 jalv_worker_emit_responses(JalvWorker* const worker, LV2_Handle lv2_handle)
 {
-  static const uint32_t size_size = (uint32_t)sizeof(uint32_t);
-
   if (worker && worker->responses) {
-    uint32_t size = 0U;
-    while (zix_ring_read(worker->responses, &size, size_size) == size_size) {
-      if (zix_ring_read(worker->responses, worker->response, size) == size) {
-        worker->iface->work_response(lv2_handle, size, worker->response);
-      }
+    // The responses are given to the plugin right from the ring memory
+    uint32_t    size     = 0U;
+    const void* response = NULL;
+    while ((response = msg_ring_peek(worker->responses, &size))) {
+      worker->iface->work_response(lv2_handle, size, response);
+      msg_ring_release(worker->responses);
     }
   }
 }
@@ -1,6 +1,11 @@
 #include "math_funcs.h"
 #include <math.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#if defined(__SSE__) || defined(__x86_64__)
+#include <xmmintrin.h>
+#endif
 
 typedef struct _range_table{
     PARAM_T min_pt; //minimum value in the table
@@ -508,3 +513,40 @@ PARAM_T math_get_from_table_lerp(PARAM_T* table_in, unsigned int len, PARAM_T in
 
     return samp;
 }
+
+void math_denormals_off(void){
+#if defined(__SSE__) || defined(__x86_64__)
+    //bit 15 is flush to zero, bit 6 is denormals are zero
+    _mm_setcsr(_mm_getcsr() | 0x8040);
+#elif defined(__aarch64__)
+    //bit 24 of the fpcr is flush to zero
+    uint64_t fpcr = 0;
+    __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+    fpcr |= (1 << 24);
+    __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr));
+#elif defined(__arm__) && defined(__ARM_FP)
+    //bit 24 of the fpscr is flush to zero
+    uint32_t fpscr = 0;
+    __asm__ __volatile__("vmrs %0, fpscr" : "=r"(fpscr));
+    fpscr |= (1 << 24);
+    __asm__ __volatile__("vmsr fpscr, %0" : : "r"(fpscr));
+#endif
+}
+
+unsigned int math_count_subnormals(const SAMPLE_T* buffer, unsigned int len){
+    if(!buffer)return 0;
+    unsigned int count = 0;
+    //check the bits and not fpclassify, with denormals are zero on (math_denormals_off) fpclassify says the subnormals are zero
+    for(unsigned int i = 0; i < len; i++){
+#if SAMPLE_T_AS_DOUBLE == 1
+	uint64_t bits = 0;
+	memcpy(&bits, &buffer[i], sizeof(bits));
+	if((bits & 0x7ff0000000000000ULL) == 0 && (bits & 0x000fffffffffffffULL) != 0)count += 1;
+#else
+	uint32_t bits = 0;
+	memcpy(&bits, &buffer[i], sizeof(bits));
+	if((bits & 0x7f800000u) == 0 && (bits & 0x007fffffu) != 0)count += 1;
+#endif
+    }
+    return count;
+}
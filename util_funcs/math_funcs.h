@@ -35,3 +35,8 @@ PARAM_T exp_range_ratio(PARAM_T num_items, PARAM_T cur_item);
 PARAM_T freq_add_semitones(PARAM_T freq_in, PARAM_T semitones);
 //get from a table values with linear interpolation between values if index is with a fraction
 PARAM_T math_get_from_table_lerp(PARAM_T* table_in, unsigned int len, PARAM_T index);
+//set flush to zero and denormals are zero (FZ on arm) for the calling thread, so decaying signals become 0 instead of slow subnormal floats
+//call at the start of the [audio-thread] and the dsp worker threads
+void math_denormals_off(void);
+//return how many subnormal values are in the buffer
+unsigned int math_count_subnormals(const SAMPLE_T* buffer, unsigned int len);
@@ -0,0 +1,178 @@
+#include "msg_ring.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+//mlock
+#include <sys/mman.h>
+//atomics library
+#include <stdatomic.h>
+
+//the positions are on their own cache lines so the writer and the reader do not invalidate each others lines
+#define MSG_RING_CACHE_LINE 64
+//the messages start on this alignment, so any struct can be read in place
+#define MSG_RING_ALIGN 8
+//size in the header of a message that tells the reader that the rest of the ring is empty and the next message is at the start
+#define MSG_RING_WRAP UINT32_MAX
+
+//header before each message in the ring
+typedef struct _msg_ring_header{
+    uint32_t size;
+    uint32_t unused;
+}MSG_RING_HEADER;
+
+typedef struct _msg_ring{
+    //the ring memory
+    char* data;
+    //1 if the ring is locked in ram with msg_ring_mlock
+    unsigned int locked;
+    //the size of the ring memory in bytes, always a power of two
+    unsigned int ring_size;
+    //ring_size - 1, to wrap the positions
+    unsigned int mask;
+    //the position of the write head in bytes, only the writer changes it
+    //the positions are not wrapped, the place in the ring memory is position & mask
+    _Alignas(MSG_RING_CACHE_LINE) atomic_uint w_pos;
+    //the read head the writer saw last time, so the writer reads r_pos only when the message looks like it does not fit
+    unsigned int r_pos_cached;
+    //where the header of the reserved message is, and how many bytes were reserved
+    unsigned int reserved_pos;
+    unsigned int reserved_size;
+    //1 if there is a reserved message that is not committed yet
+    unsigned int reserved;
+    //the position of the read head in bytes, only the reader changes it
+    _Alignas(MSG_RING_CACHE_LINE) atomic_uint r_pos;
+    //the write head the reader saw last time, so the reader reads w_pos only when the ring looks empty
+    unsigned int w_pos_cached;
+    //where the header of the peeked message is and how many bytes it takes with the header, 0 if nothing is peeked
+    unsigned int peek_pos;
+    unsigned int peek_len;
+    char pad[MSG_RING_CACHE_LINE - sizeof(atomic_uint) - sizeof(unsigned int) * 3];
+}MSG_RING;
+
+//how many bytes a message of size takes in the ring with its header
+static unsigned int msg_ring_record_len(unsigned int size){
+    unsigned int len = sizeof(MSG_RING_HEADER) + size;
+    return (len + (MSG_RING_ALIGN - 1)) & ~(unsigned int)(MSG_RING_ALIGN - 1);
+}
+
+MSG_RING* msg_ring_init(unsigned int ring_size){
+    unsigned int size = MSG_RING_CACHE_LINE;
+    while(size < ring_size){
+	if(size > (~0U >> 1))return NULL;
+	size <<= 1;
+    }
+    MSG_RING* ret_ring = (MSG_RING*)aligned_alloc(MSG_RING_CACHE_LINE, sizeof(MSG_RING));
+    if(!ret_ring)return NULL;
+    ret_ring->data = (char*)aligned_alloc(MSG_RING_CACHE_LINE, size);
+    if(!ret_ring->data){
+	free(ret_ring);
+	return NULL;
+    }
+    ret_ring->ring_size = size;
+    ret_ring->mask = size - 1;
+    ret_ring->locked = 0;
+    atomic_init(&ret_ring->w_pos, 0U);
+    atomic_init(&ret_ring->r_pos, 0U);
+    ret_ring->r_pos_cached = 0;
+    ret_ring->reserved_pos = 0;
+    ret_ring->reserved_size = 0;
+    ret_ring->reserved = 0;
+    ret_ring->w_pos_cached = 0;
+    ret_ring->peek_pos = 0;
+    ret_ring->peek_len = 0;
+    return ret_ring;
+}
+
+void* msg_ring_reserve(MSG_RING* ring, unsigned int size){
+    if(!ring)return NULL;
+    ring->reserved = 0;
+    //with at most half of the ring a message always fits once the reader catches up, no matter where the write head is
+    if(size > (ring->ring_size / 2) - sizeof(MSG_RING_HEADER))return NULL;
+    unsigned int need = msg_ring_record_len(size);
+    unsigned int w_pos = atomic_load_explicit(&ring->w_pos, memory_order_relaxed);
+    unsigned int start = w_pos & ring->mask;
+    //the message has to be in one piece, so if it does not fit before the end of the ring memory it goes to the start
+    unsigned int skip = 0;
+    if(need > ring->ring_size - start)skip = ring->ring_size - start;
+    if(ring->ring_size - (w_pos - ring->r_pos_cached) < skip + need){
+	ring->r_pos_cached = atomic_load_explicit(&ring->r_pos, memory_order_acquire);
+	if(ring->ring_size - (w_pos - ring->r_pos_cached) < skip + need)return NULL;
+    }
+    //the reader does not see the wrap header until the message after it is committed
+    if(skip > 0){
+	MSG_RING_HEADER* wrap = (MSG_RING_HEADER*)(ring->data + start);
+	wrap->size = MSG_RING_WRAP;
+    }
+    ring->reserved_pos = w_pos + skip;
+    ring->reserved_size = size;
+    ring->reserved = 1;
+    return ring->data + (ring->reserved_pos & ring->mask) + sizeof(MSG_RING_HEADER);
+}
+
+int msg_ring_commit(MSG_RING* ring, unsigned int size){
+    if(!ring)return -1;
+    if(ring->reserved != 1 || size > ring->reserved_size)return -1;
+    MSG_RING_HEADER* header = (MSG_RING_HEADER*)(ring->data + (ring->reserved_pos & ring->mask));
+    header->size = size;
+    ring->reserved = 0;
+    atomic_store_explicit(&ring->w_pos, ring->reserved_pos + msg_ring_record_len(size), memory_order_release);
+    return 1;
+}
+
+int msg_ring_write(MSG_RING* ring, const void* const source, unsigned int size){
+    if(!ring || (!source && size > 0))return -1;
+    void* dest = msg_ring_reserve(ring, size);
+    if(!dest)return 0;
+    if(size > 0)memcpy(dest, source, size);
+    return msg_ring_commit(ring, size);
+}
+
+const void* msg_ring_peek(MSG_RING* ring, unsigned int* size){
+    if(!ring)return NULL;
+    unsigned int r_pos = atomic_load_explicit(&ring->r_pos, memory_order_relaxed);
+    if(ring->w_pos_cached == r_pos){
+	ring->w_pos_cached = atomic_load_explicit(&ring->w_pos, memory_order_acquire);
+	if(ring->w_pos_cached == r_pos)return NULL;
+    }
+    MSG_RING_HEADER* header = (MSG_RING_HEADER*)(ring->data + (r_pos & ring->mask));
+    if(header->size == MSG_RING_WRAP){
+	//a wrap is always followed by a committed message, so the ring is not empty after it
+	r_pos += ring->ring_size - (r_pos & ring->mask);
+	header = (MSG_RING_HEADER*)(ring->data + (r_pos & ring->mask));
+    }
+    ring->peek_pos = r_pos;
+    ring->peek_len = msg_ring_record_len(header->size);
+    if(size)*size = header->size;
+    return (const char*)header + sizeof(MSG_RING_HEADER);
+}
+
+int msg_ring_release(MSG_RING* ring){
+    if(!ring)return -1;
+    if(ring->peek_len == 0)return -1;
+    atomic_store_explicit(&ring->r_pos, ring->peek_pos + ring->peek_len, memory_order_release);
+    ring->peek_len = 0;
+    return 1;
+}
+
+int msg_ring_mlock(MSG_RING* ring){
+    if(!ring)return -1;
+    if(ring->locked)return 0;
+    if(mlock(ring, sizeof(MSG_RING)) != 0)return -1;
+    if(mlock(ring->data, ring->ring_size) != 0){
+	munlock(ring, sizeof(MSG_RING));
+	return -1;
+    }
+    ring->locked = 1;
+    return 0;
+}
+
+void msg_ring_clean(MSG_RING* ring){
+    if(!ring)return;
+    if(ring->locked){
+	munlock(ring->data, ring->ring_size);
+	munlock(ring, sizeof(MSG_RING));
+    }
+    if(ring->data)free(ring->data);
+    free(ring);
+}
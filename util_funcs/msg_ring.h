@@ -0,0 +1,26 @@
+#pragma once
+//ring for messages of different sizes, the writer reserves space for a message, writes it in place and commits it,
+//the reader peeks the message in the ring memory and releases it when done, so the messages are not copied out of the ring
+//the ring is single producer single consumer - only one thread can write and only one thread can read
+typedef struct _msg_ring MSG_RING;
+//initiate (malloc) the msg_ring and return it, on fail returns NULL.
+//ring_size is the size in bytes and is rounded up to a power of two, one message can be at most half of the ring
+MSG_RING* msg_ring_init(unsigned int ring_size);
+//reserve size bytes for the next message, returns where to write the message or NULL if it does not fit right now
+//nothing is sent until msg_ring_commit, a new reserve replaces the last one that was not committed. Use only on the writer thread
+void* msg_ring_reserve(MSG_RING* ring, unsigned int size);
+//send the reserved message to the reader, size can be smaller than the reserved size (for example for strings)
+//returns 1 if the message was sent, -1 if nothing was reserved or size is bigger than the reserved size
+int msg_ring_commit(MSG_RING* ring, unsigned int size);
+//reserve, copy the source and commit, returns 1 if the message was sent and 0 if it did not fit
+int msg_ring_write(MSG_RING* ring, const void* const source, unsigned int size);
+//return the next message in the ring memory and its size to size, NULL if there are no messages
+//the message stays valid until msg_ring_release, peeking again returns the same message. Use only on the reader thread
+const void* msg_ring_peek(MSG_RING* ring, unsigned int* size);
+//give the peeked message back to the writer, returns 1 on success and -1 if there was no peeked message
+int msg_ring_release(MSG_RING* ring);
+//lock the ring struct and its memory in ram, so the audio thread does not page fault on it, returns 0 on success and -1 on fail
+//the ring is unlocked in msg_ring_clean
+int msg_ring_mlock(MSG_RING* ring);
+//clean the msg_ring, free its memory etc.
+void msg_ring_clean(MSG_RING* ring);
@@ -299,6 +299,34 @@ PARAM_T osc_getOutput(OSC_OBJ* osc, PARAM_T phasor, PARAM_T freq, int with_phase
     
 }
 
+void osc_getOutput_stack(OSC_OBJ* osc, PARAM_T* phasors, const PARAM_T* freqs, unsigned int num, PARAM_T phaseOfs, PARAM_T* ret_samples){
+    if(!osc)return;
+    PARAM_T max_freq = 0.0;
+    for(unsigned int i = 0; i < num; i++){
+	if(freqs[i] > max_freq)max_freq = freqs[i];
+    }
+    PARAM_T phaseInc = max_freq / osc->sampleRate;
+    int waveTableIdx = 0;
+    while((phaseInc >= osc->waveTables[waveTableIdx].topFreq) && (waveTableIdx < (osc->numWaveTables -1))){
+	++waveTableIdx;
+    }
+    OSC_WAVETABLE* waveTable = &(osc->waveTables[waveTableIdx]);
+    PARAM_T* table = waveTable->waveTable;
+    int len = waveTable->waveTableLen;
+    PARAM_T inc_mult = 1.0 / osc->sampleRate;
+    //read the samples
+    for(unsigned int i = 0; i < num; i++){
+	PARAM_T read_ph = phasors[i] + phaseOfs;
+	read_ph -= floor(read_ph);
+	ret_samples[i] = math_get_from_table_lerp(table, len, read_ph * len);
+    }
+    //advance the phasors, kept in a separate loop without branches so it can be vectorized
+    for(unsigned int i = 0; i < num; i++){
+	PARAM_T ph = phasors[i] + freqs[i] * inc_mult;
+	phasors[i] = ph - floor(ph);
+    }
+}
+
 void osc_clean_osc_wavetable(OSC_OBJ* osc){
     if(!osc)return;
     for(int idx = 0; idx < WAVETABLE_SLOTS; idx++){
@@ -7,5 +7,9 @@ OSC_OBJ* osc_init_osc_wavetable(int table_type, PARAM_T esr);
 void osc_updatePhase(OSC_OBJ* osc, PARAM_T* phasor, PARAM_T freq);
 //get a single sample from the wavetable, lineary interpolated
 PARAM_T osc_getOutput(OSC_OBJ* osc, PARAM_T phasor, PARAM_T freq, int with_phaseOfs, PARAM_T phaseOfs);
+//get samples for num phasors that play the same table at different frequencies (for example unison voices)
+//the wavetable is chosen once from the highest frequency, phaseOfs is added to each phasor when reading (phase modulation)
+//the samples are written to ret_samples and the phasors are advanced by their frequencies
+void osc_getOutput_stack(OSC_OBJ* osc, PARAM_T* phasors, const PARAM_T* freqs, unsigned int num, PARAM_T phaseOfs, PARAM_T* ret_samples);
 //clean the osc struct
 void osc_clean_osc_wavetable(OSC_OBJ* osc);
@@ -6,83 +6,144 @@
 //atomics library
 #include <stdatomic.h>
 
+//the positions are on their own cache lines so the writer and the reader do not invalidate each others lines
+#define RING_CACHE_LINE 64
+
 typedef struct _ring_fifo_buffer{
     //array of void* data
     char* data;
     //size of single data member in the data array
-    atomic_uint single_data_size;
-    //the size of the data array (number of members of void data)
-    atomic_uint data_array_size;
-    //the atomic tracker of items, write head will increase this and read head will decrease
-    atomic_uint items;
-    //the position of the write head
-    unsigned int w_pos;
-    //the position of the read head
-    unsigned int r_pos;
+    unsigned int single_data_size;
+    //the size of the data array (number of members of void data), always a power of two
+    unsigned int data_array_size;
+    //data_array_size - 1, to wrap the positions
+    unsigned int mask;
+    //the position of the write head, only the writer changes it
+    //the positions are not wrapped, the index in the data array is position & mask
+    _Alignas(RING_CACHE_LINE) atomic_uint w_pos;
+    //the read head the writer saw last time, so the writer reads r_pos only when the ring looks full
+    unsigned int r_pos_cached;
+    //the position of the read head, only the reader changes it
+    _Alignas(RING_CACHE_LINE) atomic_uint r_pos;
+    //the write head the reader saw last time, so the reader reads w_pos only when the ring looks empty
+    unsigned int w_pos_cached;
+    char pad[RING_CACHE_LINE - sizeof(atomic_uint) - sizeof(unsigned int)];
 }RING_BUFFER;
 
 RING_BUFFER* ring_buffer_init(unsigned int single_data_size, unsigned int data_array_size){
+    if(single_data_size == 0 || data_array_size == 0)return NULL;
+    unsigned int array_size = 1;
+    while(array_size < data_array_size){
+	if(array_size > (~0U >> 1))return NULL;
+	array_size <<= 1;
+    }
     RING_BUFFER* ret_ring = NULL;
-    ret_ring = (RING_BUFFER*)malloc(sizeof(RING_BUFFER));
+    ret_ring = (RING_BUFFER*)aligned_alloc(RING_CACHE_LINE, sizeof(RING_BUFFER));
     if(ret_ring){
-	ret_ring->data = (char*)malloc(single_data_size * data_array_size);
+	ret_ring->data = (char*)malloc((size_t)single_data_size * array_size);
 	if(!ret_ring->data){
 	    free(ret_ring);
 	    return NULL;
 	}
-	atomic_init(&ret_ring->single_data_size, (unsigned int)single_data_size);
-	atomic_init(&ret_ring->data_array_size, (unsigned int)data_array_size);
-	atomic_init(&ret_ring->items, 0U);
-	ret_ring->w_pos = 0;
-	ret_ring->r_pos = 0;
+	ret_ring->single_data_size = single_data_size;
+	ret_ring->data_array_size = array_size;
+	ret_ring->mask = array_size - 1;
+	atomic_init(&ret_ring->w_pos, 0U);
+	atomic_init(&ret_ring->r_pos, 0U);
+	ret_ring->r_pos_cached = 0;
+	ret_ring->w_pos_cached = 0;
     }
     
     return ret_ring;
 }
 
+//how many items the reader can read, reads the w_pos of the writer only if the cached one shows less than wanted
+static unsigned int ring_buffer_readable(RING_BUFFER* ring_buf, unsigned int r_pos, unsigned int wanted){
+    unsigned int readable = ring_buf->w_pos_cached - r_pos;
+    if(readable < wanted){
+	ring_buf->w_pos_cached = atomic_load_explicit(&ring_buf->w_pos, memory_order_acquire);
+	readable = ring_buf->w_pos_cached - r_pos;
+    }
+    return readable;
+}
+//how many items the writer can write, reads the r_pos of the reader only if the cached one shows less than wanted
+static unsigned int ring_buffer_writable(RING_BUFFER* ring_buf, unsigned int w_pos, unsigned int wanted){
+    unsigned int writable = ring_buf->data_array_size - (w_pos - ring_buf->r_pos_cached);
+    if(writable < wanted){
+	ring_buf->r_pos_cached = atomic_load_explicit(&ring_buf->r_pos, memory_order_acquire);
+	writable = ring_buf->data_array_size - (w_pos - ring_buf->r_pos_cached);
+    }
+    return writable;
+}
+
 int ring_buffer_read(RING_BUFFER* ring_buf, void* const dest, unsigned int dest_size){
-    unsigned int single_data_size = atomic_load(&ring_buf->single_data_size);
+    if(!ring_buf)return -1;
+    unsigned int single_data_size = ring_buf->single_data_size;
     //the destination data size does not match with the single data size in the data array
     if(single_data_size != dest_size)return -3;
-    unsigned int data_array_size = atomic_load(&ring_buf->data_array_size);
-    if(single_data_size<=0 || data_array_size<=0)return -1;
+    unsigned int r_pos = atomic_load_explicit(&ring_buf->r_pos, memory_order_relaxed);
     //empty data array
-    if(atomic_load(&ring_buf->items)<=0)return 0;
-    //overflow, how the hell this happened?
-    if(ring_buf->r_pos >= data_array_size)return -2;
+    if(ring_buffer_readable(ring_buf, r_pos, 1) == 0)return 0;
     
-    memcpy(dest, ring_buf->data + (ring_buf->r_pos * single_data_size), single_data_size);
-    ring_buf->r_pos += 1;
-    if(ring_buf->r_pos == data_array_size){
-	ring_buf->r_pos = 0;
-    }
-    
-    atomic_fetch_sub(&ring_buf->items, 1);
+    memcpy(dest, ring_buf->data + ((size_t)(r_pos & ring_buf->mask) * single_data_size), single_data_size);
+    atomic_store_explicit(&ring_buf->r_pos, r_pos + 1, memory_order_release);
     return 1;
 }
 
 int ring_buffer_write(RING_BUFFER* ring_buf, const void* const source, unsigned int source_size){
-    unsigned int single_data_size = atomic_load(&ring_buf->single_data_size);
+    if(!ring_buf)return -1;
+    unsigned int single_data_size = ring_buf->single_data_size;
     //the source data size does not match with the single data size in the data array
-    if(single_data_size != source_size)return -3;    
-    unsigned int data_array_size = atomic_load(&ring_buf->data_array_size);
-    if(single_data_size<=0 || data_array_size<=0)return -1;
+    if(single_data_size != source_size)return -3;
+    unsigned int w_pos = atomic_load_explicit(&ring_buf->w_pos, memory_order_relaxed);
     //full data array, return with exit code 0
-    if(atomic_load(&ring_buf->items) >= data_array_size)return 0;
-    memcpy(ring_buf->data + (ring_buf->w_pos * single_data_size), source, single_data_size);
-    ring_buf->w_pos += 1;
-    if(ring_buf->w_pos == data_array_size){
-	ring_buf->w_pos = 0;
-    }
-    atomic_fetch_add(&ring_buf->items, 1);
+    if(ring_buffer_writable(ring_buf, w_pos, 1) == 0)return 0;
+    memcpy(ring_buf->data + ((size_t)(w_pos & ring_buf->mask) * single_data_size), source, single_data_size);
+    atomic_store_explicit(&ring_buf->w_pos, w_pos + 1, memory_order_release);
     return 1;
 }
 
+int ring_buffer_read_batch(RING_BUFFER* ring_buf, void* const dest, unsigned int item_size, unsigned int max_items){
+    if(!ring_buf || !dest)return -1;
+    unsigned int single_data_size = ring_buf->single_data_size;
+    if(single_data_size != item_size)return -3;
+    unsigned int r_pos = atomic_load_explicit(&ring_buf->r_pos, memory_order_relaxed);
+    unsigned int items = ring_buffer_readable(ring_buf, r_pos, max_items);
+    if(items > max_items)items = max_items;
+    if(items == 0)return 0;
+    //the items can wrap around the end of the data array, then they are copied in two parts
+    unsigned int start = r_pos & ring_buf->mask;
+    unsigned int first = ring_buf->data_array_size - start;
+    if(first > items)first = items;
+    memcpy(dest, ring_buf->data + ((size_t)start * single_data_size), (size_t)first * single_data_size);
+    if(items > first)memcpy((char*)dest + ((size_t)first * single_data_size), ring_buf->data, (size_t)(items - first) * single_data_size);
+    atomic_store_explicit(&ring_buf->r_pos, r_pos + items, memory_order_release);
+    return (int)items;
+}
+
+int ring_buffer_write_batch(RING_BUFFER* ring_buf, const void* const source, unsigned int item_size, unsigned int num_items){
+    if(!ring_buf || !source)return -1;
+    unsigned int single_data_size = ring_buf->single_data_size;
+    if(single_data_size != item_size)return -3;
+    unsigned int w_pos = atomic_load_explicit(&ring_buf->w_pos, memory_order_relaxed);
+    unsigned int items = ring_buffer_writable(ring_buf, w_pos, num_items);
+    if(items > num_items)items = num_items;
+    if(items == 0)return 0;
+    unsigned int start = w_pos & ring_buf->mask;
+    unsigned int first = ring_buf->data_array_size - start;
+    if(first > items)first = items;
+    memcpy(ring_buf->data + ((size_t)start * single_data_size), source, (size_t)first * single_data_size);
+    if(items > first)memcpy(ring_buf->data, (const char*)source + ((size_t)first * single_data_size), (size_t)(items - first) * single_data_size);
+    atomic_store_explicit(&ring_buf->w_pos, w_pos + items, memory_order_release);
+    return (int)items;
+}
+
 unsigned int ring_buffer_return_items(RING_BUFFER* ring_buf){
-    unsigned int items = 0;
-    //items = atomic_load_explicit(&ring_buf->items, memory_order_acquire);
-    items = atomic_load(&ring_buf->items);
-    return items;
+    if(!ring_buf)return 0;
+    //read head first, so the count is never more than what was written
+    unsigned int r_pos = atomic_load_explicit(&ring_buf->r_pos, memory_order_acquire);
+    unsigned int w_pos = atomic_load_explicit(&ring_buf->w_pos, memory_order_acquire);
+    return w_pos - r_pos;
 }
 
 void ring_buffer_clean(RING_BUFFER* ring_buffer){
@@ -1,8 +1,9 @@
 #pragma once
-//the ring buffer sturct that holds the void data, the atomic count etc.
+//the ring buffer sturct that holds the void data, the read and write positions etc.
+//the ring is single producer single consumer - only one thread can write and only one thread can read
 typedef struct _ring_fifo_buffer RING_BUFFER;
 //initiate (malloc) the ring_buffer and return it, on fail returns NULL.
-//data_array_size.
+//data_array_size is rounded up to a power of two, so the ring can hold at least that many items.
 RING_BUFFER* ring_buffer_init(unsigned int single_data_size, unsigned int data_array_size);
 //read single item from the ring_buffer data array, its important that the destination object is the same
 //size as the single_data_size given to the ring_buffer_init function, this is why the user has to send
@@ -12,6 +13,12 @@ int ring_buffer_read(RING_BUFFER* ring_buf, void* const dest, unsigned int dest_
 //size as the single_data_size given to the ring_buffer_init function, this is why the user has to send
 //the source data size in the source_size var
 int ring_buffer_write(RING_BUFFER* ring_buf, const void* const source, unsigned int source_size);
+//read up to max_items items to the dest array with at most two memcpys, item_size has to be the single_data_size
+//returns how many items were read (0 if the ring is empty) or -3 if the item_size does not match
+int ring_buffer_read_batch(RING_BUFFER* ring_buf, void* const dest, unsigned int item_size, unsigned int max_items);
+//write up to num_items items from the source array with at most two memcpys, item_size has to be the single_data_size
+//returns how many items were written, it can be less than num_items if the ring is full, or -3 if the item_size does not match
+int ring_buffer_write_batch(RING_BUFFER* ring_buf, const void* const source, unsigned int item_size, unsigned int num_items);
 //return the number how many items are in the ring_buffer data array at the moment
 unsigned int ring_buffer_return_items(RING_BUFFER* ring_buf);
 //clean the ring buffer, free its memory etc.
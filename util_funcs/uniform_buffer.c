@@ -57,7 +57,8 @@ int ub_push(UB_EVENT* ub_ev, const void* const source, uint32_t source_size){
     uint32_t last_idx = 0;
     if(ub_ev->items > 0)last_idx = ub_ev->items - 1;
 
-    uint32_t offset = ub_ev->item_addr[last_idx];
+    //the items end at current_size, the last item_addr is not the end if the items were sorted with ub_sort
+    uint32_t offset = ub_ev->current_size;
     if(offset == 0 && ub_ev->items > 0)return -1;
 
     uint32_t idx = 0;
@@ -98,6 +99,26 @@ void* ub_item_get(UB_EVENT* ub_ev, uint32_t idx){
     return ub_ev->event_list + offset;
 }
 
+void ub_sort(UB_EVENT* ub_ev, uint32_t(*item_key)(const void* item)){
+    if(!ub_ev)return;
+    if(!item_key)return;
+    for(uint32_t i = 1; i < ub_ev->items; i++){
+	uint32_t cur_addr = ub_ev->item_addr[i];
+	uint32_t cur_size = ub_ev->item_sizes[i];
+	uint32_t cur_key = item_key(ub_ev->event_list + (cur_addr - cur_size));
+	uint32_t j = i;
+	while(j > 0){
+	    uint32_t prev_key = item_key(ub_ev->event_list + (ub_ev->item_addr[j - 1] - ub_ev->item_sizes[j - 1]));
+	    if(prev_key <= cur_key)break;
+	    ub_ev->item_addr[j] = ub_ev->item_addr[j - 1];
+	    ub_ev->item_sizes[j] = ub_ev->item_sizes[j - 1];
+	    j -= 1;
+	}
+	ub_ev->item_addr[j] = cur_addr;
+	ub_ev->item_sizes[j] = cur_size;
+    }
+}
+
 void ub_list_reset(UB_EVENT* ub_ev){
     if(!ub_ev)return;
 
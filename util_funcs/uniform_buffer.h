@@ -16,6 +16,9 @@ uint32_t ub_item_get_size(UB_EVENT* ub_ev, uint32_t idx);
 uint32_t ub_size(UB_EVENT* ub_ev);
 //get the idx item address as void* from ub_ev->event_list
 void* ub_item_get(UB_EVENT* ub_ev, uint32_t idx);
+//stable sort of the items by the item_key of each item, only the item order changes, the items are not moved in the event_list
+//insertion sort, so its cheap when the items are pushed almost in order
+void ub_sort(UB_EVENT* ub_ev, uint32_t(*item_key)(const void* item));
 //empty the ub_ev->event_list and other arrays, ub_ev->items and ub_ev->current_size becomes 0
 //does not free the memory, just a reset before writing to and empty ub_ev->event_list 
 void ub_list_reset(UB_EVENT* ub_ev);